@@ -1,4 +1,7 @@
 CC = ccache clang -c -MMD
 CFLAGS = -O2 -pipe -fno-exceptions -Wall -W -Qunused-arguments
+LD = clang++
+AR = ar
+LIBS = -lexpat -lz -lpthread
 
 MAKE = make
@@ -21,6 +21,7 @@
 #include <JniEnvelope.h>
 #include <ZLFileImage.h>
 #include <FileEncryptionInfo.h>
+#include <ZLTextSearchIndex.h>
 
 #include "zlibrary/core/filesystem/ZLAndroidFSManager.h"
 
@@ -112,6 +113,36 @@ JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin
 	return 0;
 }
 
+// box[0] receives the cover image and box[1] the annotation, if any
+extern "C"
+JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin_readAllMetainfoNative(JNIEnv* env, jobject thiz, jobject javaBook, jobjectArray box) {
+	shared_ptr<FormatPlugin> plugin = findCppPlugin(thiz);
+	if (plugin.isNull()) {
+		return 1;
+	}
+
+	shared_ptr<Book> book = AndroidUtil::bookFromJavaBook(env, javaBook);
+
+	shared_ptr<const ZLImage> image;
+	std::string annotation;
+	if (!plugin->readAllMetainfo(*book, image, annotation)) {
+		return 2;
+	}
+
+	fillMetaInfo(env, javaBook, *book);
+	if (!image.isNull()) {
+		jobject javaImage = AndroidUtil::createJavaImage(env, (const ZLFileImage&)*image);
+		env->SetObjectArrayElement(box, 0, javaImage);
+		env->DeleteLocalRef(javaImage);
+	}
+	if (!annotation.empty()) {
+		jstring javaAnnotation = AndroidUtil::createJavaString(env, annotation);
+		env->SetObjectArrayElement(box, 1, javaAnnotation);
+		env->DeleteLocalRef(javaAnnotation);
+	}
+	return 0;
+}
+
 extern "C"
 JNIEXPORT jobject JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin_readEncryptionInfosNative(JNIEnv* env, jobject thiz, jobject javaBook) {
 	shared_ptr<FormatPlugin> plugin = findCppPlugin(thiz);
@@ -164,8 +195,7 @@ JNIEXPORT void JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin
 	fillLanguageAndEncoding(env, javaBook, *book);
 }
 
-extern "C"
-JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin_readModelNative(JNIEnv* env, jobject thiz, jobject javaBook, jobject fileHandler) {
+static jint readModel(JNIEnv* env, jobject thiz, jobject javaBook, jobject fileHandler, std::size_t checkpointInterval, JSONOutput::Format format) {
 	ZLAndroidFSManager::setFileHandler(fileHandler);
 
 	shared_ptr<FormatPlugin> plugin = findCppPlugin(thiz);
@@ -179,6 +209,16 @@ JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin
 
 	shared_ptr<Book> book = AndroidUtil::bookFromJavaBook(env, javaBook);
 	shared_ptr<BookModel> model = new BookModel(book, cacheDir);
+	PluginCollection &collection = PluginCollection::Instance();
+	if (collection.isSearchIndexEnabled()) {
+		model->enableSearchIndex();
+	}
+	if (collection.areStyleReferencesEnabled()) {
+		model->enableStyleReferences();
+	}
+	if (checkpointInterval > 0) {
+		model->setCheckpointListener(new ModelCheckpointWriter(cacheDir, format), checkpointInterval);
+	}
 	if (!plugin->readModel(*model)) {
 		return 2;
 	}
@@ -186,7 +226,7 @@ JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin
 		return 3;
 	}
 
-	ModelWriter writer(cacheDir);
+	ModelWriter writer(cacheDir, format);
 	writer.writeModelInfo(*model);
 
 	ZLAndroidFSManager::setFileHandler(0);
@@ -194,6 +234,41 @@ JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin
 	return 0;
 }
 
+extern "C"
+JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin_readModelNative(JNIEnv* env, jobject thiz, jobject javaBook, jobject fileHandler) {
+	return readModel(env, thiz, javaBook, fileHandler, 0, JSONOutput::TEXT);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin_readModelProgressivelyNative(JNIEnv* env, jobject thiz, jobject javaBook, jobject fileHandler, jint checkpointInterval) {
+	return readModel(env, thiz, javaBook, fileHandler, std::max(checkpointInterval, 1), JSONOutput::TEXT);
+}
+
+// checkpointInterval == 0 disables checkpoints; binaryModelInfo selects CBOR for MODELS and TOC
+extern "C"
+JNIEXPORT jint JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin_readModelWithOptionsNative(JNIEnv* env, jobject thiz, jobject javaBook, jobject fileHandler, jint checkpointInterval, jboolean binaryModelInfo) {
+	return readModel(
+		env, thiz, javaBook, fileHandler,
+		std::max(checkpointInterval, 0),
+		binaryModelInfo ? JSONOutput::BINARY : JSONOutput::TEXT
+	);
+}
+
+// indexPath is the file named by "srch" in MODELS; returns (paragraph, offset, length) triples
+extern "C"
+JNIEXPORT jintArray JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin_searchNative(JNIEnv* env, jobject thiz, jstring indexPath, jstring text) {
+	const ZLTextSearchIndex index(AndroidUtil::fromJavaString(env, indexPath));
+	const std::vector<ZLTextMark> marks = index.search(AndroidUtil::fromJavaString(env, text));
+	std::vector<jint> data;
+	data.reserve(3 * marks.size());
+	for (std::vector<ZLTextMark>::const_iterator it = marks.begin(); it != marks.end(); ++it) {
+		data.push_back(it->ParagraphIndex);
+		data.push_back(it->Offset);
+		data.push_back(it->Length);
+	}
+	return AndroidUtil::createJavaIntArray(env, data);
+}
+
 extern "C"
 JNIEXPORT jstring JNICALL Java_org_geometerplus_fbreader_formats_NativeFormatPlugin_readAnnotationNative(JNIEnv* env, jobject thiz, jobject file) {
 	shared_ptr<FormatPlugin> plugin = findCppPlugin(thiz);
@@ -19,6 +19,8 @@
 
 #include <vector>
 
+#include <ZLFile.h>
+
 #include <AndroidUtil.h>
 #include <JniEnvelope.h>
 
@@ -42,6 +44,33 @@ JNIEXPORT jobjectArray JNICALL Java_org_geometerplus_fbreader_formats_PluginColl
 	return javaPlugins;
 }
 
+extern "C"
+JNIEXPORT jstring JNICALL Java_org_geometerplus_fbreader_formats_PluginCollection_nativeFileTypeByContent(JNIEnv* env, jobject thiz, jstring path) {
+	const ZLFile file(AndroidUtil::fromJavaString(env, path));
+	const std::string fileType = PluginCollection::Instance().fileTypeByContent(file);
+	return fileType.empty() ? 0 : AndroidUtil::createJavaString(env, fileType);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_org_geometerplus_fbreader_formats_PluginCollection_setStyleReferencesEnabled(JNIEnv* env, jobject thiz, jboolean enabled) {
+	PluginCollection::Instance().setStyleReferencesEnabled(enabled);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_org_geometerplus_fbreader_formats_PluginCollection_setSearchIndexEnabled(JNIEnv* env, jobject thiz, jboolean enabled) {
+	PluginCollection::Instance().setSearchIndexEnabled(enabled);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_org_geometerplus_fbreader_formats_PluginCollection_setLoadingThreadsNumber(JNIEnv* env, jobject thiz, jint number) {
+	PluginCollection::Instance().setLoadingThreadsNumber(number > 0 ? number : 1);
+}
+
+extern "C"
+JNIEXPORT void JNICALL Java_org_geometerplus_fbreader_formats_PluginCollection_setLanguageDetectionBudget(JNIEnv* env, jobject thiz, jint budget) {
+	PluginCollection::Instance().setLanguageDetectionBudget(budget > 0 ? budget : 0);
+}
+
 extern "C"
 JNIEXPORT void JNICALL Java_org_geometerplus_fbreader_formats_PluginCollection_free(JNIEnv* env, jobject thiz) {
 	PluginCollection::deleteInstance();
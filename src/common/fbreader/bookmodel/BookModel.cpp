@@ -19,6 +19,7 @@
 
 #include <ZLImage.h>
 #include <ZLFile.h>
+#include <ZLTextSearchIndex.h>
 
 #include "BookModel.h"
 #include "BookReader.h"
@@ -26,7 +27,7 @@
 #include "../formats/FormatPlugin.h"
 #include "../library/Book.h"
 
-BookModel::BookModel(const shared_ptr<Book> book, const std::string &cacheDir) : CacheDir(cacheDir), myBook(book) {
+BookModel::BookModel(const shared_ptr<Book> book, const std::string &cacheDir) : CacheDir(cacheDir), myBook(book), myCheckpointInterval(0), myStyleReferencesEnabled(false) {
 	myBookTextModel = new ZLTextPlainModel(std::string(), book->language(), 131072, CacheDir, "ncache", myFontManager);
 	myContentsTree = new ContentsTree();
 	/*shared_ptr<FormatPlugin> plugin = PluginCollection::Instance().plugin(book->file(), false);
@@ -39,13 +40,56 @@ void BookModel::setHyperlinkMatcher(shared_ptr<HyperlinkMatcher> matcher) {
 	myHyperlinkMatcher = matcher;
 }
 
+void BookModel::enableSearchIndex() {
+	myBookTextModel->setSearchIndexer(new ZLTextSearchIndexer());
+}
+
+void BookModel::enableStyleReferences() {
+	myStyleReferencesEnabled = true;
+	myBookTextModel->enableStyleReferences();
+}
+
+void BookModel::setCheckpointListener(shared_ptr<CheckpointListener> listener, std::size_t paragraphsInterval) {
+	myCheckpointListener = listener;
+	myCheckpointInterval = std::max(paragraphsInterval, (std::size_t)1);
+}
+
 BookModel::Label BookModel::label(const std::string &id) const {
 	if (!myHyperlinkMatcher.isNull()) {
 		return myHyperlinkMatcher->match(myInternalHyperlinks, id);
 	}
 
-	std::map<std::string,Label>::const_iterator it = myInternalHyperlinks.find(id);
-	return (it != myInternalHyperlinks.end()) ? it->second : Label(0, -1);
+	const std::size_t labelId = myInternalHyperlinks.labelId(id);
+	return (labelId != ZLStringPool::NOT_FOUND) ? myInternalHyperlinks.label(labelId) : Label(0, -1);
+}
+
+std::size_t BookModel::Footnotes::add(const std::string &id) {
+	const std::size_t index = myIds.intern(id);
+	if (index == myRanges.size()) {
+		myRanges.push_back(std::vector<Range>());
+		myParagraphsNumbers.push_back(0);
+	}
+	return index;
+}
+
+void BookModel::Footnotes::addParagraph(std::size_t index) {
+	const std::size_t paragraph = myModel->paragraphsNumber() - 1;
+	std::vector<Range> &ranges = myRanges[index];
+	if (!ranges.empty() && ranges.back().End == paragraph) {
+		++ranges.back().End;
+	} else {
+		ranges.push_back(Range(paragraph));
+	}
+	++myParagraphsNumbers[index];
+}
+
+bool BookModel::LabelTable::add(const std::string &name, const Label &label) {
+	const std::size_t labelId = myNames.intern(name);
+	if (labelId < myLabels.size()) {
+		return false;
+	}
+	myLabels.push_back(label);
+	return true;
 }
 
 const shared_ptr<Book> BookModel::book() const {
@@ -58,10 +102,10 @@ bool BookModel::flush() {
 		return false;
 	}
 
-	std::map<std::string,shared_ptr<ZLTextModel> >::const_iterator it = myFootnotes.begin();
-	for (; it != myFootnotes.end(); ++it) {
-		it->second->flush();
-		if (it->second->allocator().failed()) {
+	shared_ptr<ZLTextModel> footnotesModel = myFootnotes.model();
+	if (!footnotesModel.isNull()) {
+		footnotesModel->flush();
+		if (footnotesModel->allocator().failed()) {
 			return false;
 		}
 	}
@@ -24,6 +24,7 @@
 #include <vector>
 #include <string>
 
+#include <ZLStringPool.h>
 #include <ZLTextModel.h>
 #include <ZLTextParagraph.h>
 #include <FontManager.h>
@@ -52,10 +53,69 @@ class BookModel {
 
 public:
 	struct Label {
-		Label(shared_ptr<ZLTextModel> model, int paragraphNumber) : Model(model), ParagraphNumber(paragraphNumber) {}
+		Label(shared_ptr<ZLTextModel> model, int paragraphNumber) : Model(model), Footnote(-1), ParagraphNumber(paragraphNumber) {}
+		// a label inside a footnote; paragraphNumber is counted from the footnote start
+		Label(shared_ptr<ZLTextModel> model, int footnote, int paragraphNumber) : Model(model), Footnote(footnote), ParagraphNumber(paragraphNumber) {}
 
-		const shared_ptr<ZLTextModel> Model;
-		const int ParagraphNumber;
+		shared_ptr<ZLTextModel> Model;
+		int Footnote;
+		int ParagraphNumber;
+	};
+
+	// All the footnotes are stored in one text model, created on the first
+	// footnote.  A footnote is a list of paragraph ranges of that model;
+	// it is a single range unless the footnote was left and reopened.
+	class Footnotes {
+
+	public:
+		struct Range {
+			Range(std::size_t start) : Start(start), End(start + 1) {}
+
+			std::size_t Start;
+			std::size_t End;
+		};
+
+	public:
+		shared_ptr<ZLTextModel> model() const;
+
+		std::size_t size() const;
+		const std::string &id(std::size_t index) const;
+		// ZLStringPool::NOT_FOUND if there is no such footnote
+		std::size_t index(const std::string &id) const;
+
+		const std::vector<Range> &ranges(std::size_t index) const;
+		std::size_t paragraphsNumber(std::size_t index) const;
+
+	private:
+		std::size_t add(const std::string &id);
+		// registers the last paragraph of model() as a paragraph of the footnote
+		void addParagraph(std::size_t index);
+
+	private:
+		shared_ptr<ZLTextModel> myModel;
+		ZLStringPool myIds;
+		std::vector<std::vector<Range> > myRanges;
+		std::vector<std::size_t> myParagraphsNumbers;
+
+	friend class BookReader;
+	};
+
+	// label names are interned, a label id is the index of the name in the table
+	class LabelTable {
+
+	public:
+		// the first definition of a label wins; returns false if the label is already defined
+		bool add(const std::string &name, const Label &label);
+		// ZLStringPool::NOT_FOUND if there is no such label
+		std::size_t labelId(const std::string &name) const;
+
+		std::size_t size() const;
+		const std::string &name(std::size_t labelId) const;
+		const Label &label(std::size_t labelId) const;
+
+	private:
+		ZLStringPool myNames;
+		std::vector<Label> myLabels;
 	};
 
 public:
@@ -63,20 +123,36 @@ public:
 
 	public:
 		virtual ~HyperlinkMatcher();
-		virtual Label match(const std::map<std::string,Label> &lMap, const std::string &id) const = 0;
+		virtual Label match(const LabelTable &labels, const std::string &id) const = 0;
+	};
+
+	class CheckpointListener {
+
+	public:
+		virtual ~CheckpointListener();
+		// called when all the text models are flushed and have no open paragraphs
+		virtual void onCheckpoint(const BookModel &model) = 0;
 	};
 
 public:
 	BookModel(const shared_ptr<Book> book, const std::string &cacheDir);
 
 	void setHyperlinkMatcher(shared_ptr<HyperlinkMatcher> matcher);
+	// must be called before the model is filled
+	void enableSearchIndex();
+	// must be called before the model is filled; see ZLTextModel::enableStyleReferences
+	void enableStyleReferences();
+	// the first checkpoint is made after the first section or after
+	// paragraphsInterval paragraphs; later checkpoints are made each time
+	// the main text model doubles in size, so publishing stays linear
+	void setCheckpointListener(shared_ptr<CheckpointListener> listener, std::size_t paragraphsInterval);
 
 	shared_ptr<ZLTextModel> bookTextModel() const;
 	shared_ptr<ContentsTree> contentsTree() const;
-	const std::map<std::string,shared_ptr<ZLTextModel> > &footnotes() const;
+	const Footnotes &footnotes() const;
 
 	Label label(const std::string &id) const;
-	const std::map<std::string,Label> &internalHyperlinks() const;
+	const LabelTable &internalHyperlinks() const;
 	const std::map<std::string,shared_ptr<const ZLImage> > &images() const;
 
 	const shared_ptr<Book> book() const;
@@ -92,9 +168,12 @@ private:
 	const shared_ptr<Book> myBook;
 	shared_ptr<ZLTextModel> myBookTextModel;
 	shared_ptr<ContentsTree> myContentsTree;
-	std::map<std::string,shared_ptr<ZLTextModel> > myFootnotes;
-	std::map<std::string,Label> myInternalHyperlinks;
+	Footnotes myFootnotes;
+	LabelTable myInternalHyperlinks;
 	shared_ptr<HyperlinkMatcher> myHyperlinkMatcher;
+	shared_ptr<CheckpointListener> myCheckpointListener;
+	std::size_t myCheckpointInterval;
+	bool myStyleReferencesEnabled;
 	FontManager myFontManager;
 	std::map<std::string,shared_ptr<const ZLImage> > myImages;
 
@@ -103,11 +182,23 @@ friend class BookReader;
 
 inline shared_ptr<ZLTextModel> BookModel::bookTextModel() const { return myBookTextModel; }
 inline shared_ptr<ContentsTree> BookModel::contentsTree() const { return myContentsTree; }
-inline const std::map<std::string,shared_ptr<ZLTextModel> > &BookModel::footnotes() const { return myFootnotes; }
-inline const std::map<std::string,BookModel::Label> &BookModel::internalHyperlinks() const { return myInternalHyperlinks; }
+inline const BookModel::Footnotes &BookModel::footnotes() const { return myFootnotes; }
+inline const BookModel::LabelTable &BookModel::internalHyperlinks() const { return myInternalHyperlinks; }
 inline const std::map<std::string,shared_ptr<const ZLImage> > &BookModel::images() const { return myImages; }
 inline const FontManager &BookModel::fontManager() const { return myFontManager; }
 
+inline std::size_t BookModel::LabelTable::labelId(const std::string &name) const { return myNames.find(name); }
+inline std::size_t BookModel::LabelTable::size() const { return myLabels.size(); }
+inline const std::string &BookModel::LabelTable::name(std::size_t labelId) const { return myNames.string(labelId); }
+inline const BookModel::Label &BookModel::LabelTable::label(std::size_t labelId) const { return myLabels[labelId]; }
+
+inline shared_ptr<ZLTextModel> BookModel::Footnotes::model() const { return myModel; }
+inline std::size_t BookModel::Footnotes::size() const { return myRanges.size(); }
+inline const std::string &BookModel::Footnotes::id(std::size_t index) const { return myIds.string(index); }
+inline std::size_t BookModel::Footnotes::index(const std::string &id) const { return myIds.find(id); }
+inline const std::vector<BookModel::Footnotes::Range> &BookModel::Footnotes::ranges(std::size_t index) const { return myRanges[index]; }
+inline std::size_t BookModel::Footnotes::paragraphsNumber(std::size_t index) const { return myParagraphsNumbers[index]; }
+
 inline ContentsTree::ContentsTree() : myReference(-1) {}
 inline ContentsTree::ContentsTree(ContentsTree &parent, int reference) : myReference(reference) {
 	parent.myChildren.push_back(this);
@@ -121,5 +212,6 @@ inline int ContentsTree::reference() const { return myReference; }
 inline const std::vector<shared_ptr<ContentsTree> > &ContentsTree::children() const { return myChildren; }
 
 inline BookModel::HyperlinkMatcher::~HyperlinkMatcher() {}
+inline BookModel::CheckpointListener::~CheckpointListener() {}
 
 #endif /* __BOOKMODEL_H__ */
@@ -31,45 +31,63 @@
 
 BookReader::BookReader(BookModel &model) : myModel(model) {
 	myCurrentTextModel = 0;
+	myCurrentModelSlot = -1;
+	myCurrentFootnote = ZLStringPool::NOT_FOUND;
+	myOpenFootnote = ZLStringPool::NOT_FOUND;
 
 	myInsideTitle = false;
 	mySectionContainsRegularContents = false;
+
+	myNextCheckpoint = 0;
 }
 
 BookReader::~BookReader() {
 }
 
+void BookReader::setCurrentTextModel(shared_ptr<ZLTextModel> model) {
+	myCurrentTextModel = model;
+	myCurrentModelSlot = -1;
+	if (model.isNull()) {
+		return;
+	}
+	for (std::size_t i = 0; i < myModelsWithOpenParagraphs.size(); ++i) {
+		if (myModelsWithOpenParagraphs[i] == model) {
+			myCurrentModelSlot = i;
+			break;
+		}
+	}
+}
+
 void BookReader::setMainTextModel() {
-	myCurrentTextModel = myModel.myBookTextModel;
+	setCurrentTextModel(myModel.myBookTextModel);
 }
 
 void BookReader::setFootnoteTextModel(const std::string &id) {
-	std::map<std::string,shared_ptr<ZLTextModel> >::iterator it = myModel.myFootnotes.find(id);
-	if (it != myModel.myFootnotes.end()) {
-		myCurrentTextModel = (*it).second;
-	} else {
-		if (myFootnotesAllocator.isNull()) {
-			myFootnotesAllocator = new ZLCachedMemoryAllocator(8192, myModel.CacheDir, "footnotes");
+	BookModel::Footnotes &footnotes = myModel.myFootnotes;
+	if (footnotes.myModel.isNull()) {
+		footnotes.myModel = new ZLTextPlainModel(std::string(), myModel.myBookTextModel->language(), 8192, myModel.CacheDir, "footnotes", myModel.myFontManager);
+		if (myModel.myStyleReferencesEnabled) {
+			footnotes.myModel->enableStyleReferences();
 		}
-		myCurrentTextModel = new ZLTextPlainModel(id, myModel.myBookTextModel->language(), myFootnotesAllocator, myModel.myFontManager);
-		myModel.myFootnotes.insert(std::make_pair(id, myCurrentTextModel));
 	}
-}
+	const std::size_t index = footnotes.add(id);
+	mySuspendedFootnotes.resize(footnotes.size(), false);
 
-bool BookReader::paragraphIsOpen() const {
-	if (myCurrentTextModel.isNull()) {
-		return false;
+	setCurrentTextModel(footnotes.myModel);
+	if (paragraphIsOpen() && myOpenFootnote != index) {
+		myCurrentFootnote = myOpenFootnote;
+		endParagraph();
+		mySuspendedFootnotes[myOpenFootnote] = true;
 	}
-	for (std::list<shared_ptr<ZLTextModel> >::const_iterator it = myModelsWithOpenParagraphs.begin(); it != myModelsWithOpenParagraphs.end(); ++it) {
-		if (*it == myCurrentTextModel) {
-			return true;
-		}
+	myCurrentFootnote = index;
+	if (mySuspendedFootnotes[index]) {
+		mySuspendedFootnotes[index] = false;
+		beginParagraph();
 	}
-	return false;
 }
 
 void BookReader::unsetTextModel() {
-	myCurrentTextModel = 0;
+	setCurrentTextModel(0);
 }
 
 void BookReader::pushKind(FBTextKind kind) {
@@ -92,12 +110,17 @@ void BookReader::beginParagraph(ZLTextParagraph::Kind kind) {
 	endParagraph();
 	if (myCurrentTextModel != 0) {
 		((ZLTextPlainModel&)*myCurrentTextModel).createParagraph(kind);
+		if (myCurrentTextModel == myModel.myFootnotes.myModel) {
+			myModel.myFootnotes.addParagraph(myCurrentFootnote);
+			myOpenFootnote = myCurrentFootnote;
+		}
 		for (std::vector<FBTextKind>::const_iterator it = myKindStack.begin(); it != myKindStack.end(); ++it) {
 			myCurrentTextModel->addControl(*it, true);
 		}
 		if (!myHyperlinkReference.empty()) {
 			myCurrentTextModel->addHyperlinkControl(myHyperlinkKind, myHyperlinkType, myHyperlinkReference);
 		}
+		myCurrentModelSlot = myModelsWithOpenParagraphs.size();
 		myModelsWithOpenParagraphs.push_back(myCurrentTextModel);
 	}
 }
@@ -105,7 +128,31 @@ void BookReader::beginParagraph(ZLTextParagraph::Kind kind) {
 void BookReader::endParagraph() {
 	if (paragraphIsOpen()) {
 		flushTextBufferToParagraph();
-		myModelsWithOpenParagraphs.remove(myCurrentTextModel);
+		myModelsWithOpenParagraphs[myCurrentModelSlot] = myModelsWithOpenParagraphs.back();
+		myModelsWithOpenParagraphs.pop_back();
+		myCurrentModelSlot = -1;
+		checkpoint(false);
+	}
+}
+
+void BookReader::checkpoint(bool sectionEnd) {
+	if (myModel.myCheckpointListener.isNull() ||
+			myCurrentTextModel != myModel.myBookTextModel ||
+			!myModelsWithOpenParagraphs.empty()) {
+		return;
+	}
+	const std::size_t size = myModel.myBookTextModel->paragraphsNumber();
+	if (myNextCheckpoint == 0) {
+		// nothing is published yet: publish after the first section or the first interval
+		if (size == 0 || (!sectionEnd && size < myModel.myCheckpointInterval)) {
+			return;
+		}
+	} else if (size < myNextCheckpoint) {
+		return;
+	}
+	myNextCheckpoint = std::max(2 * size, size + myModel.myCheckpointInterval);
+	if (myModel.flush()) {
+		myModel.myCheckpointListener->onCheckpoint(myModel);
 	}
 }
 
@@ -140,6 +187,29 @@ void BookReader::addStyleCloseEntry() {
 	}
 }
 
+void BookReader::startRecording(ZLTextEntryRecording &recording) {
+	if (paragraphIsOpen()) {
+		flushTextBufferToParagraph();
+		myCurrentTextModel->startRecording(recording);
+	} else {
+		recording.Model = 0;
+	}
+}
+
+void BookReader::stopRecording() {
+	if (myCurrentTextModel != 0) {
+		myCurrentTextModel->stopRecording();
+	}
+}
+
+bool BookReader::addRecording(const ZLTextEntryRecording &recording) {
+	if (!paragraphIsOpen()) {
+		return false;
+	}
+	flushTextBufferToParagraph();
+	return myCurrentTextModel->addRecording(recording);
+}
+
 void BookReader::addFixedHSpace(unsigned char length) {
 	if (paragraphIsOpen()) {
 		flushTextBufferToParagraph();
@@ -184,7 +254,9 @@ void BookReader::addHyperlinkControl(FBTextKind kind, const std::string &label)
 
 void BookReader::addHyperlinkLabel(const std::string &label) {
 	if (!myCurrentTextModel.isNull()) {
-		int paragraphNumber = myCurrentTextModel->paragraphsNumber();
+		int paragraphNumber = myCurrentTextModel == myModel.myFootnotes.myModel ?
+			myModel.myFootnotes.paragraphsNumber(myCurrentFootnote) :
+			myCurrentTextModel->paragraphsNumber();
 		if (paragraphIsOpen()) {
 			--paragraphNumber;
 		}
@@ -197,9 +269,11 @@ void BookReader::addHyperlinkLabel(const std::string &label, int paragraphNumber
 //		"hyperlink",
 //		" + label: " + label
 //	);
-	myModel.myInternalHyperlinks.insert(std::make_pair(
-		label, BookModel::Label(myCurrentTextModel, paragraphNumber)
-	));
+	if (!myCurrentTextModel.isNull() && myCurrentTextModel == myModel.myFootnotes.myModel) {
+		myModel.myInternalHyperlinks.add(label, BookModel::Label(myCurrentTextModel, myCurrentFootnote, paragraphNumber));
+	} else {
+		myModel.myInternalHyperlinks.add(label, BookModel::Label(myCurrentTextModel, paragraphNumber));
+	}
 }
 
 void BookReader::addData(const std::string &data) {
@@ -207,7 +281,7 @@ void BookReader::addData(const std::string &data) {
 		if (!myInsideTitle) {
 			mySectionContainsRegularContents = true;
 		}
-		myBuffer.push_back(data);
+		myBuffer.append(data);
 	}
 }
 
@@ -218,8 +292,10 @@ void BookReader::addContentsData(const std::string &data) {
 }
 
 void BookReader::flushTextBufferToParagraph() {
-	myCurrentTextModel->addText(myBuffer);
-	myBuffer.clear();
+	if (!myBuffer.empty()) {
+		myCurrentTextModel->addText(myBuffer.data(), myBuffer.size());
+		myBuffer.clear();
+	}
 }
 
 void BookReader::addImage(const std::string &id, shared_ptr<const ZLImage> image) {
@@ -247,10 +323,19 @@ void BookReader::addExtensionEntry(const std::string &action, const std::map<std
 
 void BookReader::insertEndParagraph(ZLTextParagraph::Kind kind) {
 	if (myCurrentTextModel != 0 && mySectionContainsRegularContents) {
+		const bool isFootnote = myCurrentTextModel == myModel.myFootnotes.myModel;
 		std::size_t size = myCurrentTextModel->paragraphsNumber();
-		if (size > 0 && ((*myCurrentTextModel)[(std::size_t)-1])->kind() != kind) {
+		if (isFootnote) {
+			// the last paragraph of the footnote, not of the shared model
+			const std::vector<BookModel::Footnotes::Range> &ranges = myModel.myFootnotes.ranges(myCurrentFootnote);
+			size = ranges.empty() ? 0 : ranges.back().End;
+		}
+		if (size > 0 && (*myCurrentTextModel)[size - 1].kind() != kind) {
 			endParagraph();
 			((ZLTextPlainModel&)*myCurrentTextModel).createParagraph(kind);
+			if (isFootnote) {
+				myModel.myFootnotes.addParagraph(myCurrentFootnote);
+			}
 			mySectionContainsRegularContents = false;
 		}
 	}
@@ -258,6 +343,7 @@ void BookReader::insertEndParagraph(ZLTextParagraph::Kind kind) {
 
 void BookReader::insertEndOfSectionParagraph() {
 	insertEndParagraph(ZLTextParagraph::END_OF_SECTION_PARAGRAPH);
+	checkpoint(true);
 }
 
 void BookReader::insertPseudoEndOfSectionParagraph() {
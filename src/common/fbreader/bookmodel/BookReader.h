@@ -21,7 +21,6 @@
 #define __BOOKREADER_H__
 
 #include <vector>
-#include <list>
 #include <map>
 #include <stack>
 #include <string>
@@ -34,6 +33,7 @@
 class BookModel;
 class ContentsTree;
 class ZLTextModel;
+struct ZLTextEntryRecording;
 class ZLInputStream;
 class ZLCachedMemoryAllocator;
 class ZLTextStyleEntry;
@@ -71,6 +71,12 @@ public:
 	void addHyperlinkLabel(const std::string &label, int paragraphNumber);
 	void addFixedHSpace(unsigned char length);
 
+	// records the controls and style entries added until stopRecording()
+	void startRecording(ZLTextEntryRecording &recording);
+	void stopRecording();
+	// false if the recording cannot be used for the current paragraph
+	bool addRecording(const ZLTextEntryRecording &recording);
+
 	void addImageReference(const std::string &id, short vOffset, bool isCover);
 	void addImage(const std::string &id, shared_ptr<const ZLImage> image);
 
@@ -97,11 +103,16 @@ public:
 private:
 	void insertEndParagraph(ZLTextParagraph::Kind kind);
 	void flushTextBufferToParagraph();
+	void checkpoint(bool sectionEnd);
+	void setCurrentTextModel(shared_ptr<ZLTextModel> model);
 
 private:
 	BookModel &myModel;
 	shared_ptr<ZLTextModel> myCurrentTextModel;
-	std::list<shared_ptr<ZLTextModel> > myModelsWithOpenParagraphs;
+	// models with an open paragraph; unordered, removal swaps with the last element
+	std::vector<shared_ptr<ZLTextModel> > myModelsWithOpenParagraphs;
+	// position of myCurrentTextModel in myModelsWithOpenParagraphs, -1 if its paragraph is closed
+	int myCurrentModelSlot;
 
 	std::vector<FBTextKind> myKindStack;
 
@@ -111,15 +122,28 @@ private:
 	bool mySectionContainsRegularContents;
 	bool myInsideTitle;
 
-	std::vector<std::string> myBuffer;
+	// utf-8 text of the current paragraph not yet passed to the model
+	std::string myBuffer;
 
 	std::string myHyperlinkReference;
 	FBHyperlinkType myHyperlinkType;
 	FBTextKind myHyperlinkKind;
 
-	shared_ptr<ZLCachedMemoryAllocator> myFootnotesAllocator;
+	// the footnote being read, if myCurrentTextModel is the footnotes model
+	std::size_t myCurrentFootnote;
+	// the footnote owning the open paragraph of the footnotes model
+	std::size_t myOpenFootnote;
+	// footnotes whose open paragraph was closed when another footnote was opened;
+	// a new paragraph is started when such a footnote is set again
+	std::vector<bool> mySuspendedFootnotes;
+
+	std::size_t myNextCheckpoint;
 };
 
+inline bool BookReader::paragraphIsOpen() const {
+	return myCurrentModelSlot != -1;
+}
+
 inline bool BookReader::contentsParagraphIsOpen() const {
 	return myContentsParagraphExists;
 }
@@ -19,23 +19,55 @@
 
 #include <JSONWriter.h>
 #include <JSONUtil.h>
+#include <ZLTextSearchIndex.h>
 
 #include "BookModel.h"
 #include "ModelWriter.h"
 #include "../library/Book.h"
 
-ModelWriter::ModelWriter(const std::string &dir) : myDir(dir) {
+static const std::string FOOTNOTE_STYLES = "fnst";
+
+ModelWriter::ModelWriter(const std::string &dir, JSONOutput::Format format) : myDir(dir), myFormat(format) {
+}
+
+ModelCheckpointWriter::ModelCheckpointWriter(const std::string &dir, JSONOutput::Format format) : myWriter(dir, format) {
 }
 
-void ModelWriter::writeModelInfo(const BookModel &model) {
-	shared_ptr<JSONMapWriter> everythingWriter = new JSONMapWriter(myDir + "/MODELS");
+void ModelCheckpointWriter::onCheckpoint(const BookModel &model) {
+	myWriter.writeModelInfo(model, false);
+}
+
+class FootnoteIdComparator {
+
+public:
+	FootnoteIdComparator(const BookModel::Footnotes &footnotes) : myFootnotes(footnotes) {}
+
+	bool operator () (std::size_t first, std::size_t second) const {
+		return myFootnotes.id(first) < myFootnotes.id(second);
+	}
+
+private:
+	const BookModel::Footnotes &myFootnotes;
+};
+
+void ModelWriter::writeModelInfo(const BookModel &model, bool complete) {
+	shared_ptr<JSONMapWriter> everythingWriter = new JSONMapWriter(myDir + "/MODELS", myFormat);
+	everythingWriter->addElement("done", complete ? 1 : 0);
 
 	shared_ptr<JSONArrayWriter> modelsWriter = everythingWriter->addArray("mdls");
 	writeModel(*model.bookTextModel(), modelsWriter->addMap());
-	const std::map<std::string,shared_ptr<ZLTextModel> > &footnotes = model.footnotes();
-	std::map<std::string,shared_ptr<ZLTextModel> >::const_iterator it = footnotes.begin();
-	for (; it != footnotes.end(); ++it) {
-		writeModel(*it->second, modelsWriter->addMap());
+	const BookModel::Footnotes &footnotes = model.footnotes();
+	std::vector<std::size_t> footnotesOrder;
+	for (std::size_t i = 0; i < footnotes.size(); ++i) {
+		footnotesOrder.push_back(i);
+	}
+	std::sort(footnotesOrder.begin(), footnotesOrder.end(), FootnoteIdComparator(footnotes));
+	for (std::vector<std::size_t>::const_iterator it = footnotesOrder.begin(); it != footnotesOrder.end(); ++it) {
+		writeFootnote(footnotes, *it, modelsWriter->addMap());
+	}
+	if (footnotes.size() > 0) {
+		// footnotes share one style table, it is written once and referenced by "stbl"
+		writeStyleEntries(*footnotes.model(), everythingWriter, FOOTNOTE_STYLES);
 	}
 
 	writeInternalHyperlinks(model, everythingWriter->addMap("hlks"));
@@ -62,7 +94,12 @@ void ModelWriter::writeModelInfo(const BookModel &model) {
 		}
 	}
 
-	writeTOC(*model.contentsTree(), new JSONMapWriter(myDir + "/TOC"));
+	shared_ptr<ZLTextSearchIndexer> indexer = model.bookTextModel()->searchIndexer();
+	if (complete && !indexer.isNull() && indexer->write(myDir + "/SEARCH")) {
+		everythingWriter->addElement("srch", "SEARCH");
+	}
+
+	writeTOC(*model.contentsTree(), new JSONMapWriter(myDir + "/TOC", myFormat), everythingWriter->addMap("toc"));
 }
 
 void ModelWriter::writeModel(const ZLTextModel &model, shared_ptr<JSONMapWriter> writer) {
@@ -77,27 +114,112 @@ void ModelWriter::writeModel(const ZLTextModel &model, shared_ptr<JSONMapWriter>
 	JSONUtil::serializeIntArray(model.paragraphLengths(), writer->addArray("pl"));
 	JSONUtil::serializeIntArrayAsDiffs(model.textSizes(), writer->addArray("ts"));
 	JSONUtil::serializeByteArray(model.paragraphKinds(), writer->addArray("pk"));
+	writeStyleEntries(model, writer, "st");
 }
 
+// a footnote is written as a separate model built of its paragraphs in the shared footnotes model
+void ModelWriter::writeFootnote(const BookModel::Footnotes &footnotes, std::size_t index, shared_ptr<JSONMapWriter> writer) {
+	const ZLTextModel &model = *footnotes.model();
+	const std::size_t size = footnotes.paragraphsNumber(index);
+
+	std::vector<int> startEntryIndices;
+	std::vector<int> startEntryOffsets;
+	std::vector<int> paragraphLengths;
+	std::vector<int> textSizes;
+	std::vector<unsigned char> paragraphKinds;
+	startEntryIndices.reserve(size);
+	startEntryOffsets.reserve(size);
+	paragraphLengths.reserve(size);
+	textSizes.reserve(size);
+	paragraphKinds.reserve(size);
+
+	int textSize = 0;
+	const std::vector<BookModel::Footnotes::Range> &ranges = footnotes.ranges(index);
+	for (std::vector<BookModel::Footnotes::Range>::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+		for (std::size_t i = it->Start; i < it->End; ++i) {
+			startEntryIndices.push_back(model.startEntryIndices()[i]);
+			startEntryOffsets.push_back(model.startEntryOffsets()[i]);
+			paragraphLengths.push_back(model.paragraphLengths()[i]);
+			textSize += model.textSizes()[i] - (i > 0 ? model.textSizes()[i - 1] : 0);
+			textSizes.push_back(textSize);
+			paragraphKinds.push_back(model.paragraphKinds()[i]);
+		}
+	}
+
+	writer->addElementIfNotEmpty("id", footnotes.id(index));
+	writer->addElementIfNotEmpty("lang", model.language());
+	writer->addElement("size", size);
+	const ZLCachedMemoryAllocator &allocator = model.allocator();
+	writer->addElement("ext", allocator.fileExtension());
+	writer->addElement("blks", allocator.blocksNumber());
+	JSONUtil::serializeIntArrayAsCounts(startEntryIndices, writer->addArray("ei"));
+	JSONUtil::serializeIntArrayAsDiffs(startEntryOffsets, writer->addArray("eo"));
+	JSONUtil::serializeIntArray(paragraphLengths, writer->addArray("pl"));
+	JSONUtil::serializeIntArrayAsDiffs(textSizes, writer->addArray("ts"));
+	JSONUtil::serializeByteArray(paragraphKinds, writer->addArray("pk"));
+	if (model.styleEntries().size() > 0) {
+		writer->addElement("stbl", FOOTNOTE_STYLES);
+	}
+}
+
+void ModelWriter::writeStyleEntries(const ZLTextModel &model, shared_ptr<JSONMapWriter> writer, const std::string &key) {
+	const ZLStringPool &styleEntries = model.styleEntries();
+	if (styleEntries.size() > 0) {
+		shared_ptr<JSONArrayWriter> stylesWriter = writer->addArray(key);
+		for (std::size_t i = 0; i < styleEntries.size(); ++i) {
+			JSONUtil::serializeByteArray(styleEntries.string(i), stylesWriter->addArray());
+		}
+	}
+}
+
+class LabelNameComparator {
+
+public:
+	LabelNameComparator(const BookModel::LabelTable &labels) : myLabels(labels) {}
+
+	bool operator () (std::size_t first, std::size_t second) const {
+		return myLabels.name(first) < myLabels.name(second);
+	}
+
+private:
+	const BookModel::LabelTable &myLabels;
+};
+
 void ModelWriter::writeInternalHyperlinks(const BookModel &model, shared_ptr<JSONMapWriter> writer) {
 	ZLCachedMemoryAllocator allocator(131072, myDir, "nlinks");
 
 	ZLUnicodeUtil::Ucs2String ucs2id;
 	ZLUnicodeUtil::Ucs2String ucs2modelId;
 
-	const std::map<std::string,BookModel::Label> &links = model.internalHyperlinks();
-	std::map<std::string,BookModel::Label>::const_iterator it = links.begin();
-	for (; it != links.end(); ++it) {
-		const std::string &id = it->first;
-		const BookModel::Label &label = it->second;
-		if (label.Model.isNull()) {
-			continue;
+	// records are written in label name order, so a reader can use
+	// the (block, offset) index below for a binary search
+	const BookModel::LabelTable &labels = model.internalHyperlinks();
+	std::vector<std::size_t> order;
+	order.reserve(labels.size());
+	for (std::size_t i = 0; i < labels.size(); ++i) {
+		// an empty name would be read as the end of block marker
+		if (!labels.label(i).Model.isNull() && !labels.name(i).empty()) {
+			order.push_back(i);
 		}
+	}
+	std::sort(order.begin(), order.end(), LabelNameComparator(labels));
+
+	std::vector<int> recordBlocks;
+	std::vector<int> recordOffsets;
+	recordBlocks.reserve(order.size());
+	recordOffsets.reserve(order.size());
+	for (std::vector<std::size_t>::const_iterator it = order.begin(); it != order.end(); ++it) {
+		const std::string &id = labels.name(*it);
+		const BookModel::Label &label = labels.label(*it);
 		ZLUnicodeUtil::utf8ToUcs2(ucs2id, id);
-		ZLUnicodeUtil::utf8ToUcs2(ucs2modelId, label.Model->id());
+		ZLUnicodeUtil::utf8ToUcs2(ucs2modelId, label.Footnote != -1 ? model.footnotes().id(label.Footnote) : label.Model->id());
 		const std::size_t idLen = ucs2id.size() * 2;
 		const std::size_t modelIdLen = ucs2modelId.size() * 2;
 
+		const std::size_t blocksNumber = allocator.blocksNumber();
+		recordBlocks.push_back(blocksNumber == 0 ? 0 : blocksNumber - 1);
+		recordOffsets.push_back(allocator.currentBytesOffset() / 2);
+
 		char *ptr = allocator.allocate(idLen + modelIdLen + 8);
 		ZLCachedMemoryAllocator::writeUInt16(ptr, ucs2id.size());
 		ptr += 2;
@@ -113,25 +235,100 @@ void ModelWriter::writeInternalHyperlinks(const BookModel &model, shared_ptr<JSO
 
 	writer->addElement("ext", allocator.fileExtension());
 	writer->addElement("blks", allocator.blocksNumber());
+	writer->addElement("size", (int)order.size());
+	JSONUtil::serializeIntArrayAsCounts(recordBlocks, writer->addArray("bi"));
+	JSONUtil::serializeIntArrayAsDiffs(recordOffsets, writer->addArray("bo"));
 }
 
-static bool ct_compare(const shared_ptr<ContentsTree> &first, const shared_ptr<ContentsTree> &second) {
+static bool ct_compare(const ContentsTree *first, const ContentsTree *second) {
 	return first->reference() < second->reference();
 }
 
-void ModelWriter::writeTOC(const ContentsTree &tree, shared_ptr<JSONMapWriter> writer) {
-	const std::string &text = tree.text();
-	writer->addElementIfNotEmpty("t", text);
-	const int ref = tree.reference();
-	if (ref >= 0) {
-		writer->addElement("r", ref);
-	}
-	std::vector<shared_ptr<ContentsTree> > children = tree.children();
-	if (children.size() > 0) {
-		shared_ptr<JSONArrayWriter> childrenWriter = writer->addArray("c");
-		std::sort(children.begin(), children.end(), ct_compare);
-		for (std::vector<shared_ptr<ContentsTree> >::const_iterator it = children.begin(); it != children.end(); ++it) {
-			writeTOC(**it, childrenWriter->addMap());
+struct TOCFrame {
+	TOCFrame(const ContentsTree &tree, std::size_t index);
+
+	std::size_t Index;
+	std::vector<const ContentsTree*> Children;
+	std::size_t NextChild;
+	shared_ptr<JSONArrayWriter> ChildrenWriter;
+};
+
+TOCFrame::TOCFrame(const ContentsTree &tree, std::size_t index) : Index(index), NextChild(0) {
+	const std::vector<shared_ptr<ContentsTree> > &children = tree.children();
+	Children.reserve(children.size());
+	for (std::vector<shared_ptr<ContentsTree> >::const_iterator it = children.begin(); it != children.end(); ++it) {
+		Children.push_back(&**it);
+	}
+	std::stable_sort(Children.begin(), Children.end(), ct_compare);
+}
+
+// Writes the tree to TOC (nested maps, children sorted by reference) and,
+// in the same pre-order pass, a flat table to indexWriter: references,
+// offsets to the parent entry (entry index minus parent index, 0 for the
+// root), and entry texts in "ntoc" cache blocks addressed by (block, offset)
+// pairs, so a reader can fetch any entry without loading the tree.
+void ModelWriter::writeTOC(const ContentsTree &tree, shared_ptr<JSONMapWriter> writer, shared_ptr<JSONMapWriter> indexWriter) {
+	ZLCachedMemoryAllocator allocator(131072, myDir, "ntoc");
+	ZLUnicodeUtil::Ucs2String ucs2text;
+	std::vector<int> references;
+	std::vector<int> parentOffsets;
+	std::vector<int> textBlocks;
+	std::vector<int> textOffsets;
+
+	std::vector<TOCFrame> stack;
+	// the root writer must stay alive: destroying it closes the file
+	shared_ptr<JSONMapWriter> entryWriter = writer;
+	const ContentsTree *node = &tree;
+	std::size_t parentIndex = 0;
+	while (true) {
+		const std::size_t index = references.size();
+		const std::string &text = node->text();
+		const int ref = node->reference();
+		entryWriter->addElementIfNotEmpty("t", text);
+		if (ref >= 0) {
+			entryWriter->addElement("r", ref);
+		}
+
+		references.push_back(ref);
+		parentOffsets.push_back(index - parentIndex);
+		ZLUnicodeUtil::utf8ToUcs2(ucs2text, text);
+		const std::size_t len = std::min(ucs2text.size(), (std::size_t)0xFFFF);
+		char *ptr = allocator.allocate(2 + 2 * len);
+		ZLCachedMemoryAllocator::writeUInt16(ptr, len);
+		if (len > 0) {
+			std::memcpy(ptr + 2, &ucs2text.front(), 2 * len);
+		}
+		// the position after allocation: the record might have moved to a new block
+		textBlocks.push_back(allocator.blocksNumber() - 1);
+		textOffsets.push_back((allocator.currentBytesOffset() - 2 - 2 * len) / 2);
+
+		stack.push_back(TOCFrame(*node, index));
+		if (!stack.back().Children.empty()) {
+			stack.back().ChildrenWriter = entryWriter->addArray("c");
+		}
+
+		node = 0;
+		while (!stack.empty()) {
+			TOCFrame &frame = stack.back();
+			if (frame.NextChild < frame.Children.size()) {
+				node = frame.Children[frame.NextChild++];
+				parentIndex = frame.Index;
+				entryWriter = frame.ChildrenWriter->addMap();
+				break;
+			}
+			stack.pop_back();
+		}
+		if (node == 0) {
+			break;
 		}
 	}
+	allocator.flush();
+
+	indexWriter->addElement("ext", allocator.fileExtension());
+	indexWriter->addElement("blks", allocator.blocksNumber());
+	indexWriter->addElement("size", (int)references.size());
+	JSONUtil::serializeIntArray(references, indexWriter->addArray("r"));
+	JSONUtil::serializeIntArray(parentOffsets, indexWriter->addArray("po"));
+	JSONUtil::serializeIntArrayAsCounts(textBlocks, indexWriter->addArray("bi"));
+	JSONUtil::serializeIntArrayAsDiffs(textOffsets, indexWriter->addArray("bo"));
 }
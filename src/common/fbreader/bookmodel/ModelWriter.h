@@ -23,26 +23,44 @@
 #include <string>
 
 #include <shared_ptr.h>
+#include <JSONWriter.h>
+
+#include "BookModel.h"
 
 class ZLTextModel;
-class BookModel;
 class ContentsTree;
-class JSONMapWriter;
 
 class ModelWriter {
 
 public:
-	ModelWriter(const std::string &dir);
+	// TEXT writes MODELS and TOC as JSON, BINARY as CBOR (see JSONOutput)
+	ModelWriter(const std::string &dir, JSONOutput::Format format = JSONOutput::TEXT);
 
-	void writeModelInfo(const BookModel &model);
+	// complete == false marks a consistent prefix of a model that is still being built
+	void writeModelInfo(const BookModel &model, bool complete = true);
 
 private:
 	void writeModel(const ZLTextModel &model, shared_ptr<JSONMapWriter> writer);
+	void writeFootnote(const BookModel::Footnotes &footnotes, std::size_t index, shared_ptr<JSONMapWriter> writer);
+	void writeStyleEntries(const ZLTextModel &model, shared_ptr<JSONMapWriter> writer, const std::string &key);
 	void writeInternalHyperlinks(const BookModel &model, shared_ptr<JSONMapWriter> writer);
-	void writeTOC(const ContentsTree &tree, shared_ptr<JSONMapWriter> writer);
+	void writeTOC(const ContentsTree &tree, shared_ptr<JSONMapWriter> writer, shared_ptr<JSONMapWriter> indexWriter);
 
 private:
 	const std::string myDir;
+	const JSONOutput::Format myFormat;
+};
+
+class ModelCheckpointWriter : public BookModel::CheckpointListener {
+
+public:
+	ModelCheckpointWriter(const std::string &dir, JSONOutput::Format format = JSONOutput::TEXT);
+
+private:
+	void onCheckpoint(const BookModel &model);
+
+private:
+	ModelWriter myWriter;
 };
 
 #endif /* __MODELWRITER_H__ */
@@ -110,3 +110,14 @@ shared_ptr<const ZLImage> FormatPlugin::coverImage(const ZLFile&) const {
 std::string FormatPlugin::readAnnotation(const ZLFile&) const {
 	return "";
 }
+
+bool FormatPlugin::readAllMetainfo(Book &book, shared_ptr<const ZLImage> &cover, std::string &annotation) const {
+	if (!readMetainfo(book)) {
+		return false;
+	}
+	readUids(book);
+	readLanguageAndEncoding(book);
+	cover = coverImage(book.file());
+	annotation = readAnnotation(book.file());
+	return true;
+}
@@ -25,6 +25,8 @@
 
 #include <shared_ptr.h>
 
+#include <ZLStringPool.h>
+
 class Book;
 class BookModel;
 class FileEncryptionInfo;
@@ -63,6 +65,9 @@ public:
 	virtual bool readModel(BookModel &model) const = 0;
 	virtual shared_ptr<const ZLImage> coverImage(const ZLFile &file) const;
 	virtual std::string readAnnotation(const ZLFile &file) const;
+	// reads metainfo, uids, language/encoding, cover and annotation at once;
+	// the default implementation just calls the methods above one by one
+	virtual bool readAllMetainfo(Book &book, shared_ptr<const ZLImage> &cover, std::string &annotation) const;
 
 protected:
 	static bool detectEncodingAndLanguage(Book &book, ZLInputStream &stream, bool force = false);
@@ -84,13 +89,42 @@ public:
 public:
 	std::vector<shared_ptr<FormatPlugin> > plugins() const;
 	shared_ptr<FormatPlugin> pluginByType(const std::string &fileType) const;
+	// detects format by file header (ZIP/ePub, PDB, RTF, OLE, XML root element);
+	// returns an empty string if the header gives no definite answer, and
+	// "fb2.zip" for a ZIP archive with a .fb2 book as the first entry
+	std::string fileTypeByContent(const ZLFile &file) const;
+	// returns 0 if there is no plugin for fileTypeByContent(file)
+	shared_ptr<FormatPlugin> pluginByContent(const ZLFile &file) const;
 
 	bool isLanguageAutoDetectEnabled();
+	// bytes of ePub text sampled for language detection; 65536 by default,
+	// the volume FormatPlugin::detectLanguage reads from a plain stream
+	std::size_t languageDetectionBudget() const;
+	void setLanguageDetectionBudget(std::size_t budget);
+	// off by default: the reader of the cache must know STYLE_REFERENCE_ENTRY
+	bool areStyleReferencesEnabled() const;
+	void setStyleReferencesEnabled(bool enabled);
+	// builds the full-text index (SEARCH) with the model; off by default
+	bool isSearchIndexEnabled() const;
+	void setSearchIndexEnabled(bool enabled);
+	// threads converting a book, the calling one included;
+	// 1 means the book is read sequentially, 3 by default
+	std::size_t loadingThreadsNumber() const;
+	void setLoadingThreadsNumber(std::size_t number);
+
+private:
+	void addPlugin(shared_ptr<FormatPlugin> plugin);
 
 private:
 	static PluginCollection *ourInstance;
 
 	std::vector<shared_ptr<FormatPlugin> > myPlugins;
+	// supported file types; ids coincide with myPlugins indices
+	ZLStringPool myFileTypes;
+	bool myStyleReferencesEnabled;
+	bool mySearchIndexEnabled;
+	std::size_t myLoadingThreadsNumber;
+	std::size_t myLanguageDetectionBudget;
 };
 
 //inline FormatInfoPage::FormatInfoPage() {}
@@ -102,5 +136,13 @@ inline FormatPlugin::~FormatPlugin() {}
 inline std::vector<shared_ptr<FormatPlugin> > PluginCollection::plugins() const {
 	return myPlugins;
 }
+inline std::size_t PluginCollection::languageDetectionBudget() const { return myLanguageDetectionBudget; }
+inline void PluginCollection::setLanguageDetectionBudget(std::size_t budget) { myLanguageDetectionBudget = budget; }
+inline bool PluginCollection::areStyleReferencesEnabled() const { return myStyleReferencesEnabled; }
+inline void PluginCollection::setStyleReferencesEnabled(bool enabled) { myStyleReferencesEnabled = enabled; }
+inline bool PluginCollection::isSearchIndexEnabled() const { return mySearchIndexEnabled; }
+inline void PluginCollection::setSearchIndexEnabled(bool enabled) { mySearchIndexEnabled = enabled; }
+inline std::size_t PluginCollection::loadingThreadsNumber() const { return myLoadingThreadsNumber; }
+inline void PluginCollection::setLoadingThreadsNumber(std::size_t number) { myLoadingThreadsNumber = number > 0 ? number : 1; }
 
 #endif /* __FORMATPLUGIN_H__ */
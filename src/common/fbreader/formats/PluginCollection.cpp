@@ -17,8 +17,14 @@
  * 02110-1301, USA.
  */
 
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+
 #include <ZLibrary.h>
 #include <ZLFile.h>
+#include <ZLInputStream.h>
+#include <ZLStringUtil.h>
 
 #include "FormatPlugin.h"
 
@@ -40,19 +46,19 @@ PluginCollection *PluginCollection::ourInstance = 0;
 PluginCollection &PluginCollection::Instance() {
 	if (ourInstance == 0) {
 		ourInstance = new PluginCollection();
-		ourInstance->myPlugins.push_back(new FB2Plugin());
-		ourInstance->myPlugins.push_back(new HtmlPlugin());
-		ourInstance->myPlugins.push_back(new TxtPlugin());
+		ourInstance->addPlugin(new FB2Plugin());
+		ourInstance->addPlugin(new HtmlPlugin());
+		ourInstance->addPlugin(new TxtPlugin());
 //		ourInstance->myPlugins.push_back(new PluckerPlugin());
 //		ourInstance->myPlugins.push_back(new PalmDocPlugin());
-		ourInstance->myPlugins.push_back(new MobipocketPlugin());
+		ourInstance->addPlugin(new MobipocketPlugin());
 //		ourInstance->myPlugins.push_back(new EReaderPlugin());
 //		ourInstance->myPlugins.push_back(new ZTXTPlugin());
 //		ourInstance->myPlugins.push_back(new TcrPlugin());
 //		ourInstance->myPlugins.push_back(new CHMPlugin());
-		ourInstance->myPlugins.push_back(new OEBPlugin());
-		ourInstance->myPlugins.push_back(new RtfPlugin());
-		ourInstance->myPlugins.push_back(new DocPlugin());
+		ourInstance->addPlugin(new OEBPlugin());
+		ourInstance->addPlugin(new RtfPlugin());
+		ourInstance->addPlugin(new DocPlugin());
 //		ourInstance->myPlugins.push_back(new OpenReaderPlugin());
 	}
 	return *ourInstance;
@@ -65,19 +71,148 @@ void PluginCollection::deleteInstance() {
 	}
 }
 
-PluginCollection::PluginCollection() {
+PluginCollection::PluginCollection() : myStyleReferencesEnabled(false), mySearchIndexEnabled(false), myLoadingThreadsNumber(3), myLanguageDetectionBudget(65536) {
 }
 
 PluginCollection::~PluginCollection() {
 }
 
+void PluginCollection::addPlugin(shared_ptr<FormatPlugin> plugin) {
+	if (myFileTypes.intern(plugin->supportedFileType()) == myPlugins.size()) {
+		myPlugins.push_back(plugin);
+	}
+}
+
 shared_ptr<FormatPlugin> PluginCollection::pluginByType(const std::string &fileType) const {
-	for (std::vector<shared_ptr<FormatPlugin> >::const_iterator it = myPlugins.begin(); it != myPlugins.end(); ++it) {
-		if (fileType == (*it)->supportedFileType()) {
-			return *it;
+	const std::size_t index = myFileTypes.find(fileType);
+	if (index == ZLStringPool::NOT_FOUND) {
+		return 0;
+	}
+	return myPlugins[index];
+}
+
+static unsigned int readUInt16LE(const char *ptr) {
+	const unsigned char *uptr = (const unsigned char*)ptr;
+	return uptr[0] + (uptr[1] << 8);
+}
+
+static unsigned int readUInt32LE(const char *ptr) {
+	return readUInt16LE(ptr) + (readUInt16LE(ptr + 2) << 16);
+}
+
+static bool startsWith(const char *data, std::size_t length, const char *prefix, std::size_t prefixLength) {
+	return length >= prefixLength && std::memcmp(data, prefix, prefixLength) == 0;
+}
+
+static std::string zipFileType(const char *data, std::size_t length) {
+	if (length < 30) {
+		return std::string();
+	}
+	const unsigned int method = readUInt16LE(data + 8);
+	const std::size_t compressedSize = readUInt32LE(data + 18);
+	const std::size_t nameLength = readUInt16LE(data + 26);
+	const std::size_t extraLength = readUInt16LE(data + 28);
+	if (30 + nameLength > length) {
+		return std::string();
+	}
+	const std::string name(data + 30, nameLength);
+	if (name == "mimetype") {
+		const std::size_t offset = 30 + nameLength + extraLength;
+		if (method == 0 && offset + compressedSize <= length) {
+			std::string mimeType(data + offset, compressedSize);
+			ZLStringUtil::stripWhiteSpaces(mimeType);
+			if (mimeType == "application/epub+zip" || mimeType == "application/x-ibooks+zip") {
+				return "ePub";
+			}
 		}
+	} else if (ZLStringUtil::stringEndsWith(name, ".fb2")) {
+		// the book is an entry of the archive, no plugin reads the archive itself
+		return "fb2.zip";
 	}
-	return 0;
+	return std::string();
+}
+
+static std::string xmlFileType(const char *data, std::size_t length) {
+	const char *ptr = data;
+	const char *end = data + length;
+	if (startsWith(ptr, length, "\xEF\xBB\xBF", 3)) {
+		ptr += 3;
+	}
+	// skips white spaces, processing instructions, comments and doctype
+	while (ptr < end) {
+		if (std::isspace((unsigned char)*ptr)) {
+			++ptr;
+		} else if (*ptr != '<' || ptr + 1 == end) {
+			return std::string();
+		} else if (ptr[1] == '?') {
+			const std::size_t index = std::string(ptr, end - ptr).find("?>");
+			ptr = index != std::string::npos ? ptr + index + 2 : end;
+		} else if (startsWith(ptr, end - ptr, "<!--", 4)) {
+			const std::size_t index = std::string(ptr, end - ptr).find("-->");
+			ptr = index != std::string::npos ? ptr + index + 3 : end;
+		} else if (ptr[1] == '!') {
+			std::string doctype(ptr + 2, std::min(end - ptr - 2, (std::ptrdiff_t)12));
+			ZLStringUtil::asciiToLowerInline(doctype);
+			if (ZLStringUtil::stringStartsWith(doctype, "doctype html")) {
+				return "HTML";
+			}
+			const std::size_t index = std::string(ptr, end - ptr).find('>');
+			ptr = index != std::string::npos ? ptr + index + 1 : end;
+		} else {
+			const char *nameStart = ++ptr;
+			while (ptr < end && !std::isspace((unsigned char)*ptr) && *ptr != '>' && *ptr != '/') {
+				++ptr;
+			}
+			if (ptr == end) {
+				return std::string();
+			}
+			std::string name(nameStart, ptr - nameStart);
+			const std::size_t colon = name.find(':');
+			if (colon != std::string::npos) {
+				name.erase(0, colon + 1);
+			}
+			if (name == "FictionBook") {
+				return "fb2";
+			}
+			ZLStringUtil::asciiToLowerInline(name);
+			return name == "html" ? "HTML" : std::string();
+		}
+	}
+	return std::string();
+}
+
+static std::string fileTypeByHeader(const char *data, std::size_t length) {
+	if (startsWith(data, length, "PK\003\004", 4)) {
+		return zipFileType(data, length);
+	}
+	if (startsWith(data, length, "{\\rtf", 5)) {
+		return "RTF";
+	}
+	if (startsWith(data, length, "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8)) {
+		return "msdoc";
+	}
+	if (length >= 68 && std::memcmp(data + 60, "BOOKMOBI", 8) == 0) {
+		return "mobi";
+	}
+	return xmlFileType(data, length);
+}
+
+std::string PluginCollection::fileTypeByContent(const ZLFile &file) const {
+	static const std::size_t HEADER_SIZE = 1024;
+
+	shared_ptr<ZLInputStream> stream = file.inputStream();
+	if (stream.isNull() || !stream->open()) {
+		return std::string();
+	}
+	char header[HEADER_SIZE];
+	const std::size_t length = stream->read(header, HEADER_SIZE);
+	stream->close();
+
+	return fileTypeByHeader(header, length);
+}
+
+shared_ptr<FormatPlugin> PluginCollection::pluginByContent(const ZLFile &file) const {
+	return pluginByType(fileTypeByContent(file));
 }
 
 bool PluginCollection::isLanguageAutoDetectEnabled() {
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2008-2015 FBReader.ORG Limited <contact@fbreader.org>
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
  *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -17,27 +17,10 @@
  * 02110-1301, USA.
  */
 
-#ifndef __OEBTEXTSTREAM_H__
-#define __OEBTEXTSTREAM_H__
+#include "CSSAtoms.h"
 
-#include <vector>
-#include <string>
+const std::size_t CSSAtoms::ANY = (std::size_t)-1;
 
-#include "../util/MergedStream.h"
-
-class OEBTextStream : public MergedStream {
-
-public:
-	OEBTextStream(const ZLFile &opfFile);
-
-private:
-	void resetToStart();
-	shared_ptr<ZLInputStream> nextStream();
-
-private:
-	std::string myFilePrefix;
-	std::vector<std::string> myXHTMLFileNames;
-	std::size_t myIndex;
-};
-
-#endif /* __OEBTEXTSTREAM_H__ */
+std::size_t CSSAtoms::selectorAtom(const std::string &name) {
+	return name.empty() || name == "*" ? ANY : myPool.intern(name);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __CSSATOMS_H__
+#define __CSSATOMS_H__
+
+#include <string>
+
+#include <ZLStringPool.h>
+
+// Table of element and class names used in style matching; an atom is the
+// id of a name in this table. Each XHTMLReader owns one table, so it lives
+// as long as one book conversion and does not grow from book to book.
+class CSSAtoms {
+
+public:
+	// stands for "any tag" or "no class"; never returned by atom()
+	static const std::size_t ANY;
+
+public:
+	CSSAtoms();
+
+	std::size_t atom(const std::string &name);
+	std::size_t atom(const char *data, std::size_t length);
+	// ANY for empty names and "*", as they are used in selectors
+	std::size_t selectorAtom(const std::string &name);
+	const std::string &name(std::size_t atom) const;
+	std::size_t size() const;
+
+private:
+	ZLStringPool myPool;
+
+private: // disable copying
+	CSSAtoms(const CSSAtoms&);
+	const CSSAtoms &operator = (const CSSAtoms&);
+};
+
+inline CSSAtoms::CSSAtoms() {}
+inline std::size_t CSSAtoms::atom(const std::string &name) { return myPool.intern(name); }
+inline std::size_t CSSAtoms::atom(const char *data, std::size_t length) { return myPool.intern(data, length); }
+inline const std::string &CSSAtoms::name(std::size_t atom) const { return myPool.string(atom); }
+inline std::size_t CSSAtoms::size() const { return myPool.size(); }
+
+#endif /* __CSSATOMS_H__ */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <cstring>
+
+#include "CSSDeclarationList.h"
+
+struct PropertyName {
+	const char *Name;
+	CSSDeclarationList::Property Id;
+};
+
+// sorted by name
+static const PropertyName PROPERTY_NAMES[] = {
+	{ "display", CSSDeclarationList::DISPLAY },
+	{ "font-family", CSSDeclarationList::FONT_FAMILY },
+	{ "font-size", CSSDeclarationList::FONT_SIZE },
+	{ "font-style", CSSDeclarationList::FONT_STYLE },
+	{ "font-variant", CSSDeclarationList::FONT_VARIANT },
+	{ "font-weight", CSSDeclarationList::FONT_WEIGHT },
+	{ "margin", CSSDeclarationList::MARGIN },
+	{ "margin-bottom", CSSDeclarationList::MARGIN_BOTTOM },
+	{ "margin-left", CSSDeclarationList::MARGIN_LEFT },
+	{ "margin-right", CSSDeclarationList::MARGIN_RIGHT },
+	{ "margin-top", CSSDeclarationList::MARGIN_TOP },
+	{ "padding", CSSDeclarationList::PADDING },
+	{ "padding-bottom", CSSDeclarationList::PADDING_BOTTOM },
+	{ "padding-left", CSSDeclarationList::PADDING_LEFT },
+	{ "padding-right", CSSDeclarationList::PADDING_RIGHT },
+	{ "padding-top", CSSDeclarationList::PADDING_TOP },
+	{ "page-break-after", CSSDeclarationList::PAGE_BREAK_AFTER },
+	{ "page-break-before", CSSDeclarationList::PAGE_BREAK_BEFORE },
+	{ "src", CSSDeclarationList::SRC },
+	{ "text-align", CSSDeclarationList::TEXT_ALIGN },
+	{ "text-decoration", CSSDeclarationList::TEXT_DECORATION },
+	{ "text-indent", CSSDeclarationList::TEXT_INDENT },
+	{ "vertical-align", CSSDeclarationList::VERTICAL_ALIGN },
+};
+
+// compares the lower-cased name with a (lower case) table entry
+static int compare(const char *name, std::size_t length, const char *entry) {
+	for (std::size_t i = 0; i < length; ++i, ++entry) {
+		char ch = name[i];
+		if (ch >= 'A' && ch <= 'Z') {
+			ch += 'a' - 'A';
+		}
+		if (*entry == '\0' || ch > *entry) {
+			return 1;
+		} else if (ch < *entry) {
+			return -1;
+		}
+	}
+	return *entry == '\0' ? 0 : -1;
+}
+
+CSSDeclarationList::Property CSSDeclarationList::property(const char *name, std::size_t length) {
+	std::size_t left = 0;
+	std::size_t right = sizeof(PROPERTY_NAMES) / sizeof(PropertyName);
+	while (left < right) {
+		const std::size_t middle = (left + right) / 2;
+		const int diff = compare(name, length, PROPERTY_NAMES[middle].Name);
+		if (diff == 0) {
+			return PROPERTY_NAMES[middle].Id;
+		} else if (diff < 0) {
+			right = middle;
+		} else {
+			left = middle + 1;
+		}
+	}
+	return UNKNOWN_PROPERTY;
+}
+
+bool CSSDeclarationList::Value::operator == (const char *str) const {
+	return std::strlen(str) == Length && std::memcmp(Data, str, Length) == 0;
+}
+
+void CSSDeclarationList::add(Property property, const char *value, std::size_t length) {
+	Declaration declaration;
+	declaration.Id = property;
+	declaration.Offset = myValues.size();
+	// unknown properties only count; nobody reads their values
+	declaration.Length = property != UNKNOWN_PROPERTY ? length : 0;
+	myValues.append(value, declaration.Length);
+	myDeclarations.push_back(declaration);
+}
+
+void CSSDeclarationList::clear() {
+	myDeclarations.clear();
+	myValues.erase();
+}
+
+CSSDeclarationList::Value CSSDeclarationList::value(Property property) const {
+	for (std::vector<Declaration>::const_reverse_iterator it = myDeclarations.rbegin(); it != myDeclarations.rend(); ++it) {
+		if (it->Id == property) {
+			return Value(myValues.data() + it->Offset, it->Length);
+		}
+	}
+	return Value();
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __CSSDECLARATIONLIST_H__
+#define __CSSDECLARATIONLIST_H__
+
+#include <string>
+#include <vector>
+
+// Declarations of one rule (or of a style attribute) in the order they
+// were written: property ids with spans of a single value string
+class CSSDeclarationList {
+
+public:
+	enum Property {
+		UNKNOWN_PROPERTY,
+		DISPLAY,
+		FONT_FAMILY,
+		FONT_SIZE,
+		FONT_STYLE,
+		FONT_VARIANT,
+		FONT_WEIGHT,
+		MARGIN,
+		MARGIN_BOTTOM,
+		MARGIN_LEFT,
+		MARGIN_RIGHT,
+		MARGIN_TOP,
+		PADDING,
+		PADDING_BOTTOM,
+		PADDING_LEFT,
+		PADDING_RIGHT,
+		PADDING_TOP,
+		PAGE_BREAK_AFTER,
+		PAGE_BREAK_BEFORE,
+		SRC,
+		TEXT_ALIGN,
+		TEXT_DECORATION,
+		TEXT_INDENT,
+		VERTICAL_ALIGN
+	};
+
+	// case-insensitive; UNKNOWN_PROPERTY for names nobody reads
+	static Property property(const char *name, std::size_t length);
+
+	struct Value {
+		Value();
+		Value(const char *data, std::size_t length);
+
+		bool empty() const;
+		bool operator == (const char *str) const;
+		bool operator != (const char *str) const;
+		std::string str() const;
+
+		const char *Data;
+		std::size_t Length;
+	};
+
+public:
+	CSSDeclarationList();
+
+	void add(Property property, const char *value, std::size_t length);
+	void clear();
+	bool empty() const;
+	// the last value given to the property; empty if there is none
+	Value value(Property property) const;
+
+private:
+	struct Declaration {
+		Property Id;
+		std::size_t Offset;
+		std::size_t Length;
+	};
+
+	std::vector<Declaration> myDeclarations;
+	std::string myValues;
+};
+
+inline CSSDeclarationList::Value::Value() : Data(0), Length(0) {}
+inline CSSDeclarationList::Value::Value(const char *data, std::size_t length) : Data(data), Length(length) {}
+inline bool CSSDeclarationList::Value::empty() const { return Length == 0; }
+inline bool CSSDeclarationList::Value::operator != (const char *str) const { return !operator == (str); }
+inline std::string CSSDeclarationList::Value::str() const { return std::string(Data, Length); }
+
+inline CSSDeclarationList::CSSDeclarationList() {}
+inline bool CSSDeclarationList::empty() const { return myDeclarations.empty(); }
+
+#endif /* __CSSDECLARATIONLIST_H__ */
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "CSSSelectorIndex.h"
+#include "StyleSheetTable.h"
+
+CSSSelectorIndex::CSSSelectorIndex(const StyleSheetTable &table, shared_ptr<CSSAtoms> atoms) : myAtoms(atoms) {
+	const std::map<CSSSelector,shared_ptr<ZLTextStyleEntry> > &controls = table.myControlMap;
+	for (std::map<CSSSelector,shared_ptr<ZLTextStyleEntry> >::const_iterator it = controls.begin(); it != controls.end(); ++it) {
+		if (it->second.isNull()) {
+			continue;
+		}
+		const CSSSelector &selector = it->first;
+		std::vector<Rule> &rules = myRules[std::make_pair(atoms->selectorAtom(selector.Tag), atoms->selectorAtom(selector.Class))];
+		rules.push_back(Rule());
+		Rule &rule = rules.back();
+		rule.Entry = it->second;
+		rule.UsesSiblings = false;
+		for (shared_ptr<CSSSelector::Component> next = selector.Next; !next.isNull(); next = next->Selector->Next) {
+			const Step step(next->Delimiter, atoms->selectorAtom(next->Selector->Tag), atoms->selectorAtom(next->Selector->Class));
+			rule.Steps.push_back(step);
+			if (step.Relation == CSSSelector::Previous || step.Relation == CSSSelector::Predecessor) {
+				rule.UsesSiblings = true;
+			}
+			// only these relations lead from a step to an ancestor of the matched element
+			if (step.Relation == CSSSelector::Ancestor || step.Relation == CSSSelector::Parent) {
+				if (step.Tag != CSSAtoms::ANY) {
+					rule.Filter.add(step.Tag, false);
+				}
+				if (step.Class != CSSAtoms::ANY) {
+					rule.Filter.add(step.Class, true);
+				}
+			}
+		}
+	}
+
+	addBreaks(myBreaksBefore, table.myPageBreakBeforeMap, *atoms);
+	addBreaks(myBreaksAfter, table.myPageBreakAfterMap, *atoms);
+}
+
+void CSSSelectorIndex::addBreaks(BreakMap &breaks, const std::map<CSSSelector,bool> &source, CSSAtoms &atoms) {
+	for (std::map<CSSSelector,bool>::const_iterator it = source.begin(); it != source.end(); ++it) {
+		const CSSSelector &selector = it->first;
+		// StyleSheetTable looks up simple selectors only, and never the "*" tag
+		if (selector.Next.isNull() && selector.Tag != "*") {
+			breaks[std::make_pair(atoms.selectorAtom(selector.Tag), atoms.selectorAtom(selector.Class))] = it->second;
+		}
+	}
+}
+
+ZLBoolean3 CSSSelectorIndex::findBreak(const BreakMap &breaks, std::size_t tag, std::size_t clazz) {
+	if (breaks.empty()) {
+		return B3_UNDEFINED;
+	}
+
+	BreakMap::const_iterator it = breaks.find(std::make_pair(tag, clazz));
+	if (it != breaks.end()) {
+		return b3Value(it->second);
+	}
+
+	it = breaks.find(std::make_pair(CSSAtoms::ANY, clazz));
+	if (it != breaks.end()) {
+		return b3Value(it->second);
+	}
+
+	it = breaks.find(std::make_pair(tag, CSSAtoms::ANY));
+	if (it != breaks.end()) {
+		return b3Value(it->second);
+	}
+
+	return B3_UNDEFINED;
+}
+
+const std::vector<CSSSelectorIndex::Rule> *CSSSelectorIndex::rules(std::size_t tag, std::size_t clazz) const {
+	std::map<std::pair<std::size_t,std::size_t>,std::vector<Rule> >::const_iterator it =
+		myRules.find(std::make_pair(tag, clazz));
+	return it != myRules.end() ? &it->second : 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __CSSSELECTORINDEX_H__
+#define __CSSSELECTORINDEX_H__
+
+#include <map>
+#include <vector>
+#include <bitset>
+
+#include <shared_ptr.h>
+#include <ZLBoolean3.h>
+#include <ZLTextStyleEntry.h>
+
+#include "CSSSelector.h"
+#include "CSSAtoms.h"
+
+class StyleSheetTable;
+
+// Bloom filter over tag and class atoms of an element's ancestors
+class CSSAncestorFilter {
+
+public:
+	void add(std::size_t atom, bool isClass);
+	// false means that some of the required atoms are definitely absent
+	bool mayContain(const CSSAncestorFilter &required) const;
+
+private:
+	std::bitset<256> myBits;
+};
+
+// StyleSheetTable compiled into right-to-left match programs over the atoms
+// of one CSSAtoms table; programs are grouped by their rightmost tag and class
+class CSSSelectorIndex {
+
+public:
+	struct Step {
+		Step(CSSSelector::Relation relation, std::size_t tag, std::size_t clazz);
+
+		// relation between this step and the previous (right) one
+		CSSSelector::Relation Relation;
+		// CSSAtoms::ANY for any tag or no class
+		std::size_t Tag;
+		std::size_t Class;
+	};
+
+	struct Rule {
+		// does not include the rightmost selector, that is the index key
+		std::vector<Step> Steps;
+		// atoms of steps that must be matched by ancestors
+		CSSAncestorFilter Filter;
+		// some steps are "+" or "~"
+		bool UsesSiblings;
+		shared_ptr<ZLTextStyleEntry> Entry;
+	};
+
+public:
+	CSSSelectorIndex(const StyleSheetTable &table, shared_ptr<CSSAtoms> atoms);
+
+	// false if the index was built for another atoms table
+	bool usesAtoms(const shared_ptr<CSSAtoms> &atoms) const;
+
+	// rules in StyleSheetTable order, 0 if there are no rules for the key
+	const std::vector<Rule> *rules(std::size_t tag, std::size_t clazz) const;
+	// same lookups as in StyleSheetTable::doBreakBefore/doBreakAfter
+	ZLBoolean3 breakBefore(std::size_t tag, std::size_t clazz) const;
+	ZLBoolean3 breakAfter(std::size_t tag, std::size_t clazz) const;
+
+private:
+	typedef std::map<std::pair<std::size_t,std::size_t>,bool> BreakMap;
+
+	static void addBreaks(BreakMap &breaks, const std::map<CSSSelector,bool> &source, CSSAtoms &atoms);
+	static ZLBoolean3 findBreak(const BreakMap &breaks, std::size_t tag, std::size_t clazz);
+
+private:
+	// weak, so a cached index does not keep the atoms of a finished conversion
+	weak_ptr<CSSAtoms> myAtoms;
+	std::map<std::pair<std::size_t,std::size_t>,std::vector<Rule> > myRules;
+	BreakMap myBreaksBefore;
+	BreakMap myBreaksAfter;
+
+private: // disable copying
+	CSSSelectorIndex(const CSSSelectorIndex&);
+	const CSSSelectorIndex &operator = (const CSSSelectorIndex&);
+};
+
+inline void CSSAncestorFilter::add(std::size_t atom, bool isClass) {
+	const std::size_t hash = (2 * atom + (isClass ? 1 : 0)) * 2654435761U;
+	myBits.set(hash & 0xFF);
+	myBits.set((hash >> 8) & 0xFF);
+}
+
+inline bool CSSAncestorFilter::mayContain(const CSSAncestorFilter &required) const {
+	return (required.myBits & ~myBits).none();
+}
+
+inline CSSSelectorIndex::Step::Step(CSSSelector::Relation relation, std::size_t tag, std::size_t clazz) : Relation(relation), Tag(tag), Class(clazz) {
+}
+
+inline bool CSSSelectorIndex::usesAtoms(const shared_ptr<CSSAtoms> &atoms) const { return myAtoms == atoms; }
+inline ZLBoolean3 CSSSelectorIndex::breakBefore(std::size_t tag, std::size_t clazz) const { return findBreak(myBreaksBefore, tag, clazz); }
+inline ZLBoolean3 CSSSelectorIndex::breakAfter(std::size_t tag, std::size_t clazz) const { return findBreak(myBreaksAfter, tag, clazz); }
+
+#endif /* __CSSSELECTORINDEX_H__ */
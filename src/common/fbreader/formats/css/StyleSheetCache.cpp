@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <ZLFile.h>
+#include <ZLInputStream.h>
+#include <ZLStringPool.h>
+#include <FileEncryptionInfo.h>
+
+#include "StyleSheetCache.h"
+#include "StyleSheetParser.h"
+#include "StyleSheetTable.h"
+
+const std::size_t StyleSheetCache::ourStorageSize = 16;
+StyleSheetCache::SheetEntry *StyleSheetCache::ourSheets =
+	new StyleSheetCache::SheetEntry[StyleSheetCache::ourStorageSize];
+std::size_t StyleSheetCache::ourSheetIndex = 0;
+StyleSheetCache::TableEntry *StyleSheetCache::ourTables =
+	new StyleSheetCache::TableEntry[StyleSheetCache::ourStorageSize];
+std::size_t StyleSheetCache::ourTableIndex = 0;
+
+shared_ptr<StyleSheetParserWithCache> StyleSheetCache::parser(const ZLFile &file, const std::string &pathPrefix, shared_ptr<EncryptionMap> encryptionMap) {
+	shared_ptr<ZLInputStream> stream = file.inputStream(encryptionMap);
+	if (stream.isNull() || !stream->open()) {
+		return new StyleSheetParserWithCache(file, pathPrefix, 0, encryptionMap);
+	}
+	std::string key;
+	char buffer[4096];
+	while (true) {
+		const std::size_t len = stream->read(buffer, sizeof(buffer));
+		if (len == 0) {
+			break;
+		}
+		key.append(buffer, len);
+	}
+	stream->close();
+
+	const std::size_t contentSize = key.size();
+	if (key.find('@') != std::string::npos) {
+		key.append(1, '\0');
+		key.append(pathPrefix);
+	}
+
+	// keys are compared only if their hashes and lengths are equal
+	const unsigned int hash = ZLStringPool::hash(key.data(), key.size());
+	for (std::size_t i = 0; i < ourStorageSize; ++i) {
+		const SheetEntry &entry = ourSheets[i];
+		if (!entry.Parser.isNull() && entry.Hash == hash && entry.Key.size() == key.size() && entry.Key == key) {
+			return entry.Parser;
+		}
+	}
+
+	shared_ptr<StyleSheetParserWithCache> parser =
+		new StyleSheetParserWithCache(file, pathPrefix, 0, encryptionMap);
+	parser->parseString(key.data(), contentSize);
+	SheetEntry &entry = ourSheets[ourSheetIndex];
+	entry.Hash = hash;
+	entry.Key = key;
+	entry.Parser = parser;
+	ourSheetIndex = (ourSheetIndex + 1) % ourStorageSize;
+	return parser;
+}
+
+shared_ptr<StyleSheetTable> StyleSheetCache::table(const std::vector<shared_ptr<StyleSheetParserWithCache> > &sheets) {
+	for (std::size_t i = 0; i < ourStorageSize; ++i) {
+		const TableEntry &entry = ourTables[i];
+		if (!entry.Table.isNull() && entry.Sheets == sheets) {
+			return entry.Table;
+		}
+	}
+
+	shared_ptr<StyleSheetTable> table = new StyleSheetTable();
+	for (std::vector<shared_ptr<StyleSheetParserWithCache> >::const_iterator it = sheets.begin(); it != sheets.end(); ++it) {
+		(*it)->applyToTable(*table);
+	}
+	TableEntry &entry = ourTables[ourTableIndex];
+	entry.Sheets = sheets;
+	entry.Table = table;
+	ourTableIndex = (ourTableIndex + 1) % ourStorageSize;
+	return table;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __STYLESHEETCACHE_H__
+#define __STYLESHEETCACHE_H__
+
+#include <string>
+#include <vector>
+
+#include <shared_ptr.h>
+
+class ZLFile;
+class EncryptionMap;
+class StyleSheetTable;
+class StyleSheetParserWithCache;
+
+// Process-wide storage of parsed stylesheets, looked up by file content,
+// and of tables built from sequences of such stylesheets; a chapter that
+// links the same sheets as a previous one gets the same table and index
+class StyleSheetCache {
+
+public:
+	// a sheet with the same content is shared between files and books;
+	// the directory is a part of the key if the sheet uses @-rules,
+	// since @import and @font-face refer to other files
+	static shared_ptr<StyleSheetParserWithCache> parser(const ZLFile &file, const std::string &pathPrefix, shared_ptr<EncryptionMap> encryptionMap);
+	// the sheets applied in the given order; the table must not be modified
+	static shared_ptr<StyleSheetTable> table(const std::vector<shared_ptr<StyleSheetParserWithCache> > &sheets);
+
+private:
+	struct SheetEntry {
+		unsigned int Hash;
+		std::string Key;
+		shared_ptr<StyleSheetParserWithCache> Parser;
+	};
+
+	struct TableEntry {
+		std::vector<shared_ptr<StyleSheetParserWithCache> > Sheets;
+		shared_ptr<StyleSheetTable> Table;
+	};
+
+	static const std::size_t ourStorageSize;
+	static SheetEntry *ourSheets;
+	static std::size_t ourSheetIndex;
+	static TableEntry *ourTables;
+	static std::size_t ourTableIndex;
+};
+
+#endif /* __STYLESHEETCACHE_H__ */
@@ -41,12 +41,9 @@ StyleSheetParser::~StyleSheetParser() {
 }
 
 void StyleSheetParser::reset() {
-	myWord.erase();
-	myAttributeName.erase();
-	myReadState = WAITING_FOR_SELECTOR;
-	mySelectorString.erase();
-	myMap.clear();
-	myImportVector.clear();
+	myBuffer.erase();
+	mySelector.erase();
+	myDeclarations.clear();
 	myFirstRuleProcessed = false;
 }
 
@@ -57,68 +54,107 @@ void StyleSheetParser::parseString(const char *data, std::size_t len) {
 void StyleSheetParser::parseStream(shared_ptr<ZLInputStream> stream) {
 	stream = new CSSInputStream(stream);
 	if (stream->open()) {
-		char *buffer = new char[1024];
 		while (true) {
-			int len = stream->read(buffer, 1024);
+			const std::size_t offset = myBuffer.size();
+			myBuffer.resize(offset + 8192);
+			const std::size_t len = stream->read(&myBuffer[offset], 8192);
+			myBuffer.resize(offset + len);
 			if (len == 0) {
 				break;
 			}
-			parse(buffer, len);
 		}
-		delete[] buffer;
 		stream->close();
+		parse();
 	}
 }
 
-void StyleSheetParser::parse(const char *text, int len, bool final) {
-	const char *start = text;
-	const char *end = text + len;
-	for (const char *ptr = start; ptr != end; ++ptr) {
-		if (myReadState != ATTRIBUTE_VALUE && std::isspace(*ptr)) {
-			if (start != ptr) {
-				myWord.append(start, ptr - start);
-			}
-			processWord(myWord);
-			myWord.erase();
-			start = ptr + 1;
-		} else if (isControlSymbol(*ptr)) {
-			if (start != ptr) {
-				myWord.append(start, ptr - start);
+static const char *skipSpaces(const char *ptr, const char *end) {
+	while (ptr != end && std::isspace((unsigned char)*ptr)) {
+		++ptr;
+	}
+	return ptr;
+}
+
+static const char *trimEnd(const char *start, const char *end) {
+	while (end != start && std::isspace((unsigned char)end[-1])) {
+		--end;
+	}
+	return end;
+}
+
+// the first of the stop symbols outside of a string, or end;
+// an unterminated string ends at the line break, as in CSS
+static const char *find(const char *ptr, const char *end, const char *stops) {
+	char quote = '\0';
+	for (; ptr != end; ++ptr) {
+		const char ch = *ptr;
+		if (quote != '\0') {
+			if (ch == quote || ch == '\n') {
+				quote = '\0';
 			}
-			processWord(myWord);
-			myWord.erase();
-			processControl(*ptr);
-			start = ptr + 1;
+		} else if (ch == '"' || ch == '\'') {
+			quote = ch;
+		} else if (ch != '\0' && std::strchr(stops, ch) != 0) {
+			return ptr;
 		}
 	}
-	if (start < end) {
-		myWord.append(start, end - start);
-		if (final) {
-			processWord(myWord);
-			myWord.erase();
+	return end;
+}
+
+// the '}' closing a block that starts at ptr, or end
+static const char *findBlockEnd(const char *ptr, const char *end, bool &nested) {
+	nested = false;
+	int depth = 0;
+	while (true) {
+		ptr = find(ptr, end, "{}");
+		if (ptr == end) {
+			return end;
 		}
+		if (*ptr == '{') {
+			nested = true;
+			++depth;
+		} else if (depth == 0) {
+			return ptr;
+		} else {
+			--depth;
+		}
+		++ptr;
 	}
 }
 
-bool StyleSheetParser::isControlSymbol(const char symbol) {
-	switch (myReadState) {
-		default:
-		case WAITING_FOR_SELECTOR:
-			return false;
-		case SELECTOR:
-			return symbol == '{' || symbol == ';';
-		case IMPORT:
-			return symbol == ';';
-		case WAITING_FOR_ATTRIBUTE:
-			return symbol == '}' || symbol == ':';
-		case ATTRIBUTE_NAME:
-			return symbol == ':';
-		case ATTRIBUTE_VALUE:
-			return symbol == '}' || symbol == ';';
+void StyleSheetParser::parse() {
+	const char *start = myBuffer.data();
+	const char *end = start + myBuffer.size();
+	const char *ptr = start;
+	while (true) {
+		ptr = skipSpaces(ptr, end);
+		const char *stop = find(ptr, end, "{;}");
+		if (stop == end) {
+			break;
+		}
+		if (*stop == '{') {
+			bool nested;
+			const char *blockEnd = findBlockEnd(stop + 1, end, nested);
+			if (blockEnd == end) {
+				break;
+			}
+			myFirstRuleProcessed = true;
+			// rules inside @media and similar blocks are not supported
+			if (!nested) {
+				processRule(ptr, stop, stop + 1, blockEnd);
+			}
+			ptr = blockEnd + 1;
+		} else {
+			if (*stop == ';') {
+				processStatement(ptr, stop);
+			}
+			ptr = stop + 1;
+		}
 	}
+	myBuffer.erase(0, ptr - start);
 }
 
-void StyleSheetParser::storeData(const std::string&, const StyleSheetTable::AttributeMap&) {
+void StyleSheetParser::storeData(const std::string&, const CSSDeclarationList&) {
 }
 
 std::string StyleSheetParser::url2FullPath(const std::string &url) const {
@@ -136,102 +172,66 @@ std::string StyleSheetParser::url2FullPath(const std::string &url) const {
 void StyleSheetParser::importCSS(const std::string&) {
 }
 
-void StyleSheetParser::processControl(const char control) {
-	switch (myReadState) {
-		case WAITING_FOR_SELECTOR:
-			break;
-		case SELECTOR:
-			switch (control) {
-				case '{':
-					myReadState = WAITING_FOR_ATTRIBUTE;
-					myFirstRuleProcessed = true;
-					break;
-				case ';':
-					myReadState = WAITING_FOR_SELECTOR;
-					mySelectorString.erase();
-					break;
-			}
-			break;
-		case IMPORT:
-			if (control == ';') {
-				if (!myImportVector.empty()) {
-					if (myFirstRuleProcessed) {
-						ZLLogger::Instance().println(
-							"CSS-IMPORT", "Ignore import after style rule " + myImportVector[0]
-						);
-					} else {
-						importCSS(url2FullPath(myImportVector[0]));
-					}
-					myImportVector.clear();
-				}
-				myReadState = WAITING_FOR_SELECTOR;
-			}
-			break;
-		case WAITING_FOR_ATTRIBUTE:
-			if (control == '}') {
-				myReadState = WAITING_FOR_SELECTOR;
-				storeData(mySelectorString, myMap);
-				mySelectorString.erase();
-				myMap.clear();
-			}
-			break;
-		case ATTRIBUTE_NAME:
-			if (control == ':') {
-				myReadState = ATTRIBUTE_VALUE;
-			}
-			break;
-		case ATTRIBUTE_VALUE:
-			if (control == ';') {
-				myReadState = WAITING_FOR_ATTRIBUTE;
-			} else if (control == '}') {
-				myReadState = WAITING_FOR_SELECTOR;
-				storeData(mySelectorString, myMap);
-				mySelectorString.erase();
-				myMap.clear();
-			}
-			break;
+void StyleSheetParser::processStatement(const char *start, const char *end) {
+	static const std::size_t IMPORT_LENGTH = 7;
+	if ((std::size_t)(end - start) <= IMPORT_LENGTH || std::strncmp(start, "@import", IMPORT_LENGTH) != 0) {
+		return;
+	}
+	const char *urlStart = skipSpaces(start + IMPORT_LENGTH, end);
+	const char *urlEnd = urlStart;
+	while (urlEnd != end && !std::isspace((unsigned char)*urlEnd)) {
+		++urlEnd;
+	}
+	if (urlStart == urlEnd) {
+		return;
+	}
+	const std::string url(urlStart, urlEnd - urlStart);
+	if (myFirstRuleProcessed) {
+		ZLLogger::Instance().println("CSS-IMPORT", "Ignore import after style rule " + url);
+	} else {
+		importCSS(url2FullPath(url));
 	}
 }
 
-void StyleSheetParser::processWord(const std::string &word) {
-	if (word.empty()) {
-		return;
+void StyleSheetParser::processRule(const char *selectorStart, const char *selectorEnd, const char *blockStart, const char *blockEnd) {
+	// words of the selector joined by single spaces
+	mySelector.erase();
+	for (const char *ptr = skipSpaces(selectorStart, selectorEnd); ptr != selectorEnd; ptr = skipSpaces(ptr, selectorEnd)) {
+		const char *wordStart = ptr;
+		while (ptr != selectorEnd && !std::isspace((unsigned char)*ptr)) {
+			++ptr;
+		}
+		if (!mySelector.empty()) {
+			mySelector += ' ';
+		}
+		mySelector.append(wordStart, ptr - wordStart);
 	}
 
-	switch (myReadState) {
-		case WAITING_FOR_SELECTOR:
-			mySelectorString = word;
-			if (word == "@import") {
-				myReadState = IMPORT;
-			} else {
-				myReadState = SELECTOR;
-			}
-			break;
-		case SELECTOR:
-			mySelectorString += ' ' + word;
-			break;
-		case IMPORT:
-			myImportVector.push_back(word);
-			break;
-		case WAITING_FOR_ATTRIBUTE:
-			myReadState = ATTRIBUTE_NAME;
-			// go through
-		case ATTRIBUTE_NAME:
-			myAttributeName = word;
-			myMap[myAttributeName].clear();
-			break;
-		case ATTRIBUTE_VALUE:
-		{
-			std::string stripped = word;
-			ZLStringUtil::stripWhiteSpaces(stripped);
-			std::string &current = myMap[myAttributeName];
-			if (current.size() == 0) {
-				current = stripped;
-			} else {
-				current += ' ' + stripped;
+	myDeclarations.clear();
+	parseDeclarations(blockStart, blockEnd);
+	storeData(mySelector, myDeclarations);
+}
+
+void StyleSheetParser::parseDeclarations(const char *start, const char *end) {
+	while (true) {
+		const char *stop = find(start, end, ";");
+		const char *colon = find(start, stop, ":");
+		if (colon != stop) {
+			const char *nameStart = skipSpaces(start, colon);
+			const char *nameEnd = trimEnd(nameStart, colon);
+			if (nameStart != nameEnd) {
+				const char *valueStart = skipSpaces(colon + 1, stop);
+				const char *valueEnd = trimEnd(valueStart, stop);
+				myDeclarations.add(
+					CSSDeclarationList::property(nameStart, nameEnd - nameStart),
+					valueStart, valueEnd - valueStart
+				);
 			}
+		}
+		if (stop == end) {
 			break;
 		}
+		start = stop + 1;
 	}
 }
 
@@ -239,9 +239,10 @@ StyleSheetSingleStyleParser::StyleSheetSingleStyleParser(const std::string &path
 }
 
 shared_ptr<ZLTextStyleEntry> StyleSheetSingleStyleParser::parseSingleEntry(const char *text) {
-	myReadState = WAITING_FOR_ATTRIBUTE;
-	parse(text, std::strlen(text), true);
-	shared_ptr<ZLTextStyleEntry> control = StyleSheetTable::createOrUpdateControl(myMap);
+	const char *end = text + std::strlen(text);
+	myDeclarations.clear();
+	parseDeclarations(text, find(text, end, "}"));
+	shared_ptr<ZLTextStyleEntry> control = StyleSheetTable::createOrUpdateControl(myDeclarations);
 	reset();
 	return control;
 }
@@ -249,7 +250,7 @@ shared_ptr<ZLTextStyleEntry> StyleSheetSingleStyleParser::parseSingleEntry(const
 StyleSheetMultiStyleParser::StyleSheetMultiStyleParser(const std::string &pathPrefix, shared_ptr<FontMap> fontMap, shared_ptr<EncryptionMap> encryptionMap) : StyleSheetParser(pathPrefix), myFontMap(fontMap.isNull() ? new FontMap() : fontMap), myEncryptionMap(encryptionMap) {
 }
 
-void StyleSheetMultiStyleParser::storeData(const std::string &selector, const StyleSheetTable::AttributeMap &map) {
+void StyleSheetMultiStyleParser::storeData(const std::string &selector, const CSSDeclarationList &declarations) {
 	std::string s = selector;
 	ZLStringUtil::stripWhiteSpaces(s);
 
@@ -258,7 +259,7 @@ void StyleSheetMultiStyleParser::storeData(const std::string &selector, const St
 	}
 
 	if (s[0] == '@') {
-		processAtRule(s, map);
+		processAtRule(s, declarations);
 		return;
 	}
 
@@ -266,34 +267,26 @@ void StyleSheetMultiStyleParser::storeData(const std::string &selector, const St
 	for (std::vector<std::string>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
 		shared_ptr<CSSSelector> selector = CSSSelector::parse(*it);
 		if (!selector.isNull()) {
-			store(selector, map);
+			store(selector, declarations);
 		}
 	}
 }
 
-static std::string value(const StyleSheetTable::AttributeMap &map, const std::string &key) {
-	const StyleSheetTable::AttributeMap::const_iterator it = map.find(key);
-	if (it == map.end() || it->second.empty()) {
-		return std::string();
-	}
-	return it->second;
-}
-
-void StyleSheetMultiStyleParser::processAtRule(const std::string &name, const StyleSheetTable::AttributeMap &attributes) {
+void StyleSheetMultiStyleParser::processAtRule(const std::string &name, const CSSDeclarationList &declarations) {
 	//ZLLogger::Instance().registerClass("FONT");
 	if (name == "@font-face") {
-		std::string family = value(attributes, "font-family");
+		std::string family = declarations.value(CSSDeclarationList::FONT_FAMILY).str();
 		if (family.empty()) {
 			ZLLogger::Instance().println("FONT", "Font family not specified in @font-face entry");
 			return;
 		}
 		family = StyleSheetUtil::strip(family);
 
-		const StyleSheetTable::AttributeMap::const_iterator it = attributes.find("src");
+		const CSSDeclarationList::Value src = declarations.value(CSSDeclarationList::SRC);
 		std::string path;
-		if (it != attributes.end()) {
+		if (!src.empty()) {
 			// TODO: better split
-			const std::vector<std::string> ids = ZLStringUtil::split(it->second, " ", true);
+			const std::vector<std::string> ids = ZLStringUtil::split(src.str(), " ", true);
 			for (std::vector<std::string>::const_iterator jt = ids.begin(); jt != ids.end(); ++jt) {
 				if (ZLStringUtil::stringStartsWith(*jt, "url(") &&
 						ZLStringUtil::stringEndsWith(*jt, ")")) {
@@ -307,9 +300,9 @@ void StyleSheetMultiStyleParser::processAtRule(const std::string &name, const St
 			return;
 		}
 
-		const std::string weight = value(attributes, "font-weight");
+		const std::string weight = declarations.value(CSSDeclarationList::FONT_WEIGHT).str();
 		const int weightNum = ZLStringUtil::parseDecimal(weight, -1);
-		const std::string style = value(attributes, "font-style");
+		const CSSDeclarationList::Value style = declarations.value(CSSDeclarationList::FONT_STYLE);
 
 		myFontMap->append(
 			family,
@@ -324,16 +317,16 @@ void StyleSheetMultiStyleParser::processAtRule(const std::string &name, const St
 StyleSheetTableParser::StyleSheetTableParser(const std::string &pathPrefix, StyleSheetTable &styleTable, shared_ptr<FontMap> fontMap, shared_ptr<EncryptionMap> encryptionMap) : StyleSheetMultiStyleParser(pathPrefix, fontMap, encryptionMap), myStyleTable(styleTable) {
 }
 
-void StyleSheetTableParser::store(shared_ptr<CSSSelector> selector, const StyleSheetTable::AttributeMap &map) {
-	myStyleTable.addMap(selector, map);
+void StyleSheetTableParser::store(shared_ptr<CSSSelector> selector, const CSSDeclarationList &declarations) {
+	myStyleTable.addMap(selector, declarations);
 }
 
 StyleSheetParserWithCache::StyleSheetParserWithCache(const ZLFile &file, const std::string &pathPrefix, shared_ptr<FontMap> fontMap, shared_ptr<EncryptionMap> encryptionMap) : StyleSheetMultiStyleParser(pathPrefix, fontMap, encryptionMap) {
 	myProcessedFiles.insert(file.path());
 }
 
-void StyleSheetParserWithCache::store(shared_ptr<CSSSelector> selector, const StyleSheetTable::AttributeMap &map) {
-	myEntries.push_back(new Entry(selector, map));
+void StyleSheetParserWithCache::store(shared_ptr<CSSSelector> selector, const CSSDeclarationList &declarations) {
+	myEntries.push_back(new Entry(selector, declarations));
 }
 
 void StyleSheetParserWithCache::importCSS(const std::string &path) {
@@ -356,9 +349,17 @@ void StyleSheetParserWithCache::importCSS(const std::string &path) {
 }
 
 void StyleSheetParserWithCache::applyToTables(StyleSheetTable &table, FontMap &fontMap) const {
+	applyToTable(table);
+	applyToFontMap(fontMap);
+}
+
+void StyleSheetParserWithCache::applyToTable(StyleSheetTable &table) const {
 	for (std::list<shared_ptr<Entry> >::const_iterator it = myEntries.begin(); it != myEntries.end(); ++it) {
 		const Entry &entry = **it;
-		table.addMap(entry.Selector, entry.Map);
+		table.addMap(entry.Selector, entry.Declarations);
 	}
+}
+
+void StyleSheetParserWithCache::applyToFontMap(FontMap &fontMap) const {
 	fontMap.merge(*myFontMap);
 }
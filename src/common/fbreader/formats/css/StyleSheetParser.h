@@ -28,6 +28,7 @@
 
 #include "StyleSheetTable.h"
 #include "CSSSelector.h"
+#include "CSSDeclarationList.h"
 #include "FontMap.h"
 
 class ZLFile;
@@ -45,33 +46,24 @@ public:
 	void parseString(const char *data, std::size_t len);
 
 protected:
-	virtual void storeData(const std::string &selector, const StyleSheetTable::AttributeMap &map);
+	virtual void storeData(const std::string &selector, const CSSDeclarationList &declarations);
 	std::string url2FullPath(const std::string &url) const;
 	virtual void importCSS(const std::string &path);
 
 private:
-	void parse(const char *text, int len, bool final = false);
-	bool isControlSymbol(const char symbol);
-	void processWord(const std::string &word);
-	void processControl(const char control);
+	// handles all complete statements in myBuffer and keeps the rest
+	void parse();
+	void processStatement(const char *start, const char *end);
+	void processRule(const char *selectorStart, const char *selectorEnd, const char *blockStart, const char *blockEnd);
+	void parseDeclarations(const char *start, const char *end);
 
 protected:
 	const std::string myPathPrefix;
 
 private:
-	std::string myWord;
-	std::string myAttributeName;
-	enum {
-		WAITING_FOR_SELECTOR,
-		SELECTOR,
-		IMPORT,
-		WAITING_FOR_ATTRIBUTE,
-		ATTRIBUTE_NAME,
-		ATTRIBUTE_VALUE,
-	} myReadState;
-	std::string mySelectorString;
-	StyleSheetTable::AttributeMap myMap;
-	std::vector<std::string> myImportVector;
+	std::string myBuffer;
+	std::string mySelector;
+	CSSDeclarationList myDeclarations;
 	bool myFirstRuleProcessed;
 
 friend class StyleSheetSingleStyleParser;
@@ -90,11 +82,11 @@ protected:
 	StyleSheetMultiStyleParser(const std::string &pathPrefix, shared_ptr<FontMap> fontMap, shared_ptr<EncryptionMap> encryptionMap);
 
 protected:
-	virtual void store(shared_ptr<CSSSelector> selector, const StyleSheetTable::AttributeMap &map) = 0;
+	virtual void store(shared_ptr<CSSSelector> selector, const CSSDeclarationList &declarations) = 0;
 
 private:
-	void storeData(const std::string &selector, const StyleSheetTable::AttributeMap &map);
-	void processAtRule(const std::string &name, const StyleSheetTable::AttributeMap &map);
+	void storeData(const std::string &selector, const CSSDeclarationList &declarations);
+	void processAtRule(const std::string &name, const CSSDeclarationList &declarations);
 
 protected:
 	shared_ptr<FontMap> myFontMap;
@@ -107,7 +99,7 @@ public:
 	StyleSheetTableParser(const std::string &pathPrexix, StyleSheetTable &styleTable, shared_ptr<FontMap> fontMap, shared_ptr<EncryptionMap> encryptionMap);
 
 private:
-	void store(shared_ptr<CSSSelector> selector, const StyleSheetTable::AttributeMap &map);
+	void store(shared_ptr<CSSSelector> selector, const CSSDeclarationList &declarations);
 
 private:
 	StyleSheetTable &myStyleTable;
@@ -118,17 +110,19 @@ class StyleSheetParserWithCache : public StyleSheetMultiStyleParser {
 private:
 	struct Entry {
 		shared_ptr<CSSSelector> Selector;
-		const StyleSheetTable::AttributeMap Map;
+		const CSSDeclarationList Declarations;
 
-		Entry(shared_ptr<CSSSelector> selector, const StyleSheetTable::AttributeMap &map);
+		Entry(shared_ptr<CSSSelector> selector, const CSSDeclarationList &declarations);
 	};
 
 public:
 	StyleSheetParserWithCache(const ZLFile &file, const std::string &pathPrefix, shared_ptr<FontMap> fontMap, shared_ptr<EncryptionMap> encryptionMap);
 	void applyToTables(StyleSheetTable &table, FontMap &fontMap) const;
+	void applyToTable(StyleSheetTable &table) const;
+	void applyToFontMap(FontMap &fontMap) const;
 
 private:
-	void store(shared_ptr<CSSSelector> selector, const StyleSheetTable::AttributeMap &map);
+	void store(shared_ptr<CSSSelector> selector, const CSSDeclarationList &declarations);
 	void importCSS(const std::string &path);
 
 private:
@@ -136,7 +130,7 @@ private:
 	std::set<std::string> myProcessedFiles;
 };
 
-inline StyleSheetParserWithCache::Entry::Entry(shared_ptr<CSSSelector> selector, const StyleSheetTable::AttributeMap &map) : Selector(selector), Map(map) {
+inline StyleSheetParserWithCache::Entry::Entry(shared_ptr<CSSSelector> selector, const CSSDeclarationList &declarations) : Selector(selector), Declarations(declarations) {
 }
 
 #endif /* __STYLESHEETPARSER_H__ */
@@ -17,7 +17,7 @@
  * 02110-1301, USA.
  */
 
-#include <cstdlib>
+#include <cctype>
 
 #include <ZLStringUtil.h>
 
@@ -29,19 +29,20 @@ bool StyleSheetTable::isEmpty() const {
 	return myControlMap.empty() && myPageBreakBeforeMap.empty() && myPageBreakAfterMap.empty();
 }
 
-void StyleSheetTable::addMap(shared_ptr<CSSSelector> selectorPtr, const AttributeMap &map) {
-	if (!selectorPtr.isNull() && !map.empty()) {
+void StyleSheetTable::addMap(shared_ptr<CSSSelector> selectorPtr, const CSSDeclarationList &declarations) {
+	if (!selectorPtr.isNull() && !declarations.empty()) {
 		const CSSSelector &selector = *selectorPtr;
-		myControlMap[selector] = createOrUpdateControl(map, myControlMap[selector]);
+		myIndex.reset();
+		myControlMap[selector] = createOrUpdateControl(declarations, myControlMap[selector]);
 
-		const std::string &pbb = value(map, "page-break-before");
+		const CSSDeclarationList::Value pbb = declarations.value(CSSDeclarationList::PAGE_BREAK_BEFORE);
 		if (pbb == "always" || pbb == "left" || pbb == "right") {
 			myPageBreakBeforeMap[selector] = true;
 		} else if (pbb == "avoid") {
 			myPageBreakBeforeMap[selector] = false;
 		}
 
-		const std::string &pba = value(map, "page-break-after");
+		const CSSDeclarationList::Value pba = declarations.value(CSSDeclarationList::PAGE_BREAK_AFTER);
 		if (pba == "always" || pba == "left" || pba == "right") {
 			myPageBreakAfterMap[selector] = true;
 		} else if (pba == "avoid") {
@@ -50,40 +51,74 @@ void StyleSheetTable::addMap(shared_ptr<CSSSelector> selectorPtr, const Attribut
 	}
 }
 
-static bool parseLength(const std::string &toParse, short &size, ZLTextStyleEntry::SizeUnit &unit) {
-	if (toParse == "0") {
+// reads the number and the unit in one pass; lengths without a unit
+// are accepted for zero only
+static bool parseLength(const CSSDeclarationList::Value &value, short &size, ZLTextStyleEntry::SizeUnit &unit) {
+	const char *ptr = value.Data;
+	const char *end = ptr + value.Length;
+	bool negative = false;
+	if (ptr != end && (*ptr == '-' || *ptr == '+')) {
+		negative = *ptr == '-';
+		++ptr;
+	}
+
+	// the digits make an exact integer and the divisor an exact power of
+	// ten, so the quotient is the same double std::atof would return
+	double mantissa = 0;
+	double divisor = 1;
+	bool hasDigits = false;
+	bool hasPoint = false;
+	for (; ptr != end; ++ptr) {
+		const char ch = *ptr;
+		if (ch >= '0' && ch <= '9') {
+			mantissa = 10 * mantissa + (ch - '0');
+			if (hasPoint) {
+				divisor *= 10;
+			}
+			hasDigits = true;
+		} else if (ch == '.' && !hasPoint) {
+			hasPoint = true;
+		} else {
+			break;
+		}
+	}
+	if (!hasDigits) {
+		return false;
+	}
+	const double number = negative ? -mantissa / divisor : mantissa / divisor;
+
+	const CSSDeclarationList::Value suffix(ptr, end - ptr);
+	if (suffix.empty()) {
+		if (number != 0) {
+			return false;
+		}
 		unit = ZLTextStyleEntry::SIZE_UNIT_PIXEL;
 		size = 0;
-		return true;
-	} else if (ZLStringUtil::stringEndsWith(toParse, "%")) {
+	} else if (suffix == "%") {
 		unit = ZLTextStyleEntry::SIZE_UNIT_PERCENT;
-		size = std::atoi(toParse.c_str());
-		return true;
-	} else if (ZLStringUtil::stringEndsWith(toParse, "rem")) {
+		size = (short)(int)number;
+	} else if (suffix == "rem") {
 		unit = ZLTextStyleEntry::SIZE_UNIT_REM_100;
-		size = (short)(100 * ZLStringUtil::stringToDouble(toParse, 0));
-		return true;
-	} else if (ZLStringUtil::stringEndsWith(toParse, "em")) {
+		size = (short)(100 * number);
+	} else if (suffix == "em") {
 		unit = ZLTextStyleEntry::SIZE_UNIT_EM_100;
-		size = (short)(100 * ZLStringUtil::stringToDouble(toParse, 0));
-		return true;
-	} else if (ZLStringUtil::stringEndsWith(toParse, "ex")) {
+		size = (short)(100 * number);
+	} else if (suffix == "ex") {
 		unit = ZLTextStyleEntry::SIZE_UNIT_EX_100;
-		size = (short)(100 * ZLStringUtil::stringToDouble(toParse, 0));
-		return true;
-	} else if (ZLStringUtil::stringEndsWith(toParse, "px")) {
+		size = (short)(100 * number);
+	} else if (suffix == "px") {
 		unit = ZLTextStyleEntry::SIZE_UNIT_PIXEL;
-		size = std::atoi(toParse.c_str());
-		return true;
-	} else if (ZLStringUtil::stringEndsWith(toParse, "pt")) {
+		size = (short)(int)number;
+	} else if (suffix == "pt") {
 		unit = ZLTextStyleEntry::SIZE_UNIT_POINT;
-		size = std::atoi(toParse.c_str());
-		return true;
+		size = (short)(int)number;
+	} else {
+		return false;
 	}
-	return false;
+	return true;
 }
 
-static bool trySetLength(ZLTextStyleEntry &entry, ZLTextStyleEntry::Feature featureId, const std::string &value) {
+static bool trySetLength(ZLTextStyleEntry &entry, ZLTextStyleEntry::Feature featureId, const CSSDeclarationList::Value &value) {
 	short size;
 	ZLTextStyleEntry::SizeUnit unit;
 	if (::parseLength(value, size, unit)) {
@@ -93,11 +128,49 @@ static bool trySetLength(ZLTextStyleEntry &entry, ZLTextStyleEntry::Feature feat
 	return false;
 }
 
-void StyleSheetTable::setLength(ZLTextStyleEntry &entry, ZLTextStyleEntry::Feature featureId, const AttributeMap &map, const std::string &attributeName) {
-	StyleSheetTable::AttributeMap::const_iterator it = map.find(attributeName);
-	if (it != map.end()) {
-		::trySetLength(entry, featureId, it->second);
-		return;
+// "margin" and "padding" shorthands: top, right, bottom and left lengths
+// with the usual rules for the omitted ones
+static void setLengths(ZLTextStyleEntry &entry, const CSSDeclarationList::Value &value, ZLTextStyleEntry::Feature top, ZLTextStyleEntry::Feature right, ZLTextStyleEntry::Feature bottom, ZLTextStyleEntry::Feature left) {
+	CSSDeclarationList::Value parts[4];
+	std::size_t count = 0;
+	const char *ptr = value.Data;
+	const char *end = ptr + value.Length;
+	while (count < 4) {
+		while (ptr != end && std::isspace((unsigned char)*ptr)) {
+			++ptr;
+		}
+		if (ptr == end) {
+			break;
+		}
+		const char *start = ptr;
+		while (ptr != end && !std::isspace((unsigned char)*ptr)) {
+			++ptr;
+		}
+		parts[count++] = CSSDeclarationList::Value(start, ptr - start);
+	}
+	switch (count) {
+		case 0:
+			return;
+		case 1:
+			parts[1] = parts[0];
+			// go through
+		case 2:
+			parts[2] = parts[0];
+			// go through
+		case 3:
+			parts[3] = parts[1];
+			break;
+	}
+	::trySetLength(entry, top, parts[0]);
+	::trySetLength(entry, right, parts[1]);
+	::trySetLength(entry, bottom, parts[2]);
+	::trySetLength(entry, left, parts[3]);
+}
+
+void StyleSheetTable::setLength(ZLTextStyleEntry &entry, ZLTextStyleEntry::Feature featureId, const CSSDeclarationList &declarations, CSSDeclarationList::Property property) {
+	const CSSDeclarationList::Value value = declarations.value(property);
+	if (!value.empty()) {
+		::trySetLength(entry, featureId, value);
 	}
 }
 
@@ -157,21 +230,19 @@ std::vector<std::pair<CSSSelector,shared_ptr<ZLTextStyleEntry> > > StyleSheetTab
 	return pairs;
 }
 
-const std::string &StyleSheetTable::value(const AttributeMap &map, const std::string &name) {
-	const AttributeMap::const_iterator it = map.find(name);
-	if (it != map.end()) {
-		return it->second;
+shared_ptr<CSSSelectorIndex> StyleSheetTable::index(shared_ptr<CSSAtoms> atoms) const {
+	if (myIndex.isNull() || !myIndex->usesAtoms(atoms)) {
+		myIndex = new CSSSelectorIndex(*this, atoms);
 	}
-	static const std::string emptyString;
-	return emptyString;
+	return myIndex;
 }
 
-shared_ptr<ZLTextStyleEntry> StyleSheetTable::createOrUpdateControl(const AttributeMap &styles, shared_ptr<ZLTextStyleEntry> entry) {
+shared_ptr<ZLTextStyleEntry> StyleSheetTable::createOrUpdateControl(const CSSDeclarationList &styles, shared_ptr<ZLTextStyleEntry> entry) {
 	if (entry.isNull()) {
 		entry = new ZLTextStyleEntry(ZLTextStyleEntry::STYLE_CSS_ENTRY);
 	}
 
-	const std::string &alignment = value(styles, "text-align");
+	const CSSDeclarationList::Value alignment = styles.value(CSSDeclarationList::TEXT_ALIGN);
 	if (alignment == "justify") {
 		entry->setAlignmentType(ALIGN_JUSTIFY);
 	} else if (alignment == "left") {
@@ -182,7 +253,7 @@ shared_ptr<ZLTextStyleEntry> StyleSheetTable::createOrUpdateControl(const Attrib
 		entry->setAlignmentType(ALIGN_CENTER);
 	}
 
-	const std::string &deco = value(styles, "text-decoration");
+	const CSSDeclarationList::Value deco = styles.value(CSSDeclarationList::TEXT_DECORATION);
 	if (deco == "underline") {
 		entry->setFontModifier(ZLTextStyleEntry::FONT_MODIFIER_UNDERLINED, true);
 	} else if (deco == "line-through") {
@@ -192,7 +263,7 @@ shared_ptr<ZLTextStyleEntry> StyleSheetTable::createOrUpdateControl(const Attrib
 		entry->setFontModifier(ZLTextStyleEntry::FONT_MODIFIER_STRIKEDTHROUGH, false);
 	}
 
-	const std::string bold = value(styles, "font-weight");
+	const CSSDeclarationList::Value bold = styles.value(CSSDeclarationList::FONT_WEIGHT);
 	if (!bold.empty()) {
 		int num = -1;
 		if (bold == "bold") {
@@ -204,29 +275,29 @@ shared_ptr<ZLTextStyleEntry> StyleSheetTable::createOrUpdateControl(const Attrib
 		} else if (bold == "lighter") {
 			// TODO: implement
 		} else {
-			num = ZLStringUtil::parseDecimal(bold, -1);
+			num = ZLStringUtil::parseDecimal(bold.str(), -1);
 		}
 		if (num != -1) {
 			entry->setFontModifier(ZLTextStyleEntry::FONT_MODIFIER_BOLD, num >= 600);
 		}
 	}
 
-	const std::string &italic = value(styles, "font-style");
+	const CSSDeclarationList::Value italic = styles.value(CSSDeclarationList::FONT_STYLE);
 	if (!italic.empty()) {
 		entry->setFontModifier(ZLTextStyleEntry::FONT_MODIFIER_ITALIC, italic == "italic" || italic == "oblique");
 	}
 
-	const std::string &variant = value(styles, "font-variant");
+	const CSSDeclarationList::Value variant = styles.value(CSSDeclarationList::FONT_VARIANT);
 	if (!variant.empty()) {
 		entry->setFontModifier(ZLTextStyleEntry::FONT_MODIFIER_SMALLCAPS, variant == "small-caps");
 	}
 
-	const std::string &fontFamily = value(styles, "font-family");
+	const CSSDeclarationList::Value fontFamily = styles.value(CSSDeclarationList::FONT_FAMILY);
 	if (!fontFamily.empty()) {
-		entry->setFontFamilies(StyleSheetUtil::splitCommaSeparatedList(fontFamily));
+		entry->setFontFamilies(StyleSheetUtil::splitCommaSeparatedList(fontFamily.str()));
 	}
 
-	const std::string &fontSize = value(styles, "font-size");
+	const CSSDeclarationList::Value fontSize = styles.value(CSSDeclarationList::FONT_SIZE);
 	if (!fontSize.empty()) {
 		bool doSetFontSize = true;
 		short size = 100;
@@ -262,59 +333,33 @@ shared_ptr<ZLTextStyleEntry> StyleSheetTable::createOrUpdateControl(const Attrib
 		}
 	}
 
-	const std::string margin = value(styles, "margin");
-	if (!margin.empty()) {
-		std::vector<std::string> split = ZLStringUtil::split(margin, " ", true);
-		if (split.size() > 0) {
-			switch (split.size()) {
-				case 1:
-					split.push_back(split[0]);
-					// go through
-				case 2:
-					split.push_back(split[0]);
-					// go through
-				case 3:
-					split.push_back(split[1]);
-					break;
-			}
-		}
-		::trySetLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_BEFORE, split[0]);
-		::trySetLength(*entry, ZLTextStyleEntry::LENGTH_MARGIN_RIGHT, split[1]);
-		::trySetLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_AFTER, split[2]);
-		::trySetLength(*entry, ZLTextStyleEntry::LENGTH_MARGIN_LEFT, split[3]);
-	}
-	const std::string padding = value(styles, "padding");
-	if (!padding.empty()) {
-		std::vector<std::string> split = ZLStringUtil::split(padding, " ", true);
-		if (split.size() > 0) {
-			switch (split.size()) {
-				case 1:
-					split.push_back(split[0]);
-					// go through
-				case 2:
-					split.push_back(split[0]);
-					// go through
-				case 3:
-					split.push_back(split[1]);
-					break;
-			}
-		}
-		::trySetLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_BEFORE, split[0]);
-		::trySetLength(*entry, ZLTextStyleEntry::LENGTH_PADDING_RIGHT, split[1]);
-		::trySetLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_AFTER, split[2]);
-		::trySetLength(*entry, ZLTextStyleEntry::LENGTH_PADDING_LEFT, split[3]);
-	}
-	setLength(*entry, ZLTextStyleEntry::LENGTH_MARGIN_LEFT, styles, "margin-left");
-	setLength(*entry, ZLTextStyleEntry::LENGTH_MARGIN_RIGHT, styles, "margin-right");
-	setLength(*entry, ZLTextStyleEntry::LENGTH_PADDING_LEFT, styles, "padding-left");
-	setLength(*entry, ZLTextStyleEntry::LENGTH_PADDING_RIGHT, styles, "padding-right");
-	setLength(*entry, ZLTextStyleEntry::LENGTH_FIRST_LINE_INDENT, styles, "text-indent");
-	setLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_BEFORE, styles, "margin-top");
-	setLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_BEFORE, styles, "padding-top");
-	setLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_AFTER, styles, "margin-bottom");
-	setLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_AFTER, styles, "padding-bottom");
-
-	const std::string verticalAlign = value(styles, "vertical-align");
+	const CSSDeclarationList::Value margin = styles.value(CSSDeclarationList::MARGIN);
+	setLengths(
+		*entry, margin,
+		ZLTextStyleEntry::LENGTH_SPACE_BEFORE,
+		ZLTextStyleEntry::LENGTH_MARGIN_RIGHT,
+		ZLTextStyleEntry::LENGTH_SPACE_AFTER,
+		ZLTextStyleEntry::LENGTH_MARGIN_LEFT
+	);
+	const CSSDeclarationList::Value padding = styles.value(CSSDeclarationList::PADDING);
+	setLengths(
+		*entry, padding,
+		ZLTextStyleEntry::LENGTH_SPACE_BEFORE,
+		ZLTextStyleEntry::LENGTH_PADDING_RIGHT,
+		ZLTextStyleEntry::LENGTH_SPACE_AFTER,
+		ZLTextStyleEntry::LENGTH_PADDING_LEFT
+	);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_MARGIN_LEFT, styles, CSSDeclarationList::MARGIN_LEFT);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_MARGIN_RIGHT, styles, CSSDeclarationList::MARGIN_RIGHT);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_PADDING_LEFT, styles, CSSDeclarationList::PADDING_LEFT);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_PADDING_RIGHT, styles, CSSDeclarationList::PADDING_RIGHT);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_FIRST_LINE_INDENT, styles, CSSDeclarationList::TEXT_INDENT);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_BEFORE, styles, CSSDeclarationList::MARGIN_TOP);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_BEFORE, styles, CSSDeclarationList::PADDING_TOP);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_AFTER, styles, CSSDeclarationList::MARGIN_BOTTOM);
+	setLength(*entry, ZLTextStyleEntry::LENGTH_SPACE_AFTER, styles, CSSDeclarationList::PADDING_BOTTOM);
+
+	const CSSDeclarationList::Value verticalAlign = styles.value(CSSDeclarationList::VERTICAL_ALIGN);
 	if (!verticalAlign.empty()) {
 		static const char* values[] = { "sub", "super", "top", "text-top", "middle", "bottom", "text-bottom", "initial", "inherit" };
 		int index = sizeof(values) / sizeof(const char*) - 1;
@@ -330,7 +375,7 @@ shared_ptr<ZLTextStyleEntry> StyleSheetTable::createOrUpdateControl(const Attrib
 		}
 	}
 
-	entry->setDisplayCode(StyleSheetUtil::displayCode(value(styles, "display")));
+	entry->setDisplayCode(StyleSheetUtil::displayCode(styles.value(CSSDeclarationList::DISPLAY)));
 
 	return entry;
 }
@@ -339,4 +384,5 @@ void StyleSheetTable::clear() {
 	myControlMap.clear();
 	myPageBreakBeforeMap.clear();
 	myPageBreakAfterMap.clear();
+	myIndex.reset();
 }
@@ -31,18 +31,18 @@
 #include <ZLTextStyleEntry.h>
 
 #include "CSSSelector.h"
+#include "CSSSelectorIndex.h"
+#include "CSSDeclarationList.h"
 
 class StyleSheetTable {
 
 public:
-	typedef std::map<std::string,std::string> AttributeMap;
-	static shared_ptr<ZLTextStyleEntry> createOrUpdateControl(const AttributeMap &map, shared_ptr<ZLTextStyleEntry> entry = 0);
+	static shared_ptr<ZLTextStyleEntry> createOrUpdateControl(const CSSDeclarationList &declarations, shared_ptr<ZLTextStyleEntry> entry = 0);
 
 private:
-	void addMap(shared_ptr<CSSSelector> selector, const AttributeMap &map);
+	void addMap(shared_ptr<CSSSelector> selector, const CSSDeclarationList &declarations);
 
-	static void setLength(ZLTextStyleEntry &entry, ZLTextStyleEntry::Feature featureId, const AttributeMap &map, const std::string &attributeName);
-	static const std::string &value(const AttributeMap &map, const std::string &name);
+	static void setLength(ZLTextStyleEntry &entry, ZLTextStyleEntry::Feature featureId, const CSSDeclarationList &declarations, CSSDeclarationList::Property property);
 
 public:
 	bool isEmpty() const;
@@ -50,6 +50,9 @@ public:
 	ZLBoolean3 doBreakAfter(const std::string &tag, const std::string &aClass) const;
 	shared_ptr<ZLTextStyleEntry> control(const std::string &tag, const std::string &aClass) const;
 	std::vector<std::pair<CSSSelector,shared_ptr<ZLTextStyleEntry> > > allControls(const std::string &tag, const std::string &aClass) const;
+	// compiled on first call after a change, or with other atoms; tables
+	// are shared between books by StyleSheetCache, their atoms are not
+	shared_ptr<CSSSelectorIndex> index(shared_ptr<CSSAtoms> atoms) const;
 
 	void clear();
 
@@ -57,7 +60,9 @@ private:
 	std::map<CSSSelector,shared_ptr<ZLTextStyleEntry> > myControlMap;
 	std::map<CSSSelector,bool> myPageBreakBeforeMap;
 	std::map<CSSSelector,bool> myPageBreakAfterMap;
+	mutable shared_ptr<CSSSelectorIndex> myIndex;
 
+friend class CSSSelectorIndex;
 friend class StyleSheetTableParser;
 friend class StyleSheetParserWithCache;
 };
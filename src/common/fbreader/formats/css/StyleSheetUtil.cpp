@@ -71,7 +71,7 @@ std::vector<std::string> StyleSheetUtil::splitCommaSeparatedList(const std::stri
 	return split;
 }
 
-ZLTextStyleEntry::DisplayCode StyleSheetUtil::displayCode(const std::string &data) {
+ZLTextStyleEntry::DisplayCode StyleSheetUtil::displayCode(const CSSDeclarationList::Value &data) {
 	if (data.empty()) {
 		return ZLTextStyleEntry::DC_NOT_DEFINED;
 	}
@@ -24,11 +24,13 @@
 
 #include <ZLTextStyleEntry.h>
 
+#include "CSSDeclarationList.h"
+
 struct StyleSheetUtil {
 	static std::string strip(const std::string &data);
 	static std::vector<std::string> splitCommaSeparatedList(const std::string &data);
 
-	static ZLTextStyleEntry::DisplayCode displayCode(const std::string &data);
+	static ZLTextStyleEntry::DisplayCode displayCode(const CSSDeclarationList::Value &data);
 };
 
 #endif /* __STYLESHEETUTIL_H__ */
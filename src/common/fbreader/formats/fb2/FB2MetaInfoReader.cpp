@@ -21,13 +21,14 @@
 
 #include <ZLInputStream.h>
 #include <ZLUnicodeUtil.h>
+#include <ZLFileImage.h>
 
 #include "FB2MetaInfoReader.h"
 #include "FB2TagManager.h"
 
 #include "../../library/Book.h"
 
-FB2MetaInfoReader::FB2MetaInfoReader(Book &book) : myBook(book) {
+FB2MetaInfoReader::FB2MetaInfoReader(Book &book) : myBook(book), myReadCover(false) {
 	myBook.removeAllAuthors();
 	myBook.setTitle(std::string());
 	myBook.setLanguage(std::string());
@@ -35,7 +36,16 @@ FB2MetaInfoReader::FB2MetaInfoReader(Book &book) : myBook(book) {
 	myBook.removeAllUids();
 }
 
+bool FB2MetaInfoReader::processNamespaces() const {
+	// needed to resolve xlink:href of the cover image
+	return myReadCover;
+}
+
 void FB2MetaInfoReader::characterDataHandler(const char *text, std::size_t len) {
+	if (len > 0 && myLookForImage) {
+		myImageStart = getCurrentPosition();
+		myLookForImage = false;
+	}
 	switch (myReadState) {
 		case READ_TITLE:
 		case READ_LANGUAGE:
@@ -61,7 +71,30 @@ void FB2MetaInfoReader::startElementHandler(int tag, const char **attributes) {
 	switch (tag) {
 		case _BODY:
 			myReturnCode = true;
-			interrupt();
+			myReadState = READ_NOTHING;
+			if (myImageId.empty()) {
+				interrupt();
+			}
+			break;
+		case _COVERPAGE:
+			myReadCoverPage = myReadCover;
+			break;
+		case _IMAGE:
+			if (myReadCoverPage) {
+				const char *ref = attributeValue(attributes, myHrefPredicate);
+				if (ref != 0 && *ref == '#' && *(ref + 1) != '\0') {
+					myImageId = ref + 1;
+				}
+			}
+			break;
+		case _BINARY:
+			if (!myImageId.empty()) {
+				const char *id = attributeValue(attributes, "id");
+				const char *contentType = attributeValue(attributes, "content-type");
+				if (id != 0 && contentType != 0 && myImageId == id) {
+					myLookForImage = true;
+				}
+			}
 			break;
 		case _TITLE_INFO:
 			myReadState = READ_TITLE_INFO;
@@ -127,6 +160,15 @@ void FB2MetaInfoReader::startElementHandler(int tag, const char **attributes) {
 
 void FB2MetaInfoReader::endElementHandler(int tag) {
 	switch (tag) {
+		case _COVERPAGE:
+			myReadCoverPage = false;
+			break;
+		case _BINARY:
+			if (myImageStart >= 0) {
+				myImage = new ZLFileImage(myBook.file(), "base64", myImageStart, getCurrentPosition() - myImageStart);
+				interrupt();
+			}
+			break;
 		case _TITLE_INFO:
 			myReadState = READ_NOTHING;
 			break;
@@ -219,5 +261,17 @@ bool FB2MetaInfoReader::readMetainfo() {
 	for (int i = 0; i < 3; ++i) {
 		myAuthorNames[i].erase();
 	}
+	myReadCoverPage = false;
+	myLookForImage = false;
+	myImageId.erase();
+	myImageStart = -1;
 	return readDocument(myBook.file());
 }
+
+bool FB2MetaInfoReader::readMetainfo(shared_ptr<const ZLImage> &cover) {
+	myReadCover = true;
+	const bool code = readMetainfo();
+	myReadCover = false;
+	cover = myImage;
+	return code;
+}
@@ -22,20 +22,28 @@
 
 #include <string>
 
+#include <shared_ptr.h>
+
 #include "FB2Reader.h"
 
 class Book;
+class ZLImage;
 
 class FB2MetaInfoReader : public FB2Reader {
 
 public:
 	FB2MetaInfoReader(Book &book);
 	bool readMetainfo();
+	// also looks for the cover image, going on past <body> to the binaries if needed
+	bool readMetainfo(shared_ptr<const ZLImage> &cover);
 
 	void startElementHandler(int tag, const char **attributes);
 	void endElementHandler(int tag);
 	void characterDataHandler(const char *text, std::size_t len);
 
+private:
+	bool processNamespaces() const;
+
 private:
 	Book &myBook;
 
@@ -57,6 +65,13 @@ private:
 
 	std::string myAuthorNames[3];
 	std::string myBuffer;
+
+	bool myReadCover;
+	bool myReadCoverPage;
+	bool myLookForImage;
+	std::string myImageId;
+	int myImageStart;
+	shared_ptr<const ZLImage> myImage;
 };
 
 #endif /* __FB2METAINFOREADER_H__ */
@@ -49,3 +49,8 @@ shared_ptr<const ZLImage> FB2Plugin::coverImage(const ZLFile &file) const {
 bool FB2Plugin::readLanguageAndEncoding(Book&) const {
 	return true;
 }
+
+bool FB2Plugin::readAllMetainfo(Book &book, shared_ptr<const ZLImage> &cover, std::string&) const {
+	// uids are collected by the metainfo reader as well
+	return FB2MetaInfoReader(book).readMetainfo(cover);
+}
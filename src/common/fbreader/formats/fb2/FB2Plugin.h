@@ -34,6 +34,7 @@ public:
 	bool readLanguageAndEncoding(Book &book) const;
 	bool readModel(BookModel &model) const;
 	shared_ptr<const ZLImage> coverImage(const ZLFile &file) const;
+	bool readAllMetainfo(Book &book, shared_ptr<const ZLImage> &cover, std::string &annotation) const;
 };
 
 inline FB2Plugin::FB2Plugin() {}
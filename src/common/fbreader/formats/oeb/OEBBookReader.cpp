@@ -23,116 +23,29 @@
 #include <ZLInputStream.h>
 #include <ZLLogger.h>
 #include <ZLStringUtil.h>
-#include <ZLUnicodeUtil.h>
 #include <FileEncryptionInfo.h>
 #include <ZLFile.h>
 #include <ZLFileImage.h>
-#include <ZLXMLNamespace.h>
+#include <ZLXMLRecorder.h>
 
 #include "OEBBookReader.h"
-#include "OEBEncryptionReader.h"
+#include "OEBPackage.h"
+#include "OEBSpineLoader.h"
 #include "XHTMLImageFinder.h"
 #include "NCXReader.h"
 #include "../xhtml/XHTMLReader.h"
-#include "../util/MiscUtil.h"
 #include "../../bookmodel/BookModel.h"
 
-OEBBookReader::OEBBookReader(BookModel &model) : myModelReader(model) {
+OEBBookReader::OEBBookReader(BookModel &model, std::size_t threadsNumber) : myModelReader(model), myThreadsNumber(threadsNumber), myParagraphPrefixReplayEnabled(true) {
 }
 
-static const std::string MANIFEST = "manifest";
-static const std::string SPINE = "spine";
-static const std::string GUIDE = "guide";
-static const std::string TOUR = "tour";
-static const std::string SITE = "site";
-
-static const std::string ITEM = "item";
-static const std::string ITEMREF = "itemref";
-static const std::string REFERENCE = "reference";
+void OEBBookReader::setParagraphPrefixReplayEnabled(bool enabled) {
+	myParagraphPrefixReplayEnabled = enabled;
+}
 
 static const std::string COVER = "cover";
 static const std::string COVER_IMAGE = "other.ms-coverimage-standard";
 
-void OEBBookReader::startElementHandler(const char *tag, const char **xmlattributes) {
-	std::string tagString = ZLUnicodeUtil::toLowerAscii(tag);
-
-	switch (myState) {
-		case READ_NONE:
-			if (testOPFTag(MANIFEST, tagString)) {
-				myState = READ_MANIFEST;
-			} else if (testOPFTag(SPINE, tagString)) {
-				const char *toc = attributeValue(xmlattributes, "toc");
-				if (toc != 0) {
-					myNCXTOCFileName = myIdToHref[toc];
-				}
-				myState = READ_SPINE;
-			} else if (testOPFTag(GUIDE, tagString)) {
-				myState = READ_GUIDE;
-			} else if (testOPFTag(TOUR, tagString)) {
-				myState = READ_TOUR;
-			}
-			break;
-		case READ_MANIFEST:
-			if (testOPFTag(ITEM, tagString)) {
-				const char *href = attributeValue(xmlattributes, "href");
-				if (href != 0) {
-					const std::string sHref = MiscUtil::decodeHtmlURL(href);
-					const char *id = attributeValue(xmlattributes, "id");
-					const char *mediaType = attributeValue(xmlattributes, "media-type");
-					if (id != 0) {
-						myIdToHref[id] = sHref;
-					}
-					if (mediaType != 0) {
-						myHrefToMediatype[sHref] = mediaType;
-					}
-				}
-			}
-			break;
-		case READ_SPINE:
-			if (testOPFTag(ITEMREF, tagString)) {
-				const char *id = attributeValue(xmlattributes, "idref");
-				if (id != 0) {
-					const std::string &fileName = myIdToHref[id];
-					if (!fileName.empty()) {
-						myHtmlFileNames.push_back(fileName);
-					}
-				}
-			}
-			break;
-		case READ_GUIDE:
-			if (testOPFTag(REFERENCE, tagString)) {
-				const char *type = attributeValue(xmlattributes, "type");
-				const char *title = attributeValue(xmlattributes, "title");
-				const char *href = attributeValue(xmlattributes, "href");
-				if (href != 0) {
-					const std::string reference = MiscUtil::decodeHtmlURL(href);
-					if (title != 0) {
-						myGuideTOC.push_back(std::make_pair(std::string(title), reference));
-					}
-					if (type != 0 && (COVER == type || COVER_IMAGE == type)) {
-						ZLFile imageFile(myFilePrefix + reference);
-						myCoverFileName = imageFile.path();
-						myCoverFileType = type;
-						const std::map<std::string,std::string>::const_iterator it =
-							myHrefToMediatype.find(reference);
-						myCoverMimeType =
-							it != myHrefToMediatype.end() ? it->second : std::string();
-					}
-				}
-			}
-			break;
-		case READ_TOUR:
-			if (testOPFTag(SITE, tagString)) {
-				const char *title = attributeValue(xmlattributes, "title");
-				const char *href = attributeValue(xmlattributes, "href");
-				if ((title != 0) && (href != 0)) {
-					myTourTOC.push_back(std::make_pair(title, MiscUtil::decodeHtmlURL(href)));
-				}
-			}
-			break;
-	}
-}
-
 bool OEBBookReader::coverIsSingleImage() const {
 	return
 		COVER_IMAGE == myCoverFileType ||
@@ -154,72 +67,50 @@ void OEBBookReader::addCoverImage() {
 	}
 }
 
-void OEBBookReader::endElementHandler(const char *tag) {
-	std::string tagString = ZLUnicodeUtil::toLowerAscii(tag);
-
-	switch (myState) {
-		case READ_MANIFEST:
-			if (testOPFTag(MANIFEST, tagString)) {
-				myState = READ_NONE;
-			}
-			break;
-		case READ_SPINE:
-			if (testOPFTag(SPINE, tagString)) {
-				myState = READ_NONE;
-			}
-			break;
-		case READ_GUIDE:
-			if (testOPFTag(GUIDE, tagString)) {
-				myState = READ_NONE;
-			}
-			break;
-		case READ_TOUR:
-			if (testOPFTag(TOUR, tagString)) {
-				myState = READ_NONE;
-			}
-			break;
-		case READ_NONE:
-			break;
+bool OEBBookReader::readBook(const OEBPackage &package) {
+	if (!package.isValid()) {
+		return false;
 	}
-}
 
-bool OEBBookReader::readBook(const ZLFile &opfFile) {
-	const ZLFile epubFile = opfFile.getContainerArchive();
-	epubFile.forceArchiveType(ZLFile::ZIP);
-	shared_ptr<ZLDir> epubDir = epubFile.directory();
+	const ZLFile &opfFile = package.opfFile();
+	shared_ptr<ZLDir> epubDir = package.epubFile().directory();
 	if (!epubDir.isNull()) {
 		myEncryptionMap = new EncryptionMap();
-		const std::vector<shared_ptr<FileEncryptionInfo> > encodingInfos =
-			OEBEncryptionReader().readEncryptionInfos(epubFile, opfFile);
+		const std::vector<shared_ptr<FileEncryptionInfo> > &encodingInfos = package.encryptionInfos();
 
 		for (std::vector<shared_ptr<FileEncryptionInfo> >::const_iterator it = encodingInfos.begin(); it != encodingInfos.end(); ++it) {
 			myEncryptionMap->addInfo(*epubDir, *it);
 		}
 	}
 
-	myFilePrefix = MiscUtil::htmlDirectoryPrefix(opfFile.path());
-
-	myIdToHref.clear();
-	myHtmlFileNames.clear();
-	myNCXTOCFileName.erase();
-	myCoverFileName.erase();
-	myCoverFileType.erase();
-	myCoverMimeType.erase();
-	myTourTOC.clear();
-	myGuideTOC.clear();
-	myState = READ_NONE;
-
-	if (!readDocument(opfFile)) {
-		return false;
-	}
+	myFilePrefix = package.filePrefix();
+	myHtmlFileNames = package.spine();
+	myNCXTOCFileName = package.ncxFileName();
+	myCoverFileName = package.guideCoverFileName();
+	myCoverFileType = package.guideCoverFileType();
+	myCoverMimeType = package.guideCoverMimeType();
+	myTourTOC = package.tourTOC();
+	myGuideTOC = package.guideTOC();
 
 	myModelReader.setMainTextModel();
 	myModelReader.pushKind(REGULAR);
 
+	std::vector<ZLFile> xhtmlFiles;
+	for (std::vector<std::string>::const_iterator it = myHtmlFileNames.begin(); it != myHtmlFileNames.end(); ++it) {
+		xhtmlFiles.push_back(ZLFile(myFilePrefix + *it));
+	}
+
 	//ZLLogger::Instance().registerClass("oeb");
 	XHTMLReader xhtmlReader(myModelReader, myEncryptionMap);
+	xhtmlReader.setParagraphPrefixReplayEnabled(myParagraphPrefixReplayEnabled);
+	// files are read and parsed ahead in other threads, but the parser
+	// callbacks are replayed here in spine order, so the model does not
+	// depend on the threads number
+	const ZLXMLRecorder recorder(xhtmlReader);
+	OEBSpineLoader loader(xhtmlFiles, myEncryptionMap, recorder, myThreadsNumber > 1 ? myThreadsNumber - 1 : 0);
 	for (std::vector<std::string>::const_iterator it = myHtmlFileNames.begin(); it != myHtmlFileNames.end(); ++it) {
-		const ZLFile xhtmlFile(myFilePrefix + *it);
+		const std::size_t index = it - myHtmlFileNames.begin();
+		const ZLFile &xhtmlFile = xhtmlFiles[index];
 		if (it == myHtmlFileNames.begin()) {
 			if (myCoverFileName == xhtmlFile.path()) {
 				if (coverIsSingleImage()) {
@@ -234,7 +125,11 @@ bool OEBBookReader::readBook(const ZLFile &opfFile) {
 			myModelReader.insertEndOfSectionParagraph();
 		}
 		//ZLLogger::Instance().println("oeb", "start " + xhtmlFile.path());
-		if (!xhtmlReader.readFile(xhtmlFile, *it)) {
+		shared_ptr<ZLXMLRecord> record = loader.record(index);
+		const bool code = record.isNull()
+			? xhtmlReader.readFile(xhtmlFile, *it, loader.stream(index))
+			: xhtmlReader.readFile(xhtmlFile, *it, *record);
+		if (!code) {
 			if (opfFile.exists() && !myEncryptionMap.isNull()) {
 				myModelReader.insertEncryptedSectionParagraph();
 			}
@@ -27,41 +27,32 @@
 #include <shared_ptr.h>
 #include <FileEncryptionInfo.h>
 
-#include "OPFReader.h"
 #include "../../bookmodel/BookReader.h"
 
 class XHTMLReader;
+class OEBPackage;
 
-class OEBBookReader : public OPFReader {
+class OEBBookReader {
 
 public:
-	OEBBookReader(BookModel &model);
-	bool readBook(const ZLFile &file);
+	// threadsNumber counts the calling thread, 1 means no worker threads
+	OEBBookReader(BookModel &model, std::size_t threadsNumber = 1);
+	// see XHTMLReader::setParagraphPrefixReplayEnabled
+	void setParagraphPrefixReplayEnabled(bool enabled);
+	bool readBook(const OEBPackage &package);
 
 private:
-	void startElementHandler(const char *tag, const char **attributes);
-	void endElementHandler(const char *tag);
-
 	void generateTOC(const XHTMLReader &xhtmlReader);
 	bool coverIsSingleImage() const;
 	void addCoverImage();
 
 private:
-	enum ReaderState {
-		READ_NONE,
-		READ_MANIFEST,
-		READ_SPINE,
-		READ_GUIDE,
-		READ_TOUR
-	};
-
 	BookReader myModelReader;
-	ReaderState myState;
+	const std::size_t myThreadsNumber;
+	bool myParagraphPrefixReplayEnabled;
 
 	shared_ptr<EncryptionMap> myEncryptionMap;
 	std::string myFilePrefix;
-	std::map<std::string,std::string> myIdToHref;
-	std::map<std::string,std::string> myHrefToMediatype;
 	std::vector<std::string> myHtmlFileNames;
 	std::string myNCXTOCFileName;
 	std::string myCoverFileName;
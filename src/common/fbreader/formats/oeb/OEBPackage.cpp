@@ -0,0 +1,538 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <ZLFileImage.h>
+#include <ZLLogger.h>
+#include <ZLUnicodeUtil.h>
+#include <ZLXMLNamespace.h>
+#include <FileEncryptionInfo.h>
+
+#include "OEBPackage.h"
+#include "OEBPlugin.h"
+#include "OPFReader.h"
+#include "OEBEncryptionReader.h"
+#include "XHTMLImageFinder.h"
+
+#include "../util/MiscUtil.h"
+#include "../../library/Book.h"
+
+class OEBPackageReader : public OPFReader {
+
+public:
+	OEBPackageReader(OEBPackage &package);
+	bool readPackage();
+
+private:
+	void startElementHandler(const char *tag, const char **attributes);
+	void endElementHandler(const char *tag);
+	void characterDataHandler(const char *text, std::size_t len);
+
+	void startCoverElement(const char *tag, const char **attributes);
+	void endCoverElement(const char *tag);
+	void setCoverImage(const char *href);
+
+	void startMetadataElement(const std::string &tag, const char **attributes);
+	void endMetadataElement(const std::string &tag);
+
+private:
+	OEBPackage &myPackage;
+	std::map<std::string,std::string> myIdToHref;
+
+	enum {
+		READ_NONE,
+		READ_MANIFEST,
+		READ_SPINE,
+		READ_GUIDE,
+		READ_TOUR
+	} myState;
+
+	// the cover is looked for by its own rules,
+	// they differ from the main ones in tag name matching
+	enum {
+		COVER_READ_NOTHING,
+		COVER_READ_METADATA,
+		COVER_READ_MANIFEST,
+		COVER_READ_GUIDE,
+		COVER_FOUND
+	} myCoverState;
+	std::string myCoverId;
+
+	enum {
+		METADATA_READ_NONE,
+		METADATA_READ_METADATA,
+		METADATA_READ_AUTHOR,
+		METADATA_READ_AUTHOR2,
+		METADATA_READ_TITLE,
+		METADATA_READ_SUBJECT,
+		METADATA_READ_LANGUAGE,
+		METADATA_READ_IDENTIFIER,
+		METADATA_DONE
+	} myMetadataState;
+	std::string myIdentifierScheme;
+	std::string myBuffer;
+	// creators with role "aut" and without a role; the latter are used only if there are no former
+	std::vector<std::string> myAuthorList;
+	std::vector<std::string> myAuthorList2;
+};
+
+static const std::string MANIFEST = "manifest";
+static const std::string SPINE = "spine";
+static const std::string GUIDE = "guide";
+static const std::string TOUR = "tour";
+static const std::string SITE = "site";
+static const std::string METADATA = "metadata";
+static const std::string META = "meta";
+
+static const std::string ITEM = "item";
+static const std::string ITEMREF = "itemref";
+static const std::string REFERENCE = "reference";
+
+static const std::string COVER = "cover";
+static const std::string COVER_IMAGE = "other.ms-coverimage-standard";
+
+static const std::string AUTHOR_ROLE = "aut";
+
+OEBPackageReader::OEBPackageReader(OEBPackage &package) : myPackage(package), myState(READ_NONE), myCoverState(COVER_READ_NOTHING), myMetadataState(METADATA_READ_NONE) {
+}
+
+bool OEBPackageReader::readPackage() {
+	const bool code = readDocument(myPackage.myOpfFile);
+	myPackage.myAuthors = myAuthorList.empty() ? myAuthorList2 : myAuthorList;
+	myPackage.myMetainfoIsRead = code || myMetadataState == METADATA_DONE;
+	return code;
+}
+
+void OEBPackageReader::characterDataHandler(const char *text, std::size_t len) {
+	switch (myMetadataState) {
+		case METADATA_READ_NONE:
+		case METADATA_READ_METADATA:
+		case METADATA_DONE:
+			break;
+		case METADATA_READ_AUTHOR:
+		case METADATA_READ_AUTHOR2:
+		case METADATA_READ_SUBJECT:
+		case METADATA_READ_LANGUAGE:
+		case METADATA_READ_TITLE:
+		case METADATA_READ_IDENTIFIER:
+			myBuffer.append(text, len);
+			break;
+	}
+}
+
+void OEBPackageReader::startElementHandler(const char *tag, const char **xmlattributes) {
+	startCoverElement(tag, xmlattributes);
+
+	std::string tagString = ZLUnicodeUtil::toLowerAscii(tag);
+	startMetadataElement(tagString, xmlattributes);
+
+	switch (myState) {
+		case READ_NONE:
+			if (testOPFTag(MANIFEST, tagString)) {
+				myState = READ_MANIFEST;
+			} else if (testOPFTag(SPINE, tagString)) {
+				const char *toc = attributeValue(xmlattributes, "toc");
+				if (toc != 0) {
+					myPackage.myNCXFileName = myIdToHref[toc];
+				}
+				myState = READ_SPINE;
+			} else if (testOPFTag(GUIDE, tagString)) {
+				myState = READ_GUIDE;
+			} else if (testOPFTag(TOUR, tagString)) {
+				myState = READ_TOUR;
+			}
+			break;
+		case READ_MANIFEST:
+			if (testOPFTag(ITEM, tagString)) {
+				const char *href = attributeValue(xmlattributes, "href");
+				if (href != 0) {
+					const std::string sHref = MiscUtil::decodeHtmlURL(href);
+					const char *id = attributeValue(xmlattributes, "id");
+					const char *mediaType = attributeValue(xmlattributes, "media-type");
+					if (id != 0) {
+						myIdToHref[id] = sHref;
+					}
+					if (mediaType != 0) {
+						myPackage.myHrefToMediatype[sHref] = mediaType;
+					}
+				}
+			}
+			break;
+		case READ_SPINE:
+			if (testOPFTag(ITEMREF, tagString)) {
+				const char *id = attributeValue(xmlattributes, "idref");
+				if (id != 0) {
+					const std::string &fileName = myIdToHref[id];
+					if (!fileName.empty()) {
+						myPackage.mySpine.push_back(fileName);
+					}
+				}
+			}
+			break;
+		case READ_GUIDE:
+			if (testOPFTag(REFERENCE, tagString)) {
+				const char *type = attributeValue(xmlattributes, "type");
+				const char *title = attributeValue(xmlattributes, "title");
+				const char *href = attributeValue(xmlattributes, "href");
+				if (href != 0) {
+					const std::string reference = MiscUtil::decodeHtmlURL(href);
+					if (title != 0) {
+						myPackage.myGuideTOC.push_back(std::make_pair(std::string(title), reference));
+					}
+					if (type != 0 && (COVER == type || COVER_IMAGE == type)) {
+						ZLFile imageFile(myPackage.myFilePrefix + reference);
+						myPackage.myGuideCoverFileName = imageFile.path();
+						myPackage.myGuideCoverFileType = type;
+						const std::map<std::string,std::string>::const_iterator it =
+							myPackage.myHrefToMediatype.find(reference);
+						myPackage.myGuideCoverMimeType =
+							it != myPackage.myHrefToMediatype.end() ? it->second : std::string();
+					}
+				}
+			}
+			break;
+		case READ_TOUR:
+			if (testOPFTag(SITE, tagString)) {
+				const char *title = attributeValue(xmlattributes, "title");
+				const char *href = attributeValue(xmlattributes, "href");
+				if ((title != 0) && (href != 0)) {
+					myPackage.myTourTOC.push_back(std::make_pair(title, MiscUtil::decodeHtmlURL(href)));
+				}
+			}
+			break;
+	}
+}
+
+void OEBPackageReader::endElementHandler(const char *tag) {
+	endCoverElement(tag);
+
+	std::string tagString = ZLUnicodeUtil::toLowerAscii(tag);
+	endMetadataElement(tagString);
+
+	switch (myState) {
+		case READ_MANIFEST:
+			if (testOPFTag(MANIFEST, tagString)) {
+				myState = READ_NONE;
+			}
+			break;
+		case READ_SPINE:
+			if (testOPFTag(SPINE, tagString)) {
+				myState = READ_NONE;
+			}
+			break;
+		case READ_GUIDE:
+			if (testOPFTag(GUIDE, tagString)) {
+				myState = READ_NONE;
+			}
+			break;
+		case READ_TOUR:
+			if (testOPFTag(TOUR, tagString)) {
+				myState = READ_NONE;
+			}
+			break;
+		case READ_NONE:
+			break;
+	}
+}
+
+void OEBPackageReader::startCoverElement(const char *tag, const char **attributes) {
+	switch (myCoverState) {
+		case COVER_READ_NOTHING:
+			if (GUIDE == tag) {
+				myCoverState = COVER_READ_GUIDE;
+			} else if (MANIFEST == tag) {
+				myCoverState = COVER_READ_MANIFEST;
+			} else if (testTag(ZLXMLNamespace::OpenPackagingFormat, METADATA, tag)) {
+				myCoverState = COVER_READ_METADATA;
+			}
+			break;
+		case COVER_READ_GUIDE:
+			if (REFERENCE == tag) {
+				const char *type = attributeValue(attributes, "type");
+				if (type != 0) {
+					if (COVER == type) {
+						const char *href = attributeValue(attributes, "href");
+						if (href != 0) {
+							myPackage.myCoverXHTMLFileName = myPackage.myFilePrefix + MiscUtil::decodeHtmlURL(href);
+							myCoverState = COVER_FOUND;
+						}
+					} else if (COVER_IMAGE == type) {
+						setCoverImage(attributeValue(attributes, "href"));
+					}
+				}
+			}
+			break;
+		case COVER_READ_METADATA:
+			if (testTag(ZLXMLNamespace::OpenPackagingFormat, META, tag)) {
+				const char *name = attributeValue(attributes, "name");
+				if (name != 0 && COVER == name) {
+					const char *coverId = attributeValue(attributes, "content");
+					if (coverId != 0) {
+						myCoverId = coverId;
+					}
+				}
+			}
+			break;
+		case COVER_READ_MANIFEST:
+			if (ITEM == tag) {
+				const char *href = attributeValue(attributes, "href");
+				if (href == 0) {
+					break;
+				}
+				const char *prop = attributeValue(attributes, "properties");
+				if (prop != 0 && std::string("cover-image") == prop) {
+					setCoverImage(href);
+					break;
+				}
+				const char *id = attributeValue(attributes, "id");
+				if (id != 0 && !myCoverId.empty() && myCoverId == id) {
+					setCoverImage(href);
+				}
+			}
+			break;
+		case COVER_FOUND:
+			break;
+	}
+}
+
+void OEBPackageReader::setCoverImage(const char *href) {
+	if (href != 0) {
+		myPackage.myCoverImageFileName = myPackage.myFilePrefix + MiscUtil::decodeHtmlURL(href);
+		myCoverState = COVER_FOUND;
+	}
+}
+
+void OEBPackageReader::endCoverElement(const char *tag) {
+	switch (myCoverState) {
+		case COVER_READ_NOTHING:
+		case COVER_FOUND:
+			break;
+		case COVER_READ_GUIDE:
+			if (GUIDE == tag) {
+				myCoverState = COVER_READ_NOTHING;
+			}
+			break;
+		case COVER_READ_METADATA:
+			if (testTag(ZLXMLNamespace::OpenPackagingFormat, METADATA, tag)) {
+				myCoverState = COVER_READ_NOTHING;
+			}
+			break;
+		case COVER_READ_MANIFEST:
+			if (MANIFEST == tag) {
+				myCoverState = COVER_READ_NOTHING;
+			}
+			break;
+	}
+}
+
+void OEBPackageReader::startMetadataElement(const std::string &tag, const char **attributes) {
+	switch (myMetadataState) {
+		default:
+			break;
+		case METADATA_READ_NONE:
+			if (isMetadataTag(tag)) {
+				myMetadataState = METADATA_READ_METADATA;
+			}
+			break;
+		case METADATA_READ_METADATA:
+			if (testDCTag("title", tag)) {
+				myMetadataState = METADATA_READ_TITLE;
+			} else if (testDCTag("creator", tag)) {
+				const char *role = attributeValue(attributes, "role");
+				if (role == 0) {
+					myMetadataState = METADATA_READ_AUTHOR2;
+				} else if (AUTHOR_ROLE == role) {
+					myMetadataState = METADATA_READ_AUTHOR;
+				}
+			} else if (testDCTag("subject", tag)) {
+				myMetadataState = METADATA_READ_SUBJECT;
+			} else if (testDCTag("language", tag)) {
+				myMetadataState = METADATA_READ_LANGUAGE;
+			} else if (testDCTag("identifier", tag)) {
+				myMetadataState = METADATA_READ_IDENTIFIER;
+				static const FullNamePredicate schemePredicate(ZLXMLNamespace::OpenPackagingFormat, "scheme");
+				const char *scheme = attributeValue(attributes, schemePredicate);
+				myIdentifierScheme = scheme != 0 ? scheme : "EPUB-NOSCHEME";
+			} else if (testTag(ZLXMLNamespace::OpenPackagingFormat, META, tag)) {
+				const char *name = attributeValue(attributes, "name");
+				const char *content = attributeValue(attributes, "content");
+				if (name != 0 && content != 0) {
+					std::string sName = name;
+					if (sName == "calibre:series" || isNSName(sName, "series", ZLXMLNamespace::CalibreMetadata)) {
+						myPackage.mySeriesTitle = content;
+					} else if (sName == "calibre:series_index" || isNSName(sName, "series_index", ZLXMLNamespace::CalibreMetadata)) {
+						myPackage.myIndexInSeries = content;
+					}
+				}
+			}
+			break;
+	}
+}
+
+void OEBPackageReader::endMetadataElement(const std::string &tag) {
+	ZLUnicodeUtil::utf8Trim(myBuffer);
+	switch (myMetadataState) {
+		case METADATA_READ_NONE:
+		case METADATA_DONE:
+			return;
+		case METADATA_READ_METADATA:
+			if (isMetadataTag(tag)) {
+				myMetadataState = METADATA_DONE;
+				return;
+			}
+			break;
+		case METADATA_READ_AUTHOR:
+			if (!myBuffer.empty()) {
+				myAuthorList.push_back(myBuffer);
+			}
+			break;
+		case METADATA_READ_AUTHOR2:
+			if (!myBuffer.empty()) {
+				myAuthorList2.push_back(myBuffer);
+			}
+			break;
+		case METADATA_READ_SUBJECT:
+			if (!myBuffer.empty()) {
+				myPackage.myTags.push_back(myBuffer);
+			}
+			break;
+		case METADATA_READ_TITLE:
+			if (!myBuffer.empty()) {
+				myPackage.myTitle = myBuffer;
+			}
+			break;
+		case METADATA_READ_LANGUAGE:
+			if (!myBuffer.empty()) {
+				myPackage.myLanguage = myBuffer.substr(0, myBuffer.find_first_of("-_"));
+			}
+			break;
+		case METADATA_READ_IDENTIFIER:
+			if (!myBuffer.empty()) {
+				myPackage.myUids.push_back(std::make_pair(myIdentifierScheme, myBuffer));
+			}
+			break;
+	}
+	myBuffer.erase();
+	myMetadataState = METADATA_READ_METADATA;
+}
+
+const std::size_t OEBPackage::ourStorageSize = 5;
+shared_ptr<OEBPackage> *OEBPackage::ourStoredPackages =
+	new shared_ptr<OEBPackage>[ourStorageSize];
+std::size_t OEBPackage::ourIndex = 0;
+
+shared_ptr<OEBPackage> OEBPackage::package(const ZLFile &oebFile) {
+	for (std::size_t i = 0; i < ourStorageSize; ++i) {
+		shared_ptr<OEBPackage> package = ourStoredPackages[i];
+		if (!package.isNull() && package->myPath == oebFile.path()) {
+			if (!package->isUpToDate()) {
+				package = new OEBPackage(oebFile);
+				ourStoredPackages[i] = package;
+			}
+			return package;
+		}
+	}
+	shared_ptr<OEBPackage> package = new OEBPackage(oebFile);
+	ourStoredPackages[ourIndex] = package;
+	ourIndex = (ourIndex + 1) % ourStorageSize;
+	return package;
+}
+
+OEBPackage::OEBPackage(const ZLFile &oebFile) :
+	myPath(oebFile.path()),
+	myLastModifiedTime(ZLFile(oebFile.physicalFilePath()).lastModified()),
+	myOpfFile(OEBPlugin::opfFile(oebFile)),
+	myEpubFile(myOpfFile.getContainerArchive()),
+	myIsValid(false),
+	myEncryptionInfosAreRead(false),
+	myMetainfoIsRead(false) {
+	myEpubFile.forceArchiveType(ZLFile::ZIP);
+	if (myOpfFile.exists()) {
+		myFilePrefix = MiscUtil::htmlDirectoryPrefix(myOpfFile.path());
+		myIsValid = OEBPackageReader(*this).readPackage();
+	}
+}
+
+bool OEBPackage::isUpToDate() const {
+	return myLastModifiedTime == ZLFile(ZLFile(myPath).physicalFilePath()).lastModified();
+}
+
+shared_ptr<const ZLImage> OEBPackage::coverImage() const {
+	if (!myCoverImageFileName.empty()) {
+		return new ZLFileImage(ZLFile(myCoverImageFileName), "", 0);
+	}
+	if (!myCoverXHTMLFileName.empty()) {
+		const ZLFile coverFile(myCoverXHTMLFileName);
+		const std::string ext = coverFile.extension();
+		if (ext == "gif" || ext == "jpeg" || ext == "jpg" || ext == "png") {
+			return new ZLFileImage(coverFile, "", 0);
+		} else {
+			return XHTMLImageFinder().readImage(coverFile);
+		}
+	}
+	return 0;
+}
+
+const std::vector<shared_ptr<FileEncryptionInfo> > &OEBPackage::encryptionInfos() const {
+	if (!myEncryptionInfosAreRead) {
+		myEncryptionInfos = OEBEncryptionReader().readEncryptionInfos(myEpubFile, myOpfFile);
+		myEncryptionInfosAreRead = true;
+	}
+	return myEncryptionInfos;
+}
+
+bool OEBPackage::readMetainfo(Book &book) const {
+	book.removeAllAuthors();
+	book.setTitle("");
+	book.removeAllTags();
+	if (!readUids(book)) {
+		ZLLogger::Instance().println("epub", "Failure while reading info from " + myOpfFile.path());
+		return false;
+	}
+
+	if (!myTitle.empty()) {
+		book.setTitle(myTitle);
+	}
+	for (std::vector<std::string>::const_iterator it = myAuthors.begin(); it != myAuthors.end(); ++it) {
+		book.addAuthor(*it);
+	}
+	for (std::vector<std::string>::const_iterator it = myTags.begin(); it != myTags.end(); ++it) {
+		book.addTag(*it);
+	}
+	if (!myLanguage.empty()) {
+		book.setLanguage(myLanguage);
+	}
+	if (!mySeriesTitle.empty() || !myIndexInSeries.empty()) {
+		book.setSeries(
+			mySeriesTitle.empty() ? book.seriesTitle() : mySeriesTitle,
+			myIndexInSeries.empty() ? book.indexInSeries() : myIndexInSeries
+		);
+	}
+	return true;
+}
+
+bool OEBPackage::readUids(Book &book) const {
+	book.removeAllUids();
+	if (!myMetainfoIsRead) {
+		return false;
+	}
+	for (std::vector<std::pair<std::string,std::string> >::const_iterator it = myUids.begin(); it != myUids.end(); ++it) {
+		book.addUid(it->first, it->second);
+	}
+	return true;
+}
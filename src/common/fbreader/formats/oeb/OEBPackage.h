@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __OEBPACKAGE_H__
+#define __OEBPACKAGE_H__
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include <shared_ptr.h>
+#include <ZLFile.h>
+
+class ZLImage;
+class FileEncryptionInfo;
+class Book;
+
+// Package (OPF) data of an ePub, read by one OPF parse and shared by all
+// OEBPlugin entry points; the last few packages are cached by book path
+// and modification time.
+class OEBPackage {
+
+public:
+	static shared_ptr<OEBPackage> package(const ZLFile &oebFile);
+
+private:
+	static const std::size_t ourStorageSize;
+	static shared_ptr<OEBPackage> *ourStoredPackages;
+	static std::size_t ourIndex;
+
+private:
+	OEBPackage(const ZLFile &oebFile);
+
+public:
+	// false if the OPF file was not found or could not be parsed
+	bool isValid() const;
+
+	const ZLFile &opfFile() const;
+	const ZLFile &epubFile() const;
+	// directory of the OPF file, spine and guide references are relative to it
+	const std::string &filePrefix() const;
+
+	// hrefs of the spine items, in reading order
+	const std::vector<std::string> &spine() const;
+	const std::map<std::string,std::string> &hrefToMediatype() const;
+	const std::string &ncxFileName() const;
+	const std::vector<std::pair<std::string,std::string> > &tourTOC() const;
+	const std::vector<std::pair<std::string,std::string> > &guideTOC() const;
+
+	// cover as referenced by the guide
+	const std::string &guideCoverFileName() const;
+	const std::string &guideCoverFileType() const;
+	const std::string &guideCoverMimeType() const;
+
+	// the first cover image or cover xhtml found in the OPF: an epub3 cover-image item,
+	// the item named by <meta name="cover"> or a cover reference in the guide
+	shared_ptr<const ZLImage> coverImage() const;
+
+	const std::vector<shared_ptr<FileEncryptionInfo> > &encryptionInfos() const;
+
+	// metadata collected by the same OPF parse;
+	// false if the parse failed before the end of the metadata element
+	bool readMetainfo(Book &book) const;
+	bool readUids(Book &book) const;
+
+private:
+	bool isUpToDate() const;
+
+private:
+	const std::string myPath;
+	const std::size_t myLastModifiedTime;
+
+	ZLFile myOpfFile;
+	ZLFile myEpubFile;
+	bool myIsValid;
+	std::string myFilePrefix;
+
+	std::vector<std::string> mySpine;
+	std::map<std::string,std::string> myHrefToMediatype;
+	std::string myNCXFileName;
+	std::vector<std::pair<std::string,std::string> > myTourTOC;
+	std::vector<std::pair<std::string,std::string> > myGuideTOC;
+
+	std::string myGuideCoverFileName;
+	std::string myGuideCoverFileType;
+	std::string myGuideCoverMimeType;
+
+	std::string myCoverImageFileName;
+	std::string myCoverXHTMLFileName;
+
+	mutable bool myEncryptionInfosAreRead;
+	mutable std::vector<shared_ptr<FileEncryptionInfo> > myEncryptionInfos;
+
+	bool myMetainfoIsRead;
+	std::string myTitle;
+	std::string myLanguage;
+	std::string mySeriesTitle;
+	std::string myIndexInSeries;
+	std::vector<std::string> myAuthors;
+	std::vector<std::string> myTags;
+	// (scheme, identifier) pairs
+	std::vector<std::pair<std::string,std::string> > myUids;
+
+friend class OEBPackageReader;
+
+private: // disable copying
+	OEBPackage(const OEBPackage &);
+	const OEBPackage &operator = (const OEBPackage &);
+};
+
+inline bool OEBPackage::isValid() const { return myIsValid; }
+inline const ZLFile &OEBPackage::opfFile() const { return myOpfFile; }
+inline const ZLFile &OEBPackage::epubFile() const { return myEpubFile; }
+inline const std::string &OEBPackage::filePrefix() const { return myFilePrefix; }
+inline const std::vector<std::string> &OEBPackage::spine() const { return mySpine; }
+inline const std::map<std::string,std::string> &OEBPackage::hrefToMediatype() const { return myHrefToMediatype; }
+inline const std::string &OEBPackage::ncxFileName() const { return myNCXFileName; }
+inline const std::vector<std::pair<std::string,std::string> > &OEBPackage::tourTOC() const { return myTourTOC; }
+inline const std::vector<std::pair<std::string,std::string> > &OEBPackage::guideTOC() const { return myGuideTOC; }
+inline const std::string &OEBPackage::guideCoverFileName() const { return myGuideCoverFileName; }
+inline const std::string &OEBPackage::guideCoverFileType() const { return myGuideCoverFileType; }
+inline const std::string &OEBPackage::guideCoverMimeType() const { return myGuideCoverMimeType; }
+
+#endif /* __OEBPACKAGE_H__ */
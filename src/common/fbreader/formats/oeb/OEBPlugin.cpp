@@ -25,14 +25,12 @@
 #include <ZLInputStream.h>
 #include <ZLLogger.h>
 #include <ZLXMLReader.h>
+#include <ZLLanguageDetector.h>
 
 #include "OEBPlugin.h"
-#include "OEBMetaInfoReader.h"
-#include "OEBEncryptionReader.h"
-#include "OEBUidReader.h"
+#include "OEBPackage.h"
 #include "OEBBookReader.h"
-#include "OEBCoverReader.h"
-#include "OEBTextStream.h"
+#include "OEBTextSampler.h"
 #include "../../bookmodel/BookModel.h"
 #include "../../library/Book.h"
 
@@ -125,33 +123,77 @@ ZLFile OEBPlugin::opfFile(const ZLFile &oebFile) {
 }
 
 bool OEBPlugin::readMetainfo(Book &book) const {
-	const ZLFile &file = book.file();
-	return OEBMetaInfoReader(book).readMetainfo(opfFile(file));
+	return OEBPackage::package(book.file())->readMetainfo(book);
 }
 
 std::vector<shared_ptr<FileEncryptionInfo> > OEBPlugin::readEncryptionInfos(const Book &book) const {
-	const ZLFile &opf = opfFile(book.file());
-	return OEBEncryptionReader().readEncryptionInfos(epubFile(opf), opf);
+	return OEBPackage::package(book.file())->encryptionInfos();
 }
 
 bool OEBPlugin::readUids(Book &book) const {
-	const ZLFile &file = book.file();
-	return OEBUidReader(book).readUids(opfFile(file));
+	return OEBPackage::package(book.file())->readUids(book);
 }
 
 bool OEBPlugin::readModel(BookModel &model) const {
 	const ZLFile &file = model.book()->file();
-	return OEBBookReader(model).readBook(opfFile(file));
+	const std::size_t threadsNumber = PluginCollection::Instance().loadingThreadsNumber();
+	return OEBBookReader(model, threadsNumber).readBook(*OEBPackage::package(file));
 }
 
 shared_ptr<const ZLImage> OEBPlugin::coverImage(const ZLFile &file) const {
-	return OEBCoverReader().readCover(opfFile(file));
+	return OEBPackage::package(file)->coverImage();
+}
+
+void OEBPlugin::detectLanguage(Book &book, const OEBPackage &package) {
+	PluginCollection &collection = PluginCollection::Instance();
+	if (!collection.isLanguageAutoDetectEnabled()) {
+		return;
+	}
+
+	// the detector runs on all the text collected so far after each sample,
+	// so it scans at most SAMPLES_NUMBER times the budget in total; the work
+	// is quadratic in the samples number, keep it small
+	static const std::size_t SAMPLES_NUMBER = 4;
+	// roughly a 0.5 correlation with the pattern
+	static const int CONFIDENT_CRITERION = 250000;
+
+	ZLLanguageDetector detector;
+	OEBTextSampler sampler(package, collection.languageDetectionBudget(), SAMPLES_NUMBER);
+	std::string text;
+	shared_ptr<ZLLanguageDetector::LanguageInfo> info;
+	while (sampler.addSample(text)) {
+		int criterion;
+		shared_ptr<ZLLanguageDetector::LanguageInfo> current =
+			detector.findInfoForEncoding(book.encoding(), text.data(), text.size(), -20000, criterion);
+		const bool confirmed =
+			!info.isNull() && !current.isNull() && info->Language == current->Language;
+		info = current;
+		// stop as soon as two samples agree with enough confidence
+		if (confirmed && criterion >= CONFIDENT_CRITERION) {
+			break;
+		}
+	}
+	if (!info.isNull() && !info->Language.empty()) {
+		book.setLanguage(info->Language);
+	}
 }
 
 bool OEBPlugin::readLanguageAndEncoding(Book &book) const {
 	if (book.language().empty()) {
-		shared_ptr<ZLInputStream> oebStream = new OEBTextStream(opfFile(book.file()));
-		detectLanguage(book, *oebStream, book.encoding());
+		detectLanguage(book, *OEBPackage::package(book.file()));
+	}
+	return true;
+}
+
+bool OEBPlugin::readAllMetainfo(Book &book, shared_ptr<const ZLImage> &cover, std::string&) const {
+	shared_ptr<OEBPackage> package = OEBPackage::package(book.file());
+	// uids are set by readMetainfo as well
+	if (!package->readMetainfo(book)) {
+		return false;
+	}
+	if (book.language().empty()) {
+		detectLanguage(book, *package);
 	}
+	cover = package->coverImage();
 	return true;
 }
@@ -22,6 +22,8 @@
 
 #include "../FormatPlugin.h"
 
+class OEBPackage;
+
 class OEBPlugin : public FormatPlugin {
 
 public:
@@ -38,6 +40,10 @@ public:
 	bool readLanguageAndEncoding(Book &book) const;
 	bool readModel(BookModel &model) const;
 	shared_ptr<const ZLImage> coverImage(const ZLFile &file) const;
+	bool readAllMetainfo(Book &book, shared_ptr<const ZLImage> &cover, std::string &annotation) const;
+
+private:
+	static void detectLanguage(Book &book, const OEBPackage &package);
 };
 
 #endif /* __OEBPLUGIN_H__ */
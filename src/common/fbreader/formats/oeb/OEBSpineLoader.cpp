@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <cstring>
+#include <algorithm>
+
+#include <zlib.h>
+
+#include <ZLFile.h>
+#include <ZLInputStream.h>
+#include <ZLXMLRecorder.h>
+
+#include "OEBSpineLoader.h"
+
+class LoadedInputStream : public ZLInputStream {
+
+public:
+	LoadedInputStream(std::string &data);
+
+private:
+	bool open();
+	std::size_t read(char *buffer, std::size_t maxSize);
+	void close();
+
+	void seek(int offset, bool absoluteOffset);
+	std::size_t offset() const;
+	std::size_t sizeOfOpened();
+
+private:
+	std::string myData;
+	std::size_t myOffset;
+};
+
+LoadedInputStream::LoadedInputStream(std::string &data) : myOffset(0) {
+	myData.swap(data);
+}
+
+bool LoadedInputStream::open() {
+	myOffset = 0;
+	return true;
+}
+
+std::size_t LoadedInputStream::read(char *buffer, std::size_t maxSize) {
+	const std::size_t len = std::min(maxSize, myData.length() - myOffset);
+	if (buffer != 0) {
+		myData.copy(buffer, len, myOffset);
+	}
+	myOffset += len;
+	return len;
+}
+
+void LoadedInputStream::close() {
+}
+
+void LoadedInputStream::seek(int offset, bool absoluteOffset) {
+	if (!absoluteOffset) {
+		offset += myOffset;
+	}
+	myOffset = std::max(0, std::min(offset, (int)myData.length()));
+}
+
+std::size_t LoadedInputStream::offset() const {
+	return myOffset;
+}
+
+std::size_t LoadedInputStream::sizeOfOpened() {
+	return myData.length();
+}
+
+// larger files are read in place, in chunks, so that a corrupt size never
+// makes a worker thread allocate a huge buffer
+static const int MAX_LOADED_SIZE = 64 * 1024 * 1024;
+
+OEBSpineLoader::Task::Task() : State(SKIPPED), Record(0) {
+}
+
+OEBSpineLoader::OEBSpineLoader(const std::vector<ZLFile> &files, shared_ptr<EncryptionMap> encryptionMap, const ZLXMLRecorder &recorder, std::size_t threadsNumber) : myRecorder(recorder), myTasks(files.size()), myWindowSize(2 * threadsNumber), myNextTask(0), myCurrentTask(0), myStopped(false) {
+	if (threadsNumber == 0) {
+		return;
+	}
+
+	for (std::size_t i = 0; i < files.size(); ++i) {
+		if (prepare(myTasks[i], files[i], encryptionMap)) {
+			myTasks[i].State = Task::PENDING;
+		}
+	}
+
+	pthread_mutex_init(&myMutex, 0);
+	pthread_cond_init(&myCondition, 0);
+	for (std::size_t i = 0; i < threadsNumber; ++i) {
+		pthread_t thread;
+		if (pthread_create(&thread, 0, run, this) != 0) {
+			break;
+		}
+		myThreads.push_back(thread);
+	}
+	if (myThreads.empty()) {
+		// nobody will load the files, so all of them are to be read in place
+		for (std::vector<Task>::iterator it = myTasks.begin(); it != myTasks.end(); ++it) {
+			it->State = Task::SKIPPED;
+		}
+	}
+}
+
+OEBSpineLoader::~OEBSpineLoader() {
+	if (myWindowSize == 0) {
+		return;
+	}
+	pthread_mutex_lock(&myMutex);
+	myStopped = true;
+	pthread_cond_broadcast(&myCondition);
+	pthread_mutex_unlock(&myMutex);
+	for (std::vector<pthread_t>::const_iterator it = myThreads.begin(); it != myThreads.end(); ++it) {
+		pthread_join(*it, 0);
+	}
+	for (std::vector<Task>::const_iterator it = myTasks.begin(); it != myTasks.end(); ++it) {
+		delete it->Record;
+	}
+	pthread_cond_destroy(&myCondition);
+	pthread_mutex_destroy(&myMutex);
+}
+
+// Only stored and deflated entries of a zip archive on the file system
+// and unencrypted plain files are loaded; other files are read in place,
+// the way XHTMLReader would read them without the loader.
+bool OEBSpineLoader::prepare(Task &task, const ZLFile &file, shared_ptr<EncryptionMap> encryptionMap) {
+	if (!encryptionMap.isNull() && !encryptionMap->info(file.path()).isNull()) {
+		return false;
+	}
+	ZLFile::ContentLocation &location = task.Location;
+	if (!file.contentLocation(location)) {
+		return false;
+	}
+	// sizes come from the archive and may be corrupt; they are checked
+	// against the archive size again before anything is allocated in load()
+	if (location.Offset < 0 || location.CompressedSize <= 0 || location.UncompressedSize < 0) {
+		return false;
+	}
+	if (location.CompressedSize > MAX_LOADED_SIZE || location.UncompressedSize > MAX_LOADED_SIZE) {
+		return false;
+	}
+	return location.CompressionMethod == 0 || location.CompressionMethod == 8;
+}
+
+bool OEBSpineLoader::load(Task &task) {
+	static const std::size_t OUT_BUFFER_SIZE = 32768;
+
+	const ZLFile::ContentLocation &location = task.Location;
+
+	const int fd = ::open(location.PhysicalPath.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat fileInfo;
+	if (::fstat(fd, &fileInfo) != 0 ||
+			(long long)location.Offset + location.CompressedSize > (long long)fileInfo.st_size) {
+		::close(fd);
+		return false;
+	}
+
+	std::string compressed(location.CompressedSize, '\0');
+	std::size_t done = 0;
+	while (done < compressed.length()) {
+		const ssize_t size = ::pread(fd, &compressed[done], compressed.length() - done, location.Offset + done);
+		if (size <= 0) {
+			break;
+		}
+		done += size;
+	}
+	::close(fd);
+	if (done < compressed.length()) {
+		return false;
+	}
+
+	if (location.CompressionMethod == 0) {
+		task.Data.swap(compressed);
+		return true;
+	}
+
+	z_stream zStream;
+	std::memset(&zStream, 0, sizeof(z_stream));
+	if (inflateInit2(&zStream, -MAX_WBITS) != Z_OK) {
+		return false;
+	}
+	// the declared size is only a hint: the buffer grows while inflating, and
+	// a deflated stream cannot expand by more than about 1032 times
+	task.Data.reserve(std::min((std::size_t)location.UncompressedSize, 1032 * compressed.length()));
+	char outBuffer[OUT_BUFFER_SIZE];
+	zStream.next_in = (Bytef*)compressed.data();
+	zStream.avail_in = compressed.length();
+	int code = Z_OK;
+	while (code == Z_OK) {
+		zStream.next_out = (Bytef*)outBuffer;
+		zStream.avail_out = OUT_BUFFER_SIZE;
+		code = inflate(&zStream, Z_SYNC_FLUSH);
+		task.Data.append(outBuffer, OUT_BUFFER_SIZE - zStream.avail_out);
+		if (task.Data.length() > (std::size_t)MAX_LOADED_SIZE) {
+			code = Z_DATA_ERROR;
+		}
+		if (code == Z_BUF_ERROR && zStream.avail_in == 0) {
+			// truncated stream: keep what was inflated, as ZLZDecompressor does
+			code = Z_STREAM_END;
+		}
+	}
+	inflateEnd(&zStream);
+	return code == Z_STREAM_END;
+}
+
+void *OEBSpineLoader::run(void *loader) {
+	((OEBSpineLoader*)loader)->work();
+	return 0;
+}
+
+void OEBSpineLoader::work() {
+	while (true) {
+		pthread_mutex_lock(&myMutex);
+		while (!myStopped && myNextTask < myTasks.size() && myNextTask >= myCurrentTask + myWindowSize) {
+			pthread_cond_wait(&myCondition, &myMutex);
+		}
+		if (myStopped || myNextTask >= myTasks.size()) {
+			pthread_mutex_unlock(&myMutex);
+			return;
+		}
+		Task &task = myTasks[myNextTask++];
+		pthread_mutex_unlock(&myMutex);
+
+		if (task.State != Task::PENDING) {
+			continue;
+		}
+		const bool loaded = load(task);
+		bool recorded = false;
+		if (loaded) {
+			ZLXMLRecord *record = new ZLXMLRecord();
+			recorded = myRecorder.record(task.Data, *record);
+			if (recorded) {
+				task.Record = record;
+				std::string().swap(task.Data);
+			} else {
+				delete record;
+			}
+		}
+
+		pthread_mutex_lock(&myMutex);
+		task.State = recorded ? Task::RECORDED : (loaded ? Task::LOADED : Task::FAILED);
+		pthread_cond_broadcast(&myCondition);
+		pthread_mutex_unlock(&myMutex);
+	}
+}
+
+OEBSpineLoader::Task &OEBSpineLoader::waitFor(std::size_t index) {
+	Task &task = myTasks[index];
+	pthread_mutex_lock(&myMutex);
+	myCurrentTask = index;
+	pthread_cond_broadcast(&myCondition);
+	while (task.State == Task::PENDING) {
+		pthread_cond_wait(&myCondition, &myMutex);
+	}
+	pthread_mutex_unlock(&myMutex);
+	return task;
+}
+
+shared_ptr<ZLXMLRecord> OEBSpineLoader::record(std::size_t index) {
+	if (myThreads.empty() || index >= myTasks.size()) {
+		return 0;
+	}
+
+	Task &task = waitFor(index);
+	if (task.State != Task::RECORDED || task.Record == 0) {
+		return 0;
+	}
+	shared_ptr<ZLXMLRecord> record = task.Record;
+	task.Record = 0;
+	return record;
+}
+
+shared_ptr<ZLInputStream> OEBSpineLoader::stream(std::size_t index) {
+	if (myThreads.empty() || index >= myTasks.size()) {
+		return 0;
+	}
+
+	Task &task = waitFor(index);
+	if (task.State != Task::LOADED) {
+		return 0;
+	}
+	return new LoadedInputStream(task.Data);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __OEBSPINELOADER_H__
+#define __OEBSPINELOADER_H__
+
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
+#include <shared_ptr.h>
+#include <ZLFile.h>
+#include <FileEncryptionInfo.h>
+
+class ZLInputStream;
+class ZLXMLRecord;
+class ZLXMLRecorder;
+
+// Reads (and inflates) spine files in worker threads, a few files ahead
+// of the model builder, and parses each of them into its own ZLXMLRecord.
+// The records are then taken in spine order by record() and replayed into
+// XHTMLReader on the calling thread, so styles, labels and the text model
+// are built in the same order as by a sequential read. Workers use only
+// their own file descriptors, buffers and expat parsers, no shared library
+// objects.
+class OEBSpineLoader {
+
+public:
+	// recorder must be created for the reader the records are replayed into
+	OEBSpineLoader(const std::vector<ZLFile> &files, shared_ptr<EncryptionMap> encryptionMap, const ZLXMLRecorder &recorder, std::size_t threadsNumber);
+	~OEBSpineLoader();
+
+	// wait for the index-th file; indices must not decrease between calls;
+	// record() returns 0 if the file was not parsed, it should be read
+	// from stream() then; stream() returns 0 if the file was not loaded
+	// either, it should be read in place
+	shared_ptr<ZLXMLRecord> record(std::size_t index);
+	shared_ptr<ZLInputStream> stream(std::size_t index);
+
+private:
+	struct Task {
+		Task();
+
+		enum {
+			SKIPPED,
+			PENDING,
+			LOADED,
+			RECORDED,
+			FAILED
+		} State;
+
+		ZLFile::ContentLocation Location;
+		std::string Data;
+		// owned by the task until record() is called
+		ZLXMLRecord *Record;
+	};
+
+	static bool prepare(Task &task, const ZLFile &file, shared_ptr<EncryptionMap> encryptionMap);
+	static bool load(Task &task);
+	static void *run(void *loader);
+	void work();
+	Task &waitFor(std::size_t index);
+
+private:
+	const ZLXMLRecorder &myRecorder;
+	std::vector<Task> myTasks;
+	std::vector<pthread_t> myThreads;
+	// how many tasks may be loaded ahead of the current one
+	std::size_t myWindowSize;
+
+	// the fields below are guarded by myMutex
+	pthread_mutex_t myMutex;
+	pthread_cond_t myCondition;
+	std::size_t myNextTask;
+	std::size_t myCurrentTask;
+	bool myStopped;
+
+private: // disable copying
+	OEBSpineLoader(const OEBSpineLoader &);
+	const OEBSpineLoader &operator = (const OEBSpineLoader &);
+};
+
+#endif /* __OEBSPINELOADER_H__ */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <algorithm>
+
+#include <ZLFile.h>
+#include <ZLXMLReader.h>
+#include <ZLUnicodeUtil.h>
+
+#include "OEBTextSampler.h"
+#include "OEBPackage.h"
+
+class OEBTextCollector : public ZLXMLReader {
+
+public:
+	OEBTextCollector(std::string &buffer, std::size_t limit);
+
+private:
+	void startElementHandler(const char *tag, const char **attributes);
+	void endElementHandler(const char *tag);
+	void characterDataHandler(const char *text, std::size_t len);
+
+private:
+	std::string &myBuffer;
+	const std::size_t myEnd;
+	bool myStarted;
+	bool mySpace;
+};
+
+OEBTextCollector::OEBTextCollector(std::string &buffer, std::size_t limit) : myBuffer(buffer), myEnd(buffer.size() + limit), myStarted(false), mySpace(false) {
+}
+
+void OEBTextCollector::startElementHandler(const char *tag, const char**) {
+	static const std::string BODY = "body";
+	if (!myStarted && ZLUnicodeUtil::equalsIgnoreCaseAscii(tag, BODY)) {
+		myStarted = true;
+	}
+	mySpace = true;
+}
+
+void OEBTextCollector::endElementHandler(const char*) {
+	mySpace = true;
+}
+
+void OEBTextCollector::characterDataHandler(const char *text, std::size_t len) {
+	if (!myStarted || isInterrupted()) {
+		return;
+	}
+	const char *end = text + len;
+	for (const char *ptr = text; ptr < end; ++ptr) {
+		switch (*ptr) {
+			case ' ':
+			case '\t':
+			case '\r':
+			case '\n':
+				mySpace = true;
+				break;
+			default:
+				if (mySpace) {
+					// the limit is checked on word boundaries only to never cut a multibyte character
+					if (myBuffer.size() >= myEnd) {
+						interrupt();
+						return;
+					}
+					if (!myBuffer.empty() && myBuffer[myBuffer.size() - 1] != ' ') {
+						myBuffer += ' ';
+					}
+					mySpace = false;
+				}
+				myBuffer += *ptr;
+				break;
+		}
+	}
+}
+
+OEBTextSampler::OEBTextSampler(const OEBPackage &package, std::size_t budget, std::size_t samplesNumber) : myFilePrefix(package.filePrefix()), mySpine(package.spine()), mySamplesNumber(std::max(samplesNumber, (std::size_t)1)), myBudget(budget), myNextItem(0), mySampleIndex(0) {
+	myFirstItem = mySpine.size() > mySamplesNumber ? std::max(mySpine.size() / 10, (std::size_t)1) : 0;
+}
+
+bool OEBTextSampler::addSample(std::string &buffer) {
+	if (mySampleIndex >= mySamplesNumber || myBudget == 0) {
+		return false;
+	}
+
+	const std::size_t share = myBudget / (mySamplesNumber - mySampleIndex);
+	std::size_t index = std::max(
+		myFirstItem + mySampleIndex * (mySpine.size() - myFirstItem) / mySamplesNumber,
+		myNextItem
+	);
+	std::size_t collected = 0;
+	// short (or image-only) items are completed by the following ones
+	for (; index < mySpine.size() && collected < share; ++index) {
+		collected += readItem(index, buffer, share - collected);
+	}
+	myNextItem = index;
+	++mySampleIndex;
+
+	if (collected == 0) {
+		if (buffer.empty() && myFirstItem > 0) {
+			// nothing but the skipped items has text
+			myFirstItem = 0;
+			myNextItem = 0;
+			mySampleIndex = 0;
+			return addSample(buffer);
+		}
+		mySampleIndex = mySamplesNumber;
+		return false;
+	}
+	myBudget -= std::min(collected, myBudget);
+	return true;
+}
+
+std::size_t OEBTextSampler::readItem(std::size_t index, std::string &buffer, std::size_t limit) const {
+	const std::size_t size = buffer.size();
+	OEBTextCollector(buffer, limit).readDocument(ZLFile(myFilePrefix + mySpine[index]));
+	return buffer.size() - size;
+}
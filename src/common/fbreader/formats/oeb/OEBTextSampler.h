@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __OEBTEXTSAMPLER_H__
+#define __OEBTEXTSAMPLER_H__
+
+#include <vector>
+#include <string>
+
+class OEBPackage;
+
+// Collects a bounded sample of the book text for language detection:
+// up to budget bytes taken from samplesNumber places spread through the spine,
+// leading items (cover, title page, etc.) are skipped in long enough books.
+// Each spine file is parsed in a streaming way and only until its share of the budget is filled.
+class OEBTextSampler {
+
+public:
+	OEBTextSampler(const OEBPackage &package, std::size_t budget, std::size_t samplesNumber);
+
+	// appends the next sample to buffer; returns false when the budget or the spine is exhausted
+	bool addSample(std::string &buffer);
+
+private:
+	std::size_t readItem(std::size_t index, std::string &buffer, std::size_t limit) const;
+
+private:
+	const std::string myFilePrefix;
+	const std::vector<std::string> mySpine;
+	const std::size_t mySamplesNumber;
+	std::size_t myBudget;
+	std::size_t myFirstItem;
+	std::size_t myNextItem;
+	std::size_t mySampleIndex;
+
+private: // disable copying
+	OEBTextSampler(const OEBTextSampler&);
+	const OEBTextSampler &operator = (const OEBTextSampler&);
+};
+
+#endif /* __OEBTEXTSAMPLER_H__ */
@@ -33,16 +33,21 @@
 #include "../util/EntityFilesCollector.h"
 #include "../util/MiscUtil.h"
 #include "../css/StyleSheetParser.h"
+#include "../css/CSSAtoms.h"
+#include "../css/StyleSheetCache.h"
 
 #include "../../bookmodel/BookReader.h"
 #include "../../bookmodel/BookModel.h"
 
-static const std::string ANY = "*";
 static const std::string EMPTY = "";
 static const XHTMLTagInfoList EMPTY_INFO_LIST;
 
 std::map<std::string,XHTMLTagAction*> XHTMLReader::ourTagActions;
 std::map<shared_ptr<XHTMLReader::FullNamePredicate>,XHTMLTagAction*> XHTMLReader::ourNsTagActions;
+std::set<std::string> XHTMLReader::ourNsTagActionNames;
+
+// distinct (ancestors, tag, classes) signatures kept by the style cache
+static const std::size_t STYLE_CACHE_NODES = 1 << 14;
 
 XHTMLTagAction::~XHTMLTagAction() {
 }
@@ -261,7 +266,8 @@ void XHTMLTagStyleAction::doAtStart(XHTMLReader &reader, const char **xmlattribu
 
 	if (reader.myReadState == XHTML_READ_NOTHING) {
 		reader.myReadState = XHTML_READ_STYLE;
-		reader.myTableParser = new StyleSheetTableParser(reader.myPathPrefix, reader.myStyleSheetTable, reader.myFontMap, reader.myEncryptionMap);
+		reader.makeStyleSheetTablePrivate();
+		reader.myTableParser = new StyleSheetTableParser(reader.myPathPrefix, *reader.myStyleSheetTable, reader.myFontMap, reader.myEncryptionMap);
 		ZLLogger::Instance().println("CSS", "parsing style tag content");
 	}
 }
@@ -298,21 +304,20 @@ void XHTMLTagLinkAction::doAtStart(XHTMLReader &reader, const char **xmlattribut
 	cssFilePath = cssFile.path();
 	shared_ptr<StyleSheetParserWithCache> parser = reader.myFileParsers[cssFilePath];
 	if (parser.isNull()) {
-		parser = new StyleSheetParserWithCache(
+		parser = StyleSheetCache::parser(
 			cssFile,
 			MiscUtil::htmlDirectoryPrefix(cssFilePath),
-			0,
 			reader.myEncryptionMap
 		);
 		reader.myFileParsers[cssFilePath] = parser;
-		ZLLogger::Instance().println("CSS", "creating stream");
-		shared_ptr<ZLInputStream> cssStream = cssFile.inputStream(reader.myEncryptionMap);
-		if (!cssStream.isNull()) {
-			ZLLogger::Instance().println("CSS", "parsing file");
-			parser->parseStream(cssStream);
-		}
 	}
-	parser->applyToTables(reader.myStyleSheetTable, *reader.myFontMap);
+	reader.myLinkedStyleSheets.push_back(parser);
+	if (reader.myStyleSheetTableIsShared) {
+		reader.myStyleSheetTable = StyleSheetCache::table(reader.myLinkedStyleSheets);
+	} else {
+		parser->applyToTable(*reader.myStyleSheetTable);
+	}
+	parser->applyToFontMap(*reader.myFontMap);
 }
 
 void XHTMLTagLinkAction::doAtEnd(XHTMLReader&) {
@@ -380,7 +385,7 @@ void XHTMLTagListAction::doAtEnd(XHTMLReader &reader) {
 void XHTMLTagItemAction::doAtStart(XHTMLReader &reader, const char**) {
 	bool restart = true;
 	if (reader.myTagDataStack.size() >= 2) {
-		restart = reader.myTagDataStack[reader.myTagDataStack.size() - 2]->Children.size() > 1;
+		restart = reader.myTagDataStack[reader.myTagDataStack.size() - 2].Children.size() > 1;
 	}
 	if (restart) {
 		endParagraph(reader);
@@ -594,14 +599,36 @@ XHTMLTagAction *XHTMLReader::addAction(const std::string &ns, const std::string
 	shared_ptr<FullNamePredicate> predicate = new FullNamePredicate(ns, name);
 	XHTMLTagAction *old = ourNsTagActions[predicate];
 	ourNsTagActions[predicate] = action;
+	ourNsTagActionNames.insert(name);
 	return old;
 }
 
-XHTMLTagAction *XHTMLReader::getAction(const std::string &lowerCasedTag) {
-	XHTMLTagAction *action = ourTagActions[lowerCasedTag];
-	if (action != 0) {
-		return action;
+// maps the atoms added since the last call to the name-keyed static tables
+void XHTMLReader::updateTagActions() {
+	for (std::size_t atom = myTagActions.size(); atom < myAtoms->size(); ++atom) {
+		const std::string &name = myAtoms->name(atom);
+		std::map<std::string,XHTMLTagAction*>::const_iterator it = ourTagActions.find(name);
+		myTagActions.push_back(it != ourTagActions.end() ? it->second : 0);
+		const std::size_t index = name.find(':');
+		const std::set<std::string>::const_iterator jt = index == std::string::npos ?
+			ourNsTagActionNames.find(name) : ourNsTagActionNames.find(name.substr(index + 1));
+		myNsTagActionNames.push_back(jt != ourNsTagActionNames.end());
 	}
+}
+
+XHTMLTagAction *XHTMLReader::getAction(std::size_t tag) {
+	if (tag >= myTagActions.size()) {
+		updateTagActions();
+	}
+	if (myTagActions[tag] != 0) {
+		return myTagActions[tag];
+	}
+
+	// namespace predicates are checked only for registered local names
+	if (!myNsTagActionNames[tag]) {
+		return 0;
+	}
+	const std::string &lowerCasedTag = myAtoms->name(tag);
 	for (std::map<shared_ptr<FullNamePredicate>,XHTMLTagAction*>::const_iterator it = ourNsTagActions.begin(); it != ourNsTagActions.end(); ++it) {
 		if (it->first->accepts(*this, lowerCasedTag)) {
 			return it->second;
@@ -697,8 +724,11 @@ void XHTMLReader::fillTagTable() {
 	}
 }
 
-XHTMLReader::XHTMLReader(BookReader &modelReader, shared_ptr<EncryptionMap> map) : myModelReader(modelReader), myEncryptionMap(map) {
+XHTMLReader::XHTMLReader(BookReader &modelReader, shared_ptr<EncryptionMap> map) : myModelReader(modelReader), myEncryptionMap(map), myStyleCache(STYLE_CACHE_NODES), myAtoms(new CSSAtoms()) {
+	myBrAtom = myAtoms->atom("br");
 	myMarkNextImageAsCover = false;
+	myParagraphPrefixReplayEnabled = true;
+	myStyleSheetTableIsShared = false;
 	//ZLLogger::Instance().registerClass("XHTML");
 }
 
@@ -706,7 +736,25 @@ void XHTMLReader::setMarkFirstImageAsCover() {
 	myMarkNextImageAsCover = true;
 }
 
-bool XHTMLReader::readFile(const ZLFile &file, const std::string &referenceName) {
+void XHTMLReader::setParagraphPrefixReplayEnabled(bool enabled) {
+	myParagraphPrefixReplayEnabled = enabled;
+}
+
+bool XHTMLReader::readFile(const ZLFile &file, const std::string &referenceName, shared_ptr<ZLInputStream> stream) {
+	startFile(file, referenceName);
+	const bool code = readDocument(stream.isNull() ? file.inputStream(myEncryptionMap) : stream);
+	endFile();
+	return code;
+}
+
+bool XHTMLReader::readFile(const ZLFile &file, const std::string &referenceName, const ZLXMLRecord &record) {
+	startFile(file, referenceName);
+	const bool code = readDocument(record);
+	endFile();
+	return code;
+}
+
+void XHTMLReader::startFile(const ZLFile &file, const std::string &referenceName) {
 	fillTagTable();
 
 	myPathPrefix = MiscUtil::htmlDirectoryPrefix(file.path());
@@ -722,68 +770,88 @@ bool XHTMLReader::readFile(const ZLFile &file, const std::string &referenceName)
 	myBodyCounter = 0;
 	myCurrentParagraphIsEmpty = true;
 
-	myStyleSheetTable.clear();
+	myLinkedStyleSheets.clear();
+	myStyleSheetTable = StyleSheetCache::table(myLinkedStyleSheets);
+	myStyleSheetTableIsShared = true;
 	myFontMap = new FontMap();
 	myTagDataStack.clear();
 
 	myStyleParser = new StyleSheetSingleStyleParser(myPathPrefix);
 	myTableParser.reset();
+}
 
-	return readDocument(file.inputStream(myEncryptionMap));
+void XHTMLReader::endFile() {
+	std::string stat = "computed style cache: ";
+	ZLStringUtil::appendNumber(stat, myStyleCache.hits());
+	stat += " hits, ";
+	ZLStringUtil::appendNumber(stat, myStyleCache.misses());
+	stat += " misses";
+	ZLLogger::Instance().println("CSS", stat);
 }
 
 const XHTMLTagInfoList &XHTMLReader::tagInfos(size_t depth) const {
 	if (myTagDataStack.size() < depth + 2) {
 		return EMPTY_INFO_LIST;
 	}
-	return myTagDataStack[myTagDataStack.size() - depth - 2]->Children;
+	return myTagDataStack[myTagDataStack.size() - depth - 2].Children;
 }
 
-bool XHTMLReader::matches(const shared_ptr<CSSSelector::Component> next, int depth, int pos) const {
-	if (next.isNull()) {
+// depth and pos define the element matched by the previous step:
+// pos is its index in tagInfos(depth), -1 for the root element
+bool XHTMLReader::matches(const std::vector<CSSSelectorIndex::Step> &steps, std::size_t index, std::size_t depth, int pos) const {
+	if (index == steps.size()) {
 		return true;
 	}
 
-	// TODO: check next->Selector.Next
-	const CSSSelector &selector = *(next->Selector);
-	switch (next->Delimiter) {
+	const CSSSelectorIndex::Step &step = steps[index];
+	const CSSSelector::Relation nextRelation =
+		index + 1 < steps.size() ? steps[index + 1].Relation : CSSSelector::Ancestor;
+	switch (step.Relation) {
 		default:
 			return false;
 		case CSSSelector::Parent:
-			return tagInfos(depth + 1).matches(selector, -1) && matches(selector.Next, depth + 1);
+		{
+			const XHTMLTagInfoList &parents = tagInfos(depth + 1);
+			return
+				!parents.empty() &&
+				parents.matches(parents.size() - 1, step) &&
+				matches(steps, index + 1, depth + 1, parents.size() - 1);
+		}
 		case CSSSelector::Ancestor:
-			if (selector.Next.isNull() || selector.Next->Delimiter == CSSSelector::Ancestor) {
-				for (size_t i = 1; i < myTagDataStack.size() - depth - 1; ++i) {
-					if (tagInfos(depth + i).matches(selector, -1)) {
-						return matches(selector.Next, i);
-					}
+			for (std::size_t i = depth + 1; ; ++i) {
+				const XHTMLTagInfoList &ancestors = tagInfos(i);
+				if (ancestors.empty()) {
+					return false;
 				}
-				return false;
-			} else {
-				for (size_t i = 1; i < myTagDataStack.size() - depth - 1; ++i) {
-					if (tagInfos(depth + i).matches(selector, -1) && matches(selector.Next, i)) {
+				if (ancestors.matches(ancestors.size() - 1, step)) {
+					// the nearest ancestor is the best candidate unless the next step is ">"
+					if (nextRelation == CSSSelector::Ancestor) {
+						return matches(steps, index + 1, i, ancestors.size() - 1);
+					} else if (matches(steps, index + 1, i, ancestors.size() - 1)) {
 						return true;
 					}
 				}
-				return false;
 			}
 		case CSSSelector::Predecessor:
-			if (!selector.Next.isNull() && selector.Next->Delimiter == CSSSelector::Previous) {
-				while (true) {
-					// it is guaranteed that pos will be decreased on each step
-					pos = tagInfos(depth).find(selector, 1, pos);
-					if (pos == -1) {
-						return false;
-					} else if (matches(selector.Next, depth, pos)) {
+		{
+			const XHTMLTagInfoList &siblings = tagInfos(depth);
+			for (int i = pos - 1; i >= 0; --i) {
+				if (siblings.matches(i, step)) {
+					// the nearest sibling is the best candidate unless the next step is "+"
+					if (nextRelation != CSSSelector::Previous) {
+						return matches(steps, index + 1, depth, i);
+					} else if (matches(steps, index + 1, depth, i)) {
 						return true;
 					}
 				}
-			} else {
-				const int index = tagInfos(depth).find(selector, 0, pos);
-				return index != -1 && matches(selector.Next, depth, index);
 			}
+			return false;
+		}
 		case CSSSelector::Previous:
-			return tagInfos(depth).matches(selector, pos - 1) && matches(selector.Next, depth, pos - 1);
+			return
+				pos > 0 &&
+				tagInfos(depth).matches(pos - 1, step) &&
+				matches(steps, index + 1, depth, pos - 1);
 	}
 }
 
@@ -792,20 +860,52 @@ void XHTMLReader::applySingleEntry(shared_ptr<ZLTextStyleEntry> entry) {
 		return;
 	}
 	addTextStyleEntry(*(entry->start()), myTagDataStack.size());
-	shared_ptr<TagData> data = myTagDataStack.back();
-	data->StyleEntries.push_back(entry);
+	TagData &data = myTagDataStack.back();
+	data.StyleEntries.push_back(entry);
 	const ZLTextStyleEntry::DisplayCode dc = entry->displayCode();
 	if (dc != ZLTextStyleEntry::DC_NOT_DEFINED) {
-		data->DisplayCode = dc;
+		data.DisplayCode = dc;
 	}
 }
 
-void XHTMLReader::applyTagStyles(const std::string &tag, const std::string &aClass) {
-	std::vector<std::pair<CSSSelector,shared_ptr<ZLTextStyleEntry> > > controls =
-		myStyleSheetTable.allControls(tag, aClass);
-	for (std::vector<std::pair<CSSSelector,shared_ptr<ZLTextStyleEntry> > >::const_iterator it = controls.begin(); it != controls.end(); ++it) {
-		if (matches(it->first.Next)) {
-			applySingleEntry(it->second);
+shared_ptr<XHTMLComputedStyle> XHTMLReader::computeStyle(const CSSSelectorIndex &index, std::size_t tag, const std::vector<std::size_t> &classes) const {
+	shared_ptr<XHTMLComputedStyle> style = new XHTMLComputedStyle();
+
+	style->PageBreakBefore = index.breakBefore(tag, CSSAtoms::ANY);
+	style->PageBreakAfter = index.breakAfter(tag, CSSAtoms::ANY);
+	for (std::vector<std::size_t>::const_iterator it = classes.begin(); it != classes.end(); ++it) {
+		const ZLBoolean3 bb = index.breakBefore(tag, *it);
+		if (bb != B3_UNDEFINED) {
+			style->PageBreakBefore = bb;
+		}
+		const ZLBoolean3 ba = index.breakAfter(tag, *it);
+		if (ba != B3_UNDEFINED) {
+			style->PageBreakAfter = ba;
+		}
+	}
+
+	collectTagStyles(*style, index, CSSAtoms::ANY, CSSAtoms::ANY);
+	collectTagStyles(*style, index, tag, CSSAtoms::ANY);
+	for (std::vector<std::size_t>::const_iterator it = classes.begin(); it != classes.end(); ++it) {
+		collectTagStyles(*style, index, CSSAtoms::ANY, *it);
+		collectTagStyles(*style, index, tag, *it);
+	}
+	return style;
+}
+
+void XHTMLReader::collectTagStyles(XHTMLComputedStyle &style, const CSSSelectorIndex &index, std::size_t tag, std::size_t aClass) const {
+	const std::vector<CSSSelectorIndex::Rule> *rules = index.rules(tag, aClass);
+	if (rules == 0) {
+		return;
+	}
+	const CSSAncestorFilter &ancestors = myTagDataStack.back().Ancestors;
+	const int pos = (int)tagInfos(0).size() - 1;
+	for (std::vector<CSSSelectorIndex::Rule>::const_iterator it = rules->begin(); it != rules->end(); ++it) {
+		if (it->UsesSiblings) {
+			style.DependsOnSiblings = true;
+		}
+		if (ancestors.mayContain(it->Filter) && matches(it->Steps, 0, 0, pos)) {
+			style.Entries.push_back(it->Entry);
 		}
 	}
 }
@@ -848,60 +948,96 @@ void XHTMLReader::addTextStyleEntry(const ZLTextStyleEntry &entry, unsigned char
 	}
 }
 
+void XHTMLReader::makeStyleSheetTablePrivate() {
+	if (myStyleSheetTableIsShared) {
+		myStyleSheetTable = new StyleSheetTable();
+		for (std::vector<shared_ptr<StyleSheetParserWithCache> >::const_iterator it = myLinkedStyleSheets.begin(); it != myLinkedStyleSheets.end(); ++it) {
+			(*it)->applyToTable(*myStyleSheetTable);
+		}
+		myStyleSheetTableIsShared = false;
+	}
+}
+
+std::size_t XHTMLReader::lowerCasedAtom(const char *tag) {
+	myNameBuffer.assign(tag);
+	ZLStringUtil::asciiToLowerInline(myNameBuffer);
+	return myAtoms->atom(myNameBuffer);
+}
+
 void XHTMLReader::startElementHandler(const char *tag, const char **attributes) {
-	const std::string sTag = ZLUnicodeUtil::toLowerAscii(tag);
-	if (sTag == "br") {
+	const std::size_t tagAtom = lowerCasedAtom(tag);
+	if (tagAtom == myBrAtom) {
 		restartParagraph(true);
 		return;
 	}
 
-	std::vector<std::string> classesList;
+	std::vector<std::size_t> &classAtoms = myClassAtoms;
+	classAtoms.clear();
 	const char *aClasses = attributeValue(attributes, "class");
 	if (aClasses != 0) {
-		const std::vector<std::string> split = ZLStringUtil::split(aClasses, " ", true);
-		for (std::vector<std::string>::const_iterator it = split.begin(); it != split.end(); ++it) {
-			classesList.push_back(*it);
+		const char *start = aClasses;
+		for (const char *ptr = aClasses; ; ++ptr) {
+			if (*ptr == ' ' || *ptr == '\0') {
+				if (ptr > start) {
+					classAtoms.push_back(myAtoms->atom(start, ptr - start));
+				}
+				if (*ptr == '\0') {
+					break;
+				}
+				start = ptr + 1;
+			}
 		}
 	}
 
 	if (!myTagDataStack.empty()) {
-		myTagDataStack.back()->Children.push_back(XHTMLTagInfo(sTag, classesList));
+		myTagDataStack.back().Children.add(tagAtom, classAtoms);
+	}
+	TagData &tagData = myTagDataStack.push();
+	const std::size_t stackSize = myTagDataStack.size();
+	if (stackSize >= 2) {
+		const TagData &parentData = myTagDataStack[stackSize - 2];
+		tagData.Ancestors = parentData.Ancestors;
+		// the root element has no tag info, so it is never matched as an ancestor
+		if (stackSize >= 3) {
+			const XHTMLTagInfoList &parentInfos = myTagDataStack[stackSize - 3].Children;
+			parentInfos.addTo(parentInfos.size() - 1, tagData.Ancestors);
+		}
+		if (parentData.StyleNode != XHTMLStyleCache::NO_NODE) {
+			tagData.StyleNode = myStyleCache.node(parentData.StyleNode, tagAtom, classAtoms);
+		}
+	} else {
+		tagData.StyleNode = myStyleCache.node(XHTMLStyleCache::NO_NODE, tagAtom, classAtoms);
 	}
-	myTagDataStack.push_back(new TagData());
-	TagData &tagData = *myTagDataStack.back();
 
-	static const std::string HASH = "#";
 	const char *id = attributeValue(attributes, "id");
 	if (id != 0) {
-		myModelReader.addHyperlinkLabel(myReferenceAlias + HASH + id);
+		myLabelBuffer.assign(myReferenceAlias).append(1, '#').append(id);
+		myModelReader.addHyperlinkLabel(myLabelBuffer);
 	}
 
-	ZLBoolean3 breakBefore = myStyleSheetTable.doBreakBefore(sTag, EMPTY);
-	tagData.PageBreakAfter = myStyleSheetTable.doBreakAfter(sTag, EMPTY);
-	for (std::vector<std::string>::const_iterator it = classesList.begin(); it != classesList.end(); ++it) {
-		const ZLBoolean3 bb = myStyleSheetTable.doBreakBefore(sTag, *it);
-		if (bb != B3_UNDEFINED) {
-			breakBefore = bb;
-		}
-		const ZLBoolean3 ba = myStyleSheetTable.doBreakAfter(sTag, *it);
-		if (ba != B3_UNDEFINED) {
-			tagData.PageBreakAfter = ba;
-		}
+	shared_ptr<CSSSelectorIndex> index = myStyleSheetTable->index(myAtoms);
+	shared_ptr<XHTMLComputedStyle> computed = myStyleCache.style(index, tagData.StyleNode);
+	if (computed.isNull()) {
+		computed = computeStyle(*index, tagAtom, classAtoms);
+		myStyleCache.setStyle(tagData.StyleNode, computed);
 	}
-	if (breakBefore == B3_TRUE) {
+	tagData.PageBreakAfter = computed->PageBreakAfter;
+	if (computed->PageBreakBefore == B3_TRUE) {
 		myModelReader.insertEndOfSectionParagraph();
 	}
 
-	XHTMLTagAction *action = getAction(sTag);
+	XHTMLTagAction *action = getAction(tagAtom);
 	if (action != 0 && action->isEnabled(myReadState)) {
 		action->doAtStart(*this, attributes);
 	}
 
-	applyTagStyles(ANY, EMPTY);
-	applyTagStyles(sTag, EMPTY);
-	for (std::vector<std::string>::const_iterator it = classesList.begin(); it != classesList.end(); ++it) {
-		applyTagStyles(EMPTY, *it);
-		applyTagStyles(sTag, *it);
+	// the action could change the table (<link> does), and so the index
+	if (myStyleSheetTable->index(myAtoms) != index) {
+		computed = computeStyle(*myStyleSheetTable->index(myAtoms), tagAtom, classAtoms);
+	}
+	const std::vector<shared_ptr<ZLTextStyleEntry> > &entries = computed->Entries;
+	for (std::vector<shared_ptr<ZLTextStyleEntry> >::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		applySingleEntry(*it);
 	}
 	const char *style = attributeValue(attributes, "style");
 	if (style != 0) {
@@ -914,12 +1050,12 @@ void XHTMLReader::startElementHandler(const char *tag, const char **attributes)
 }
 
 void XHTMLReader::endElementHandler(const char *tag) {
-	const std::string sTag = ZLUnicodeUtil::toLowerAscii(tag);
-	if (sTag == "br") {
+	const std::size_t tagAtom = lowerCasedAtom(tag);
+	if (tagAtom == myBrAtom) {
 		return;
 	}
 
-	const TagData &tagData = *myTagDataStack.back();
+	const TagData &tagData = myTagDataStack.back();
 	const std::vector<shared_ptr<ZLTextStyleEntry> > &entries = tagData.StyleEntries;
 	size_t entryCount = entries.size();
 	const unsigned char depth = myTagDataStack.size();
@@ -932,7 +1068,7 @@ void XHTMLReader::endElementHandler(const char *tag) {
 		}
 	}
 
-	XHTMLTagAction *action = getAction(sTag);
+	XHTMLTagAction *action = getAction(tagAtom);
 	if (action != 0 && action->isEnabled(myReadState)) {
 		action->doAtEnd(*this);
 		myNewParagraphInProgress = false;
@@ -948,24 +1084,57 @@ void XHTMLReader::endElementHandler(const char *tag) {
 		restartParagraph(false);
 	}
 
-	myTagDataStack.pop_back();
+	myTagDataStack.pop();
+}
+
+// font family lists are resolved through the font manager, and the result
+// depends on the fonts registered so far, so such entries are never replayed
+static bool hasFontFamilies(const std::vector<shared_ptr<ZLTextStyleEntry> > &entries) {
+	for (std::vector<shared_ptr<ZLTextStyleEntry> >::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		if ((*it)->isFeatureSupported(ZLTextStyleEntry::FONT_FAMILY)) {
+			return true;
+		}
+	}
+	return false;
 }
 
 void XHTMLReader::beginParagraph(bool restarted) {
 	myCurrentParagraphIsEmpty = true;
 	myModelReader.beginParagraph();
-	for (std::vector<shared_ptr<TagData> >::const_iterator it = myTagDataStack.begin(); it != myTagDataStack.end(); ++it) {
-		const std::vector<FBTextKind> &kinds = (*it)->TextKinds;
-		for (std::vector<FBTextKind>::const_iterator jt = kinds.begin(); jt != kinds.end(); ++jt) {
-			myModelReader.addControl(*jt, true);
+	const std::size_t stackSize = myTagDataStack.size();
+	for (std::size_t i = 0; i < stackSize; ++i) {
+		TagData &data = myTagDataStack[i];
+		const unsigned char depth = i + 1;
+		if (restarted && i + 1 == stackSize) {
+			addParagraphPrefix(data, depth, false);
+			continue;
+		}
+		if (!myParagraphPrefixReplayEnabled || hasFontFamilies(data.StyleEntries)) {
+			addParagraphPrefix(data, depth, true);
+			continue;
 		}
-		const std::vector<shared_ptr<ZLTextStyleEntry> > &entries = (*it)->StyleEntries;
-		bool inheritedOnly = !restarted || it + 1 != myTagDataStack.end();
-		const unsigned char depth = it - myTagDataStack.begin() + 1;
-		for (std::vector<shared_ptr<ZLTextStyleEntry> >::const_iterator jt = entries.begin(); jt != entries.end(); ++jt) {
-			shared_ptr<ZLTextStyleEntry> entry = inheritedOnly ? (*jt)->inherited() : (*jt)->start();
-			addTextStyleEntry(*entry, depth);
+		// every paragraph inside an element gets the same inherited
+		// entries, so they are built once and then copied
+		if (data.PrefixTextKindsNumber == data.TextKinds.size() &&
+				data.PrefixStyleEntriesNumber == data.StyleEntries.size() &&
+				myModelReader.addRecording(data.ParagraphPrefix)) {
+			continue;
 		}
+		myModelReader.startRecording(data.ParagraphPrefix);
+		addParagraphPrefix(data, depth, true);
+		myModelReader.stopRecording();
+		data.PrefixTextKindsNumber = data.TextKinds.size();
+		data.PrefixStyleEntriesNumber = data.StyleEntries.size();
+	}
+}
+
+void XHTMLReader::addParagraphPrefix(const TagData &data, unsigned char depth, bool inheritedOnly) {
+	for (std::vector<FBTextKind>::const_iterator it = data.TextKinds.begin(); it != data.TextKinds.end(); ++it) {
+		myModelReader.addControl(*it, true);
+	}
+	for (std::vector<shared_ptr<ZLTextStyleEntry> >::const_iterator it = data.StyleEntries.begin(); it != data.StyleEntries.end(); ++it) {
+		shared_ptr<ZLTextStyleEntry> entry = inheritedOnly ? (*it)->inherited() : (*it)->start();
+		addTextStyleEntry(*entry, depth);
 	}
 }
 
@@ -1004,7 +1173,7 @@ void XHTMLReader::restartParagraph(bool addEmptyLine) {
 
 void XHTMLReader::pushTextKind(FBTextKind kind) {
 	if (kind != UNKNOWN) {
-		myTagDataStack.back()->TextKinds.push_back(kind);
+		myTagDataStack.back().TextKinds.push_back(kind);
 	}
 }
 
@@ -1089,5 +1258,37 @@ const std::string &XHTMLReader::fileAlias(const std::string &fileName) const {
 	return it->second;
 }
 
-XHTMLReader::TagData::TagData() : PageBreakAfter(B3_UNDEFINED), DisplayCode(ZLTextStyleEntry::DC_INLINE) {
+XHTMLReader::TagData::TagData() : PageBreakAfter(B3_UNDEFINED), DisplayCode(ZLTextStyleEntry::DC_INLINE), StyleNode(XHTMLStyleCache::NO_NODE), PrefixTextKindsNumber(0), PrefixStyleEntriesNumber(0) {
+}
+
+void XHTMLReader::TagData::reset() {
+	TextKinds.clear();
+	StyleEntries.clear();
+	PageBreakAfter = B3_UNDEFINED;
+	DisplayCode = ZLTextStyleEntry::DC_INLINE;
+	Children.clear();
+	Ancestors = CSSAncestorFilter();
+	StyleNode = XHTMLStyleCache::NO_NODE;
+	// the recording is kept for its buffers only
+	ParagraphPrefix.Model = 0;
+	PrefixTextKindsNumber = 0;
+	PrefixStyleEntriesNumber = 0;
+}
+
+XHTMLReader::TagDataStack::TagDataStack() : mySize(0) {
+}
+
+XHTMLReader::TagDataStack::~TagDataStack() {
+	for (std::vector<TagData*>::const_iterator it = myData.begin(); it != myData.end(); ++it) {
+		delete *it;
+	}
+}
+
+XHTMLReader::TagData &XHTMLReader::TagDataStack::push() {
+	if (mySize == myData.size()) {
+		myData.push_back(new TagData());
+	} else {
+		myData[mySize]->reset();
+	}
+	return *myData[mySize++];
 }
@@ -22,6 +22,7 @@
 
 #include <string>
 #include <map>
+#include <set>
 #include <vector>
 #include <stack>
 
@@ -29,13 +30,16 @@
 #include <ZLXMLReader.h>
 #include <ZLVideoEntry.h>
 #include <FontMap.h>
+#include <ZLTextModel.h>
 
 #include "../css/StyleSheetTable.h"
 #include "../css/StyleSheetParser.h"
 #include "../../bookmodel/FBTextKind.h"
 #include "XHTMLTagInfo.h"
+#include "XHTMLStyleCache.h"
 
 class ZLFile;
+class ZLXMLRecord;
 
 class BookReader;
 class XHTMLReader;
@@ -74,8 +78,44 @@ public:
 		ZLBoolean3 PageBreakAfter;
 		ZLTextStyleEntry::DisplayCode DisplayCode;
 		XHTMLTagInfoList Children;
+		CSSAncestorFilter Ancestors;
+		// XHTMLStyleCache node
+		std::size_t StyleNode;
+		// what this level adds at the start of each paragraph, recorded
+		// when it had that many text kinds and style entries
+		ZLTextEntryRecording ParagraphPrefix;
+		std::size_t PrefixTextKindsNumber;
+		std::size_t PrefixStyleEntriesNumber;
 
 		TagData();
+		// as a new object, but keeps the capacity of the vectors
+		void reset();
+	};
+
+	// Popped TagData objects are kept and reset by the next push at
+	// the same depth, so elements and files reuse their memory
+	class TagDataStack {
+
+	public:
+		TagDataStack();
+		~TagDataStack();
+
+		bool empty() const;
+		std::size_t size() const;
+		TagData &operator [] (std::size_t index) const;
+		TagData &back() const;
+
+		TagData &push();
+		void pop();
+		void clear();
+
+	private:
+		std::vector<TagData*> myData;
+		std::size_t mySize;
+
+	private: // disable copying
+		TagDataStack(const TagDataStack&);
+		const TagDataStack &operator = (const TagDataStack&);
 	};
 
 public:
@@ -86,17 +126,31 @@ public:
 private:
 	static std::map<std::string,XHTMLTagAction*> ourTagActions;
 	static std::map<shared_ptr<FullNamePredicate>,XHTMLTagAction*> ourNsTagActions;
+	// local names used in ourNsTagActions
+	static std::set<std::string> ourNsTagActionNames;
 
 public:
 	XHTMLReader(BookReader &modelReader, shared_ptr<EncryptionMap> map);
 
-	bool readFile(const ZLFile &file, const std::string &referenceName);
+	// stream, if given, is used instead of file.inputStream()
+	bool readFile(const ZLFile &file, const std::string &referenceName, shared_ptr<ZLInputStream> stream = 0);
+	// record must be made by a ZLXMLRecorder created for this reader
+	bool readFile(const ZLFile &file, const std::string &referenceName, const ZLXMLRecord &record);
 	const std::string &fileAlias(const std::string &fileName) const;
 	const std::string normalizedReference(const std::string &reference) const;
 	void setMarkFirstImageAsCover();
+	// paragraph prefixes are recorded once per element and then copied;
+	// the copies are the same bytes, so the model is not smaller, only
+	// faster to build; on by default (see test/PrefixReplayTest.cpp)
+	void setParagraphPrefixReplayEnabled(bool enabled);
 
 private:
-	XHTMLTagAction *getAction(const std::string &tag);
+	void startFile(const ZLFile &file, const std::string &referenceName);
+	void endFile();
+
+	void updateTagActions();
+	XHTMLTagAction *getAction(std::size_t tag);
+	std::size_t lowerCasedAtom(const char *tag);
 
 	void startElementHandler(const char *tag, const char **attributes);
 	void endElementHandler(const char *tag);
@@ -110,13 +164,16 @@ private:
 	void endParagraph();
 	void restartParagraph(bool addEmptyLine);
 	const XHTMLTagInfoList &tagInfos(size_t depth) const;
-	bool matches(const shared_ptr<CSSSelector::Component> next, int depth = 0, int pos = -1) const;
+	bool matches(const std::vector<CSSSelectorIndex::Step> &steps, std::size_t index, std::size_t depth, int pos) const;
 
 	void applySingleEntry(shared_ptr<ZLTextStyleEntry> entry);
-	void applyTagStyles(const std::string &tag, const std::string &aClass);
+	shared_ptr<XHTMLComputedStyle> computeStyle(const CSSSelectorIndex &index, std::size_t tag, const std::vector<std::size_t> &classes) const;
+	void collectTagStyles(XHTMLComputedStyle &style, const CSSSelectorIndex &index, std::size_t tag, std::size_t aClass) const;
 	void addTextStyleEntry(const ZLTextStyleEntry &entry, unsigned char depth);
 
 	void pushTextKind(FBTextKind kind);
+	void addParagraphPrefix(const TagData &data, unsigned char depth, bool inheritedOnly);
+	void makeStyleSheetTablePrivate();
 
 private:
 	mutable std::map<std::string,std::string> myFileNumbers;
@@ -128,9 +185,14 @@ private:
 	std::string myReferenceDirName;
 	bool myPreformatted;
 	bool myNewParagraphInProgress;
-	StyleSheetTable myStyleSheetTable;
+	// shared with other files (see StyleSheetCache) until a <style> element
+	// needs to change it; then it is rebuilt as a private copy
+	shared_ptr<StyleSheetTable> myStyleSheetTable;
+	bool myStyleSheetTableIsShared;
+	std::vector<shared_ptr<StyleSheetParserWithCache> > myLinkedStyleSheets;
+	XHTMLStyleCache myStyleCache;
 	shared_ptr<FontMap> myFontMap;
-	std::vector<shared_ptr<TagData> > myTagDataStack;
+	TagDataStack myTagDataStack;
 	bool myCurrentParagraphIsEmpty;
 	shared_ptr<StyleSheetSingleStyleParser> myStyleParser;
 	shared_ptr<StyleSheetTableParser> myTableParser;
@@ -139,8 +201,22 @@ private:
 	int myBodyCounter;
 	std::stack<int> myListNumStack;
 	bool myMarkNextImageAsCover;
+	bool myParagraphPrefixReplayEnabled;
 	shared_ptr<ZLVideoEntry> myVideoEntry;
 
+	// names of the tags and classes met in this conversion
+	shared_ptr<CSSAtoms> myAtoms;
+	std::size_t myBrAtom;
+	// the static tables looked up for each of myAtoms, indexed by atom;
+	// myNsTagActionNames[atom] is true if the local name is in ourNsTagActionNames
+	std::vector<XHTMLTagAction*> myTagActions;
+	std::vector<bool> myNsTagActionNames;
+
+	// reused between elements to avoid allocations
+	std::string myNameBuffer;
+	std::string myLabelBuffer;
+	std::vector<std::size_t> myClassAtoms;
+
 	friend class XHTMLTagAction;
 	friend class XHTMLTagStyleAction;
 	friend class XHTMLTagLinkAction;
@@ -157,4 +233,11 @@ private:
 	friend class XHTMLTagSourceAction;
 };
 
+inline bool XHTMLReader::TagDataStack::empty() const { return mySize == 0; }
+inline std::size_t XHTMLReader::TagDataStack::size() const { return mySize; }
+inline XHTMLReader::TagData &XHTMLReader::TagDataStack::operator [] (std::size_t index) const { return *myData[index]; }
+inline XHTMLReader::TagData &XHTMLReader::TagDataStack::back() const { return *myData[mySize - 1]; }
+inline void XHTMLReader::TagDataStack::pop() { --mySize; }
+inline void XHTMLReader::TagDataStack::clear() { mySize = 0; }
+
 #endif /* __XHTMLREADER_H__ */
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "XHTMLStyleCache.h"
+
+const std::size_t XHTMLStyleCache::NO_NODE = (std::size_t)-1;
+
+bool XHTMLStyleCache::Signature::operator < (const Signature &signature) const {
+	if (Parent != signature.Parent) {
+		return Parent < signature.Parent;
+	}
+	if (Tag != signature.Tag) {
+		return Tag < signature.Tag;
+	}
+	return Classes < signature.Classes;
+}
+
+XHTMLStyleCache::XHTMLStyleCache(std::size_t maxNodes) : myMaxNodes(maxNodes), myHits(0), myMisses(0) {
+}
+
+std::size_t XHTMLStyleCache::node(std::size_t parent, std::size_t tag, const std::vector<std::size_t> &classes) {
+	myKey.Parent = parent;
+	myKey.Tag = tag;
+	myKey.Classes.assign(classes.begin(), classes.end());
+	std::map<Signature,std::size_t>::const_iterator it = myNodes.find(myKey);
+	if (it != myNodes.end()) {
+		return it->second;
+	}
+	if (myNodes.size() >= myMaxNodes) {
+		return NO_NODE;
+	}
+	const std::size_t id = myNodes.size();
+	myNodes.insert(std::make_pair(myKey, id));
+	return id;
+}
+
+shared_ptr<XHTMLComputedStyle> XHTMLStyleCache::style(shared_ptr<CSSSelectorIndex> index, std::size_t node) {
+	if (index != myIndex) {
+		myIndex = index;
+		myStyles.clear();
+	}
+	if (node < myStyles.size() && !myStyles[node].isNull()) {
+		++myHits;
+		return myStyles[node];
+	}
+	++myMisses;
+	return 0;
+}
+
+void XHTMLStyleCache::setStyle(std::size_t node, shared_ptr<XHTMLComputedStyle> style) {
+	if (node == NO_NODE || style->DependsOnSiblings) {
+		return;
+	}
+	if (node >= myStyles.size()) {
+		myStyles.resize(node + 1);
+	}
+	myStyles[node] = style;
+}
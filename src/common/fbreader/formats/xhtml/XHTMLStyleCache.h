@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __XHTMLSTYLECACHE_H__
+#define __XHTMLSTYLECACHE_H__
+
+#include <map>
+#include <vector>
+
+#include <shared_ptr.h>
+#include <ZLBoolean3.h>
+#include <ZLTextStyleEntry.h>
+
+#include "../css/CSSSelectorIndex.h"
+
+// Result of matching a stylesheet against an element;
+// it is never changed after being computed
+struct XHTMLComputedStyle {
+	XHTMLComputedStyle();
+
+	std::vector<shared_ptr<ZLTextStyleEntry> > Entries;
+	ZLBoolean3 PageBreakBefore;
+	ZLBoolean3 PageBreakAfter;
+	// some candidate rules have "+" or "~" steps, so the result
+	// depends on siblings and cannot be shared
+	bool DependsOnSiblings;
+};
+
+// Shares computed styles between elements with the same tag, classes
+// and ancestors. Such (parent, tag, classes) signatures are numbered
+// as nodes of a tree that lives as long as the cache; styles are
+// dropped whenever the stylesheet index changes.
+class XHTMLStyleCache {
+
+public:
+	static const std::size_t NO_NODE;
+
+public:
+	XHTMLStyleCache(std::size_t maxNodes);
+
+	// parent is NO_NODE for the root element; returns NO_NODE
+	// if the tree already has maxNodes nodes
+	std::size_t node(std::size_t parent, std::size_t tag, const std::vector<std::size_t> &classes);
+
+	// 0 if there is no style for the node, or the index has changed
+	shared_ptr<XHTMLComputedStyle> style(shared_ptr<CSSSelectorIndex> index, std::size_t node);
+	void setStyle(std::size_t node, shared_ptr<XHTMLComputedStyle> style);
+
+	std::size_t hits() const;
+	std::size_t misses() const;
+
+private:
+	struct Signature {
+		std::size_t Parent;
+		std::size_t Tag;
+		std::vector<std::size_t> Classes;
+
+		bool operator < (const Signature &signature) const;
+	};
+
+private:
+	const std::size_t myMaxNodes;
+	std::map<Signature,std::size_t> myNodes;
+	// reused for lookups
+	Signature myKey;
+
+	shared_ptr<CSSSelectorIndex> myIndex;
+	std::vector<shared_ptr<XHTMLComputedStyle> > myStyles;
+
+	std::size_t myHits;
+	std::size_t myMisses;
+
+private: // disable copying
+	XHTMLStyleCache(const XHTMLStyleCache&);
+	const XHTMLStyleCache &operator = (const XHTMLStyleCache&);
+};
+
+inline XHTMLComputedStyle::XHTMLComputedStyle() : PageBreakBefore(B3_UNDEFINED), PageBreakAfter(B3_UNDEFINED), DependsOnSiblings(false) {}
+
+inline std::size_t XHTMLStyleCache::hits() const { return myHits; }
+inline std::size_t XHTMLStyleCache::misses() const { return myMisses; }
+
+#endif /* __XHTMLSTYLECACHE_H__ */
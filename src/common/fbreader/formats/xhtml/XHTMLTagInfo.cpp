@@ -20,39 +20,37 @@
 #include <algorithm>
 
 #include "XHTMLTagInfo.h"
-#include "../css/CSSSelector.h"
 
-XHTMLTagInfo::XHTMLTagInfo(const std::string &tag, const std::vector<std::string> &classes) : Tag(tag), Classes(classes) {
+void XHTMLTagInfoList::add(std::size_t tag, const std::vector<std::size_t> &classes) {
+	Info info;
+	info.Tag = tag;
+	info.ClassesStart = myClasses.size();
+	myClasses.insert(myClasses.end(), classes.begin(), classes.end());
+	info.ClassesEnd = myClasses.size();
+	myInfos.push_back(info);
 }
 
-bool XHTMLTagInfo::matches(const CSSSelector &selector) const {
-	if (selector.Tag == "*") {
-		return selector.Class.empty();
-	}
-	if (!selector.Tag.empty() && selector.Tag != Tag) {
+void XHTMLTagInfoList::clear() {
+	myInfos.clear();
+	myClasses.clear();
+}
+
+bool XHTMLTagInfoList::matches(std::size_t index, const CSSSelectorIndex::Step &step) const {
+	const Info &info = myInfos[index];
+	if (step.Tag != CSSAtoms::ANY && step.Tag != info.Tag) {
 		return false;
 	}
-	if (selector.Class.empty()) {
+	if (step.Class == CSSAtoms::ANY) {
 		return true;
 	}
-	return std::find(Classes.begin(), Classes.end(), selector.Class) != Classes.end();
+	const std::vector<std::size_t>::const_iterator end = myClasses.begin() + info.ClassesEnd;
+	return std::find(myClasses.begin() + info.ClassesStart, end, step.Class) != end;
 }
 
-int XHTMLTagInfoList::find(const CSSSelector &selector, int from, int to) const {
-	if (from < 0) {
-		from = std::max(from + (int)size(), 0);
-	}
-	if (to <= 0) {
-		to += size();
+void XHTMLTagInfoList::addTo(std::size_t index, CSSAncestorFilter &filter) const {
+	const Info &info = myInfos[index];
+	filter.add(info.Tag, false);
+	for (std::size_t i = info.ClassesStart; i < info.ClassesEnd; ++i) {
+		filter.add(myClasses[i], true);
 	}
-	for (int i = std::min(to, (int)size()) - 1; i >= from; --i) {
-		if (at(i).matches(selector)) {
-			return i;
-		}
-	}
-	return -1;
-}
-
-bool XHTMLTagInfoList::matches(const CSSSelector &selector, int index) const {
-	return find(selector, index, index + 1) != -1;
 }
@@ -20,28 +20,40 @@
 #ifndef __XHTMLTAGINFO_H__
 #define __XHTMLTAGINFO_H__
 
-#include <string>
 #include <vector>
 
-class CSSSelector;
+#include "../css/CSSSelectorIndex.h"
 
-struct XHTMLTagInfo {
-	const std::string Tag;
-	const std::vector<std::string> Classes;
-
-	XHTMLTagInfo(const std::string &tag, const std::vector<std::string> &classes);
-	bool matches(const CSSSelector &selector) const;
-};
-
-class XHTMLTagInfoList : public std::vector<XHTMLTagInfo> {
+// Tags and classes of the children of one element, as CSSAtoms; all
+// class atoms are kept in one vector, so adding a child allocates
+// nothing once the list has been used for a while
+class XHTMLTagInfoList {
 
 public:
 	XHTMLTagInfoList();
-	int find(const CSSSelector &selector, int from, int to) const;
-	bool matches(const CSSSelector &selector, int index) const;
+
+	void add(std::size_t tag, const std::vector<std::size_t> &classes);
+	void clear();
+
+	bool empty() const;
+	std::size_t size() const;
+	bool matches(std::size_t index, const CSSSelectorIndex::Step &step) const;
+	void addTo(std::size_t index, CSSAncestorFilter &filter) const;
+
+private:
+	struct Info {
+		std::size_t Tag;
+		// classes are myClasses[ClassesStart] .. myClasses[ClassesEnd - 1]
+		std::size_t ClassesStart;
+		std::size_t ClassesEnd;
+	};
+
+	std::vector<Info> myInfos;
+	std::vector<std::size_t> myClasses;
 };
 
-inline XHTMLTagInfoList::XHTMLTagInfoList() {
-}
+inline XHTMLTagInfoList::XHTMLTagInfoList() {}
+inline bool XHTMLTagInfoList::empty() const { return myInfos.empty(); }
+inline std::size_t XHTMLTagInfoList::size() const { return myInfos.size(); }
 
 #endif /* __XHTMLTAGINFO_H__ */
@@ -18,6 +18,7 @@
  */
 
 #include <cstring>
+#include <climits>
 
 #include <ZLStringUtil.h>
 #include <ZLUnicodeUtil.h>
@@ -130,6 +131,49 @@ shared_ptr<ZLInputStream> ZLFile::inputStream(shared_ptr<EncryptionMap> encrypti
 	return envelopeCompressedStream(stream);
 }
 
+ZLFile::ContentLocation::ContentLocation() : Offset(0), CompressionMethod(0), CompressedSize(0), UncompressedSize(0) {
+}
+
+bool ZLFile::contentLocation(ContentLocation &location) const {
+	if (isCompressed()) {
+		return false;
+	}
+
+	const int index = ZLFSManager::Instance().findArchiveFileNameDelimiter(myPath);
+	if (index == -1) {
+		if (!exists() || isDirectory() || size() > (std::size_t)INT_MAX) {
+			return false;
+		}
+		location.PhysicalPath = myPath;
+		location.Offset = 0;
+		location.CompressionMethod = 0;
+		location.CompressedSize = size();
+		location.UncompressedSize = size();
+		return true;
+	}
+
+	const std::string baseName = myPath.substr(0, index);
+	const ZLFile baseFile(baseName);
+	if (!(baseFile.myArchiveType & ZIP) || baseFile.isCompressed() || baseFile.physicalFilePath() != baseName) {
+		return false;
+	}
+	shared_ptr<ZLInputStream> base = baseFile.inputStream();
+	if (base.isNull()) {
+		return false;
+	}
+	const ZLZipEntryCache::Info info =
+		ZLZipEntryCache::cache(baseName, *base)->info(myPath.substr(index + 1));
+	if (info.Offset < 0) {
+		return false;
+	}
+	location.PhysicalPath = baseName;
+	location.Offset = info.Offset;
+	location.CompressionMethod = info.CompressionMethod;
+	location.CompressedSize = info.CompressedSize;
+	location.UncompressedSize = info.UncompressedSize;
+	return true;
+}
+
 shared_ptr<ZLOutputStream> ZLFile::outputStream() const {
 	if (isCompressed()) {
 		return 0;
@@ -50,6 +50,18 @@ public:
 		ARCHIVE = 0xff00,
 	};
 
+	// where the file content lies inside a file of the file system
+	struct ContentLocation {
+		ContentLocation();
+
+		std::string PhysicalPath;
+		int Offset;
+		// as in zip headers: 0 for stored content, 8 for deflated
+		int CompressionMethod;
+		int CompressedSize;
+		int UncompressedSize;
+	};
+
 private:
 	ZLFile();
 
@@ -84,6 +96,9 @@ public:
 	shared_ptr<ZLInputStream> inputStream(shared_ptr<EncryptionMap> encryptionMap = 0) const;
 	shared_ptr<ZLOutputStream> outputStream() const;
 	shared_ptr<ZLDir> directory(bool createUnexisting = false) const;
+	// works for plain files and for entries of zip archives that are plain files;
+	// returns false for other files; entry sizes are taken from the archive as is
+	bool contentLocation(ContentLocation &location) const;
 
 	bool operator == (const ZLFile &other) const;
 	bool operator != (const ZLFile &other) const;
@@ -104,6 +104,11 @@ shared_ptr<ZLLanguageDetector::LanguageInfo> ZLLanguageDetector::findInfo(const
 }
 
 shared_ptr<ZLLanguageDetector::LanguageInfo> ZLLanguageDetector::findInfoForEncoding(const std::string &encoding, const char *buffer, std::size_t length, int matchingCriterion) {
+	int bestCriterion;
+	return findInfoForEncoding(encoding, buffer, length, matchingCriterion, bestCriterion);
+}
+
+shared_ptr<ZLLanguageDetector::LanguageInfo> ZLLanguageDetector::findInfoForEncoding(const std::string &encoding, const char *buffer, std::size_t length, int matchingCriterion, int &bestCriterion) {
 	shared_ptr<LanguageInfo> info;
 	std::map<int,shared_ptr<ZLMapBasedStatistics> > statisticsMap;
 	for (SBVector::const_iterator it = myMatchers.begin(); it != myMatchers.end(); ++it) {
@@ -126,5 +131,6 @@ shared_ptr<ZLLanguageDetector::LanguageInfo> ZLLanguageDetector::findInfoForEnco
 			matchingCriterion = criterion;
 		}
 	}
+	bestCriterion = matchingCriterion;
 	return info;
 }
@@ -42,6 +42,8 @@ public:
 
 	shared_ptr<LanguageInfo> findInfo(const char *buffer, std::size_t length, int matchingCriterion = 0);
 	shared_ptr<LanguageInfo> findInfoForEncoding(const std::string &encoding, const char *buffer, std::size_t length, int matchingCriterion = 0);
+	// same as above, also stores the criterion of the returned info (or matchingCriterion if none matched) in bestCriterion
+	shared_ptr<LanguageInfo> findInfoForEncoding(const std::string &encoding, const char *buffer, std::size_t length, int matchingCriterion, int &bestCriterion);
 
 private:
 	typedef std::vector<shared_ptr<ZLStatisticsBasedMatcher> > SBVector;
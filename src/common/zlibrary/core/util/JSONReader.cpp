@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2011-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <ZLFile.h>
+#include <ZLInputStream.h>
+#include <ZLUnicodeUtil.h>
+
+#include "JSONReader.h"
+#include "JSONWriter.h"
+
+shared_ptr<JSONValue> JSONValue::field(const std::string &key) const {
+	std::map<std::string,shared_ptr<JSONValue> >::const_iterator it = myFields.find(key);
+	return it != myFields.end() ? it->second : 0;
+}
+
+int JSONValue::intField(const std::string &key, int defaultValue) const {
+	shared_ptr<JSONValue> value = field(key);
+	return (!value.isNull() && value->type() == NUMBER) ? value->number() : defaultValue;
+}
+
+std::string JSONValue::stringField(const std::string &key) const {
+	shared_ptr<JSONValue> value = field(key);
+	return (!value.isNull() && value->type() == STRING) ? value->string() : std::string();
+}
+
+shared_ptr<JSONValue> JSONReader::readFile(const std::string &path) {
+	shared_ptr<ZLInputStream> stream = ZLFile(path).inputStream();
+	if (stream.isNull() || !stream->open()) {
+		return 0;
+	}
+	std::string data;
+	char buffer[8192];
+	for (std::size_t len = stream->read(buffer, sizeof(buffer)); len > 0; len = stream->read(buffer, sizeof(buffer))) {
+		data.append(buffer, len);
+	}
+	stream->close();
+	return read(data);
+}
+
+shared_ptr<JSONValue> JSONReader::read(const std::string &data) {
+	JSONReader reader(data);
+	if (data.size() >= 3 && (unsigned char)data[0] == 0xD9 && (unsigned char)data[1] == 0xD9 && (unsigned char)data[2] == 0xF7) {
+		shared_ptr<JSONValue> value = reader.readBinary();
+		return reader.myOffset == data.size() ? value : 0;
+	}
+	shared_ptr<JSONValue> value = reader.readValue();
+	reader.skipSpaces();
+	return reader.myOffset == data.size() ? value : 0;
+}
+
+JSONReader::JSONReader(const std::string &data) : myData(data), myOffset(0) {
+}
+
+void JSONReader::skipSpaces() {
+	while (myOffset < myData.size()) {
+		switch (myData[myOffset]) {
+			case ' ':
+			case '\t':
+			case '\n':
+			case '\r':
+				++myOffset;
+				break;
+			default:
+				return;
+		}
+	}
+}
+
+shared_ptr<JSONValue> JSONReader::readValue() {
+	skipSpaces();
+	if (myOffset >= myData.size()) {
+		return 0;
+	}
+	switch (myData[myOffset]) {
+		case '{':
+		{
+			shared_ptr<JSONValue> value = new JSONValue(JSONValue::MAP);
+			++myOffset;
+			skipSpaces();
+			if (myOffset < myData.size() && myData[myOffset] == '}') {
+				++myOffset;
+				return value;
+			}
+			while (true) {
+				skipSpaces();
+				std::string key;
+				if (!readString(key)) {
+					return 0;
+				}
+				skipSpaces();
+				if (myOffset >= myData.size() || myData[myOffset] != ':') {
+					return 0;
+				}
+				++myOffset;
+				shared_ptr<JSONValue> element = readValue();
+				if (element.isNull()) {
+					return 0;
+				}
+				value->myFields[key] = element;
+				skipSpaces();
+				if (myOffset >= myData.size()) {
+					return 0;
+				}
+				const char ch = myData[myOffset++];
+				if (ch == '}') {
+					return value;
+				} else if (ch != ',') {
+					return 0;
+				}
+			}
+		}
+		case '[':
+		{
+			shared_ptr<JSONValue> value = new JSONValue(JSONValue::ARRAY);
+			++myOffset;
+			skipSpaces();
+			if (myOffset < myData.size() && myData[myOffset] == ']') {
+				++myOffset;
+				return value;
+			}
+			while (true) {
+				skipSpaces();
+				int number;
+				if (myOffset < myData.size() &&
+						(myData[myOffset] == '-' || (myData[myOffset] >= '0' && myData[myOffset] <= '9'))) {
+					if (!readNumber(number)) {
+						return 0;
+					}
+					value->myNumbers.push_back(number);
+				} else {
+					shared_ptr<JSONValue> element = readValue();
+					if (element.isNull()) {
+						return 0;
+					}
+					value->myElements.push_back(element);
+				}
+				skipSpaces();
+				if (myOffset >= myData.size()) {
+					return 0;
+				}
+				const char ch = myData[myOffset++];
+				if (ch == ']') {
+					return value;
+				} else if (ch != ',') {
+					return 0;
+				}
+			}
+		}
+		case '"':
+		{
+			shared_ptr<JSONValue> value = new JSONValue(JSONValue::STRING);
+			return readString(value->myString) ? value : 0;
+		}
+		default:
+		{
+			shared_ptr<JSONValue> value = new JSONValue(JSONValue::NUMBER);
+			return readNumber(value->myNumber) ? value : 0;
+		}
+	}
+}
+
+bool JSONReader::readNumber(int &number) {
+	// JSONWriter prints ints as unsigned, so the value is taken modulo 2^32
+	bool negative = false;
+	if (myOffset < myData.size() && myData[myOffset] == '-') {
+		negative = true;
+		++myOffset;
+	}
+	const std::size_t start = myOffset;
+	unsigned int value = 0;
+	while (myOffset < myData.size() && myData[myOffset] >= '0' && myData[myOffset] <= '9') {
+		value = value * 10 + (myData[myOffset++] - '0');
+	}
+	if (myOffset == start) {
+		return false;
+	}
+	number = (int)(negative ? 0 - value : value);
+	return true;
+}
+
+bool JSONReader::readString(std::string &str) {
+	if (myOffset >= myData.size() || myData[myOffset] != '"') {
+		return false;
+	}
+	++myOffset;
+	std::size_t start = myOffset;
+	while (myOffset < myData.size()) {
+		const char ch = myData[myOffset];
+		if (ch == '"') {
+			str.append(myData, start, myOffset - start);
+			++myOffset;
+			return true;
+		} else if (ch != '\\') {
+			++myOffset;
+			continue;
+		}
+		str.append(myData, start, myOffset - start);
+		if (++myOffset >= myData.size()) {
+			return false;
+		}
+		switch (myData[myOffset++]) {
+			case 'b':
+				str += (char)0x08;
+				break;
+			case 'f':
+				str += (char)0x0C;
+				break;
+			case 'n':
+				str += '\n';
+				break;
+			case 'r':
+				str += '\r';
+				break;
+			case 't':
+				str += '\t';
+				break;
+			case 'u':
+			{
+				if (myOffset + 4 > myData.size()) {
+					return false;
+				}
+				ZLUnicodeUtil::Ucs4Char code = 0;
+				for (int i = 0; i < 4; ++i) {
+					const char digit = myData[myOffset++];
+					code <<= 4;
+					if (digit >= '0' && digit <= '9') {
+						code += digit - '0';
+					} else if (digit >= 'a' && digit <= 'f') {
+						code += digit - 'a' + 10;
+					} else if (digit >= 'A' && digit <= 'F') {
+						code += digit - 'A' + 10;
+					} else {
+						return false;
+					}
+				}
+				char buffer[4];
+				str.append(buffer, ZLUnicodeUtil::ucs4ToUtf8(buffer, code));
+				break;
+			}
+			default:
+				str += myData[myOffset - 1];
+				break;
+		}
+		start = myOffset;
+	}
+	return false;
+}
+
+shared_ptr<JSONValue> JSONReader::readBinary() {
+	unsigned char majorType;
+	unsigned int value;
+	bool indefinite;
+	// self-describe tag and the format version
+	if (!readBinaryHead(majorType, value, indefinite) || majorType != 6 || value != 55799) {
+		return 0;
+	}
+	if (!readBinaryHead(majorType, value, indefinite) || majorType != 0 || value != (unsigned int)JSONOutput::BINARY_VERSION) {
+		return 0;
+	}
+	return readBinaryValue();
+}
+
+bool JSONReader::readBinaryHead(unsigned char &majorType, unsigned int &value, bool &indefinite) {
+	if (myOffset >= myData.size()) {
+		return false;
+	}
+	const unsigned char initial = myData[myOffset++];
+	majorType = initial >> 5;
+	const unsigned char info = initial & 0x1F;
+	indefinite = false;
+	if (info < 24) {
+		value = info;
+		return true;
+	}
+	std::size_t length;
+	switch (info) {
+		case 24:
+			length = 1;
+			break;
+		case 25:
+			length = 2;
+			break;
+		case 26:
+			length = 4;
+			break;
+		case 31:
+			indefinite = true;
+			value = 0;
+			return majorType == 4 || majorType == 5;
+		default:
+			return false;
+	}
+	if (myOffset + length > myData.size()) {
+		return false;
+	}
+	value = 0;
+	for (std::size_t i = 0; i < length; ++i) {
+		value = (value << 8) | (unsigned char)myData[myOffset++];
+	}
+	return true;
+}
+
+bool JSONReader::readBinaryBreak() {
+	if (myOffset < myData.size() && (unsigned char)myData[myOffset] == 0xFF) {
+		++myOffset;
+		return true;
+	}
+	return false;
+}
+
+bool JSONReader::readBinaryString(std::string &str) {
+	unsigned char majorType;
+	unsigned int length;
+	bool indefinite;
+	if (!readBinaryHead(majorType, length, indefinite) || majorType != 3 || myOffset + length > myData.size()) {
+		return false;
+	}
+	str.assign(myData, myOffset, length);
+	myOffset += length;
+	return true;
+}
+
+shared_ptr<JSONValue> JSONReader::readBinaryValue() {
+	const std::size_t start = myOffset;
+	unsigned char majorType;
+	unsigned int head;
+	bool indefinite;
+	if (!readBinaryHead(majorType, head, indefinite)) {
+		return 0;
+	}
+	switch (majorType) {
+		case 0:
+		case 1:
+		{
+			shared_ptr<JSONValue> value = new JSONValue(JSONValue::NUMBER);
+			value->myNumber = majorType == 0 ? (int)head : (int)(0 - 1 - head);
+			return value;
+		}
+		case 3:
+		{
+			myOffset = start;
+			shared_ptr<JSONValue> value = new JSONValue(JSONValue::STRING);
+			return readBinaryString(value->myString) ? value : 0;
+		}
+		case 4:
+		{
+			shared_ptr<JSONValue> value = new JSONValue(JSONValue::ARRAY);
+			for (std::size_t i = 0; indefinite ? !readBinaryBreak() : i < head; ++i) {
+				if (myOffset < myData.size() && ((unsigned char)myData[myOffset] >> 5) <= 1) {
+					unsigned char elementType;
+					unsigned int number;
+					bool unused;
+					if (!readBinaryHead(elementType, number, unused)) {
+						return 0;
+					}
+					value->myNumbers.push_back(elementType == 0 ? (int)number : (int)(0 - 1 - number));
+					continue;
+				}
+				shared_ptr<JSONValue> element = readBinaryValue();
+				if (element.isNull()) {
+					return 0;
+				}
+				value->myElements.push_back(element);
+			}
+			return value;
+		}
+		case 5:
+		{
+			shared_ptr<JSONValue> value = new JSONValue(JSONValue::MAP);
+			for (std::size_t i = 0; indefinite ? !readBinaryBreak() : i < head; ++i) {
+				std::string key;
+				if (!readBinaryString(key)) {
+					return 0;
+				}
+				shared_ptr<JSONValue> element = readBinaryValue();
+				if (element.isNull()) {
+					return 0;
+				}
+				value->myFields[key] = element;
+			}
+			return value;
+		}
+		default:
+			return 0;
+	}
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2011-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __JSONREADER_H__
+#define __JSONREADER_H__
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <shared_ptr.h>
+
+class JSONValue {
+
+public:
+	enum Type {
+		NONE,
+		NUMBER,
+		STRING,
+		ARRAY,
+		MAP
+	};
+
+public:
+	JSONValue(Type type);
+
+	Type type() const;
+
+	int number() const;
+	const std::string &string() const;
+
+	// numeric array elements are stored in numbers(), all the others in elements();
+	// the model files never mix them, and large integer arrays stay compact this way
+	const std::vector<int> &numbers() const;
+	const std::vector<shared_ptr<JSONValue> > &elements() const;
+
+	shared_ptr<JSONValue> field(const std::string &key) const;
+	int intField(const std::string &key, int defaultValue) const;
+	std::string stringField(const std::string &key) const;
+	const std::map<std::string,shared_ptr<JSONValue> > &fields() const;
+
+private:
+	const Type myType;
+	int myNumber;
+	std::string myString;
+	std::vector<int> myNumbers;
+	std::vector<shared_ptr<JSONValue> > myElements;
+	std::map<std::string,shared_ptr<JSONValue> > myFields;
+
+friend class JSONReader;
+};
+
+// reads both the text and the binary (CBOR) form written by JSONWriter
+class JSONReader {
+
+public:
+	static shared_ptr<JSONValue> readFile(const std::string &path);
+	static shared_ptr<JSONValue> read(const std::string &data);
+
+private:
+	JSONReader(const std::string &data);
+
+	shared_ptr<JSONValue> readValue();
+	bool readString(std::string &str);
+	bool readNumber(int &number);
+	void skipSpaces();
+
+	shared_ptr<JSONValue> readBinary();
+	shared_ptr<JSONValue> readBinaryValue();
+	// returns false on error; indefinite is set for indefinite-length arrays and maps
+	bool readBinaryHead(unsigned char &majorType, unsigned int &value, bool &indefinite);
+	bool readBinaryString(std::string &str);
+	bool readBinaryBreak();
+
+private:
+	const std::string &myData;
+	std::size_t myOffset;
+};
+
+inline JSONValue::JSONValue(Type type) : myType(type), myNumber(0) {}
+inline JSONValue::Type JSONValue::type() const { return myType; }
+inline int JSONValue::number() const { return myNumber; }
+inline const std::string &JSONValue::string() const { return myString; }
+inline const std::vector<int> &JSONValue::numbers() const { return myNumbers; }
+inline const std::vector<shared_ptr<JSONValue> > &JSONValue::elements() const { return myElements; }
+inline const std::map<std::string,shared_ptr<JSONValue> > &JSONValue::fields() const { return myFields; }
+
+#endif /* __JSONREADER_H__ */
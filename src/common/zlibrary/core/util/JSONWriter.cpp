@@ -17,49 +17,124 @@
  * 02110-1301, USA.
  */
 
+#include <cstring>
+
 #include "JSONWriter.h"
 #include <ZLFile.h>
-#include <ZLStringUtil.h>
 
-JSONWriter::JSONWriter(const std::string &path, char start, char end) : myEndBracket(end), myRoot(true), myIsClosed(false), myIsEmpty(true) {
-	myStream = ZLFile(path).outputStream();
-	myStream->open();
-	myStream->write(start);
-}
+static const char DIGIT_PAIRS[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
 
-void JSONWriter::closeDescendants() {
-	if (!myCurrentArray.isNull()) {
-		myCurrentArray->close();
-		myCurrentArray.reset();
+// writes decimal representation of number right-aligned before end, returns its start
+static char *formatNumber(unsigned int number, char *end) {
+	while (number >= 100) {
+		const unsigned int index = 2 * (number % 100);
+		number /= 100;
+		*--end = DIGIT_PAIRS[index + 1];
+		*--end = DIGIT_PAIRS[index];
 	}
-	if (!myCurrentMap.isNull()) {
-		myCurrentMap->close();
-		myCurrentMap.reset();
+	if (number >= 10) {
+		*--end = DIGIT_PAIRS[2 * number + 1];
+		*--end = DIGIT_PAIRS[2 * number];
+	} else {
+		*--end = '0' + number;
 	}
+	return end;
 }
 
-bool JSONWriter::preAddElement() {
-	if (myIsClosed) {
-		return false;
+// CBOR major types and markers
+static const unsigned char CBOR_UNSIGNED = 0;
+static const unsigned char CBOR_NEGATIVE = 1;
+static const unsigned char CBOR_TEXT = 3;
+static const unsigned char CBOR_TAG = 6;
+static const unsigned char CBOR_ARRAY_START = 0x9F;
+static const unsigned char CBOR_MAP_START = 0xBF;
+static const unsigned char CBOR_BREAK = 0xFF;
+static const unsigned int CBOR_SELF_DESCRIBE_TAG = 55799;
+
+JSONOutput::JSONOutput(shared_ptr<ZLOutputStream> stream, Format format) : myStream(stream), myFormat(format), myLength(0) {
+	if (format == BINARY) {
+		writeBinaryHead(CBOR_TAG, CBOR_SELF_DESCRIBE_TAG);
+		writeBinaryHead(CBOR_UNSIGNED, BINARY_VERSION);
 	}
+}
 
-	closeDescendants();
+JSONOutput::~JSONOutput() {
+	close();
+}
 
-	if (!myIsEmpty) {
-		myStream->write(',');
+void JSONOutput::write(const char *data, std::size_t len) {
+	if (myLength + len > BUFFER_SIZE) {
+		flush();
+		if (len > BUFFER_SIZE) {
+			myStream->write(data, len);
+			return;
+		}
 	}
-	myIsEmpty = false;
+	std::memcpy(myBuffer + myLength, data, len);
+	myLength += len;
+}
 
-	return true;
+void JSONOutput::writeBinaryHead(unsigned char majorType, unsigned int value) {
+	if (myLength + 5 > BUFFER_SIZE) {
+		flush();
+	}
+	char *ptr = myBuffer + myLength;
+	majorType <<= 5;
+	if (value < 24) {
+		*ptr++ = majorType | value;
+	} else if (value <= 0xFF) {
+		*ptr++ = majorType | 24;
+		*ptr++ = value;
+	} else if (value <= 0xFFFF) {
+		*ptr++ = majorType | 25;
+		*ptr++ = value >> 8;
+		*ptr++ = value;
+	} else {
+		*ptr++ = majorType | 26;
+		*ptr++ = value >> 24;
+		*ptr++ = value >> 16;
+		*ptr++ = value >> 8;
+		*ptr++ = value;
+	}
+	myLength = ptr - myBuffer;
+}
+
+void JSONOutput::writeStart(char bracket) {
+	if (myFormat == TEXT) {
+		write(bracket);
+	} else {
+		write(bracket == '{' ? CBOR_MAP_START : CBOR_ARRAY_START);
+	}
+}
+
+void JSONOutput::writeEnd(char bracket) {
+	write(myFormat == TEXT ? bracket : CBOR_BREAK);
 }
 
-void JSONWriter::writeString(const std::string &str) {
-	myStream->write('\"');
+void JSONOutput::writeString(const std::string &str) {
+	if (myFormat == BINARY) {
+		writeBinaryHead(CBOR_TEXT, str.length());
+		write(str.data(), str.length());
+		return;
+	}
+
+	write('\"');
+	const char *data = str.data();
 	std::size_t start = 0;
 	const std::size_t len = str.length();
-	std::string escaped;
+	const char *escaped = 0;
 	for (std::size_t i = 0; i < len; ++i) {
-		switch ((char)str[i]) {
+		switch (data[i]) {
 			default:
 				continue;
 			case (char)0x08:
@@ -84,14 +159,107 @@ void JSONWriter::writeString(const std::string &str) {
 				escaped = "\\\\";
 				break;
 		}
-		myStream->write(str, start, i - start);
-		myStream->write(escaped);
+		write(data + start, i - start);
+		write(escaped, 2);
 		start = i + 1;
 	}
-	myStream->write(str, start, len - start);
-	myStream->write('\"');
+	write(data + start, len - start);
+	write('\"');
+}
+
+void JSONOutput::writeNumber(int number) {
+	if (myFormat == BINARY) {
+		if (number >= 0) {
+			writeBinaryHead(CBOR_UNSIGNED, number);
+		} else {
+			writeBinaryHead(CBOR_NEGATIVE, -1 - number);
+		}
+		return;
+	}
+
+	if (myLength + MAX_NUMBER_LENGTH > BUFFER_SIZE) {
+		flush();
+	}
+	char digits[MAX_NUMBER_LENGTH];
+	char *end = digits + MAX_NUMBER_LENGTH;
+	char *start = formatNumber((unsigned int)number, end);
+	std::memcpy(myBuffer + myLength, start, end - start);
+	myLength += end - start;
+}
+
+void JSONOutput::writeNumbers(const int *numbers, std::size_t count) {
+	if (myFormat == BINARY) {
+		for (std::size_t i = 0; i < count; ++i) {
+			writeNumber(numbers[i]);
+		}
+		return;
+	}
+
+	for (std::size_t i = 0; i < count; ++i) {
+		if (myLength + MAX_NUMBER_LENGTH + 1 > BUFFER_SIZE) {
+			flush();
+		}
+		if (i > 0) {
+			myBuffer[myLength++] = ',';
+		}
+		char digits[MAX_NUMBER_LENGTH];
+		char *end = digits + MAX_NUMBER_LENGTH;
+		char *start = formatNumber((unsigned int)numbers[i], end);
+		std::memcpy(myBuffer + myLength, start, end - start);
+		myLength += end - start;
+	}
+}
+
+void JSONOutput::flush() {
+	if (myLength > 0 && !myStream.isNull()) {
+		myStream->write(myBuffer, myLength);
+	}
+	myLength = 0;
+}
+
+void JSONOutput::close() {
+	if (!myStream.isNull()) {
+		flush();
+		myStream->close();
+		myStream.reset();
+	}
+}
+
+JSONWriter::JSONWriter(const std::string &path, JSONOutput::Format format, char start, char end) : myEndBracket(end), myRoot(true), myIsClosed(false), myIsEmpty(true) {
+	shared_ptr<ZLOutputStream> stream = ZLFile(path).outputStream();
+	stream->open();
+	myStream = new JSONOutput(stream, format);
+	myStream->writeStart(start);
 }
 
-void JSONWriter::writeNumber(int number) {
-	myStream->write(ZLStringUtil::numberToString(number));
+void JSONWriter::closeDescendants() {
+	if (!myCurrentArray.isNull()) {
+		myCurrentArray->close();
+		myCurrentArray.reset();
+	}
+	if (!myCurrentMap.isNull()) {
+		myCurrentMap->close();
+		myCurrentMap.reset();
+	}
+}
+
+bool JSONWriter::preAddElement() {
+	if (myIsClosed) {
+		return false;
+	}
+
+	closeDescendants();
+
+	if (!myIsEmpty) {
+		myStream->writeSeparator();
+	}
+	myIsEmpty = false;
+
+	return true;
+}
+
+void JSONArrayWriter::addElements(const std::vector<int> &values) {
+	if (!values.empty() && preAddElement()) {
+		myStream->writeNumbers(&values.front(), values.size());
+	}
 }
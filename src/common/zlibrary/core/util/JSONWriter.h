@@ -20,17 +20,74 @@
 #ifndef __JSONWRITER_H__
 #define __JSONWRITER_H__
 
+#include <vector>
+
 #include <shared_ptr.h>
 #include <ZLOutputStream.h>
 
 class JSONArrayWriter;
 class JSONMapWriter;
 
+// Encoder shared by a root writer and all its descendants;
+// the stream is written in BUFFER_SIZE chunks.
+//
+// BINARY format is CBOR: the self-describe tag 55799, the format version
+// (an unsigned integer) and the root value.  Maps and arrays are
+// indefinite-length, so they are written in one pass like the text form.
+class JSONOutput {
+
+public:
+	enum Format {
+		TEXT,
+		BINARY
+	};
+
+	static const int BINARY_VERSION = 1;
+
+public:
+	JSONOutput(shared_ptr<ZLOutputStream> stream, Format format);
+	~JSONOutput();
+
+	Format format() const;
+
+	void writeStart(char bracket);
+	void writeEnd(char bracket);
+	void writeSeparator();
+	void writeKeySeparator();
+	void writeString(const std::string &str);
+	// in TEXT format numbers are written as unsigned 32-bit values
+	void writeNumber(int number);
+	void writeNumbers(const int *numbers, std::size_t count);
+
+	void flush();
+	void close();
+
+private:
+	void write(char chr);
+	void write(const char *data, std::size_t len);
+	void writeBinaryHead(unsigned char majorType, unsigned int value);
+
+private:
+	enum {
+		BUFFER_SIZE = 16384,
+		MAX_NUMBER_LENGTH = 10
+	};
+
+	shared_ptr<ZLOutputStream> myStream;
+	const Format myFormat;
+	char myBuffer[BUFFER_SIZE];
+	std::size_t myLength;
+
+private: // disable copying
+	JSONOutput(const JSONOutput&);
+	const JSONOutput &operator = (const JSONOutput&);
+};
+
 class JSONWriter {
 
 protected:
-	JSONWriter(const std::string &path, char start, char end);
-	JSONWriter(shared_ptr<ZLOutputStream> stream, char start, char end);
+	JSONWriter(const std::string &path, JSONOutput::Format format, char start, char end);
+	JSONWriter(shared_ptr<JSONOutput> output, char start, char end);
 
 public:
 	virtual ~JSONWriter();
@@ -47,7 +104,7 @@ private:
 	void closeDescendants();
 
 protected:
-	shared_ptr<ZLOutputStream> myStream;
+	shared_ptr<JSONOutput> myStream;
 
 private:
 	const char myEndBracket;
@@ -65,10 +122,10 @@ class JSONMapWriter : public JSONWriter {
 friend class JSONWriter;
 
 public:
-	JSONMapWriter(const std::string &path);
+	JSONMapWriter(const std::string &path, JSONOutput::Format format = JSONOutput::TEXT);
 
 private:
-	JSONMapWriter(shared_ptr<ZLOutputStream> stream);
+	JSONMapWriter(shared_ptr<JSONOutput> output);
 
 public:
 	~JSONMapWriter();
@@ -88,10 +145,10 @@ class JSONArrayWriter : public JSONWriter {
 friend class JSONWriter;
 
 public:
-	JSONArrayWriter(const std::string &path);
+	JSONArrayWriter(const std::string &path, JSONOutput::Format format = JSONOutput::TEXT);
 
 private:
-	JSONArrayWriter(shared_ptr<ZLOutputStream> stream);
+	JSONArrayWriter(shared_ptr<JSONOutput> output);
 
 public:
 	~JSONArrayWriter();
@@ -100,10 +157,34 @@ public:
 	shared_ptr<JSONArrayWriter> addArray();
 	void addElement(const std::string &value);
 	void addElement(int value);
+	void addElements(const std::vector<int> &values);
 };
 
-inline JSONWriter::JSONWriter(shared_ptr<ZLOutputStream> stream, char start, char end) : myStream(stream), myEndBracket(end), myRoot(false), myIsClosed(false), myIsEmpty(true) {
-	stream->write(start);
+inline JSONOutput::Format JSONOutput::format() const {
+	return myFormat;
+}
+
+inline void JSONOutput::write(char chr) {
+	if (myLength == BUFFER_SIZE) {
+		flush();
+	}
+	myBuffer[myLength++] = chr;
+}
+
+inline void JSONOutput::writeSeparator() {
+	if (myFormat == TEXT) {
+		write(',');
+	}
+}
+
+inline void JSONOutput::writeKeySeparator() {
+	if (myFormat == TEXT) {
+		write(':');
+	}
+}
+
+inline JSONWriter::JSONWriter(shared_ptr<JSONOutput> output, char start, char end) : myStream(output), myEndBracket(end), myRoot(false), myIsClosed(false), myIsEmpty(true) {
+	output->writeStart(start);
 }
 
 inline JSONWriter::~JSONWriter() {
@@ -116,7 +197,7 @@ inline JSONWriter::~JSONWriter() {
 inline void JSONWriter::close() {
 	if (!myIsClosed) {
 		closeDescendants();
-		myStream->write(myEndBracket);
+		myStream->writeEnd(myEndBracket);
 		myIsClosed = true;
 	}
 }
@@ -131,10 +212,18 @@ inline shared_ptr<JSONArrayWriter> JSONWriter::createArray() {
 	return myCurrentArray;
 }
 
-inline JSONMapWriter::JSONMapWriter(const std::string &path) : JSONWriter(path, '{', '}') {
+inline void JSONWriter::writeString(const std::string &str) {
+	myStream->writeString(str);
 }
 
-inline JSONMapWriter::JSONMapWriter(shared_ptr<ZLOutputStream> stream) : JSONWriter(stream, '{', '}') {
+inline void JSONWriter::writeNumber(int number) {
+	myStream->writeNumber(number);
+}
+
+inline JSONMapWriter::JSONMapWriter(const std::string &path, JSONOutput::Format format) : JSONWriter(path, format, '{', '}') {
+}
+
+inline JSONMapWriter::JSONMapWriter(shared_ptr<JSONOutput> output) : JSONWriter(output, '{', '}') {
 }
 
 inline JSONMapWriter::~JSONMapWriter() {
@@ -143,13 +232,12 @@ inline JSONMapWriter::~JSONMapWriter() {
 inline bool JSONMapWriter::writeKeyAndColon(const std::string &key) {
 	if (preAddElement()) {
 		writeString(key);
-		myStream->write(':');
+		myStream->writeKeySeparator();
 		return true;
 	} else {
 		return false;
 	}
 }
-
 inline void JSONMapWriter::addElement(const std::string &key, const std::string &value) {
 	if (writeKeyAndColon(key)) {
 		writeString(value);
@@ -176,10 +264,10 @@ inline shared_ptr<JSONArrayWriter> JSONMapWriter::addArray(const std::string &ke
 	return writeKeyAndColon(key) ? createArray() : 0;
 }
 
-inline JSONArrayWriter::JSONArrayWriter(const std::string &path) : JSONWriter(path, '[', ']') {
+inline JSONArrayWriter::JSONArrayWriter(const std::string &path, JSONOutput::Format format) : JSONWriter(path, format, '[', ']') {
 }
 
-inline JSONArrayWriter::JSONArrayWriter(shared_ptr<ZLOutputStream> stream) : JSONWriter(stream, '[', ']') {
+inline JSONArrayWriter::JSONArrayWriter(shared_ptr<JSONOutput> output) : JSONWriter(output, '[', ']') {
 }
 
 inline JSONArrayWriter::~JSONArrayWriter() {
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <cstring>
+
+#include "ZLStringPool.h"
+
+const std::size_t ZLStringPool::NOT_FOUND = (std::size_t)-1;
+
+unsigned int ZLStringPool::hash(const char *data, std::size_t length) {
+	// 32-bit FNV-1a
+	unsigned int h = 2166136261U;
+	for (const char *end = data + length; data != end; ++data) {
+		h ^= (unsigned char)*data;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+ZLStringPool::ZLStringPool() : mySlots(16, 0) {
+}
+
+std::size_t ZLStringPool::slot(const char *data, std::size_t length, unsigned int hash) const {
+	const std::size_t mask = mySlots.size() - 1;
+	for (std::size_t index = hash & mask; ; index = (index + 1) & mask) {
+		const std::size_t value = mySlots[index];
+		if (value == 0) {
+			return index;
+		}
+		const std::string &str = myStrings[value - 1];
+		if (myHashes[value - 1] == hash && str.length() == length && std::memcmp(str.data(), data, length) == 0) {
+			return index;
+		}
+	}
+}
+
+std::size_t ZLStringPool::find(const char *data, std::size_t length) const {
+	const std::size_t value = mySlots[slot(data, length, hash(data, length))];
+	return value != 0 ? value - 1 : NOT_FOUND;
+}
+
+std::size_t ZLStringPool::intern(const char *data, std::size_t length) {
+	const unsigned int h = hash(data, length);
+	std::size_t index = slot(data, length, h);
+	if (mySlots[index] != 0) {
+		return mySlots[index] - 1;
+	}
+	if (2 * (myStrings.size() + 1) > mySlots.size()) {
+		rehash(2 * mySlots.size());
+		index = slot(data, length, h);
+	}
+	myStrings.push_back(std::string(data, length));
+	myHashes.push_back(h);
+	mySlots[index] = myStrings.size();
+	return myStrings.size() - 1;
+}
+
+void ZLStringPool::rehash(std::size_t capacity) {
+	std::vector<std::size_t>(capacity, 0).swap(mySlots);
+	const std::size_t mask = capacity - 1;
+	for (std::size_t id = 0; id < myStrings.size(); ++id) {
+		std::size_t index = myHashes[id] & mask;
+		while (mySlots[index] != 0) {
+			index = (index + 1) & mask;
+		}
+		mySlots[index] = id + 1;
+	}
+}
+
+void ZLStringPool::clear() {
+	myStrings.clear();
+	myHashes.clear();
+	std::vector<std::size_t>(16, 0).swap(mySlots);
+}
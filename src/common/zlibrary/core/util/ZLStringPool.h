@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __ZLSTRINGPOOL_H__
+#define __ZLSTRINGPOOL_H__
+
+#include <string>
+#include <vector>
+
+// Stores each distinct string once and gives it a dense integer id
+// (ids are assigned in insertion order, starting from 0).
+class ZLStringPool {
+
+public:
+	static const std::size_t NOT_FOUND;
+
+	static unsigned int hash(const char *data, std::size_t length);
+
+public:
+	ZLStringPool();
+
+	std::size_t intern(const std::string &str);
+	std::size_t intern(const char *data, std::size_t length);
+	std::size_t find(const std::string &str) const;
+	std::size_t find(const char *data, std::size_t length) const;
+
+	std::size_t size() const;
+	const std::string &string(std::size_t id) const;
+
+	void clear();
+
+private:
+	std::size_t slot(const char *data, std::size_t length, unsigned int hash) const;
+	void rehash(std::size_t capacity);
+
+private:
+	std::vector<std::string> myStrings;
+	std::vector<unsigned int> myHashes;
+	// open addressing, capacity is a power of 2; a slot contains id + 1 or 0 if empty
+	std::vector<std::size_t> mySlots;
+};
+
+inline std::size_t ZLStringPool::intern(const std::string &str) { return intern(str.data(), str.length()); }
+inline std::size_t ZLStringPool::find(const std::string &str) const { return find(str.data(), str.length()); }
+inline std::size_t ZLStringPool::size() const { return myStrings.size(); }
+inline const std::string &ZLStringPool::string(std::size_t id) const { return myStrings[id]; }
+
+#endif /* __ZLSTRINGPOOL_H__ */
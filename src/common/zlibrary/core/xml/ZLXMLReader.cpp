@@ -281,6 +281,14 @@ bool ZLXMLReader::readDocument(shared_ptr<ZLAsynchronousInputStream> stream) {
 	return stream->processInput(handler);
 }
 
+bool ZLXMLReader::readDocument(const ZLXMLRecord &record) {
+	myInterrupted = false;
+	myNamespaces.push_back(new nsMap());
+	ZLXMLReaderInternal::replay(*this, record);
+	shutdown();
+	return true;
+}
+
 const std::string &ZLXMLReader::errorMessage() const {
 	return myErrorMessage;
 }
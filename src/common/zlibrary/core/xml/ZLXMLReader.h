@@ -30,6 +30,7 @@ class ZLFile;
 class ZLInputStream;
 class ZLAsynchronousInputStream;
 class ZLXMLReaderInternal;
+class ZLXMLRecord;
 
 class ZLXMLReader {
 
@@ -96,6 +97,9 @@ public:
 	bool readDocument(const ZLFile &file);
 	bool readDocument(shared_ptr<ZLInputStream> stream);
 	bool readDocument(shared_ptr<ZLAsynchronousInputStream> stream);
+	// replays callbacks recorded by ZLXMLRecorder for this reader;
+	// getCurrentPosition() has no meaning in the handlers then
+	bool readDocument(const ZLXMLRecord &record);
 
 	const std::string &errorMessage() const;
 
@@ -137,6 +141,7 @@ private:
 
 friend class ZLXMLReaderInternal;
 friend class ZLXMLReaderHandler;
+friend class ZLXMLRecorder;
 };
 
 inline bool ZLXMLReader::isInterrupted() const {
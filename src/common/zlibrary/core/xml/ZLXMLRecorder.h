@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#ifndef __ZLXMLRECORDER_H__
+#define __ZLXMLRECORDER_H__
+
+#include <string>
+#include <vector>
+#include <map>
+
+class ZLXMLReader;
+
+// Parser callbacks of one document, in the order they were made;
+// ZLXMLReader::readDocument(const ZLXMLRecord&) passes them to a reader.
+class ZLXMLRecord {
+
+public:
+	ZLXMLRecord();
+
+private:
+	enum Event {
+		START_ELEMENT,
+		END_ELEMENT,
+		CHARACTER_DATA
+	};
+
+	void addStartElement(const char *name, const char **attributes);
+	void addEndElement(const char *name);
+	void addCharacterData(const char *text, std::size_t len);
+
+private:
+	std::string myData;
+
+friend class ZLXMLRecorder;
+friend class ZLXMLReaderInternal;
+
+private: // disable copying
+	ZLXMLRecord(const ZLXMLRecord &);
+	const ZLXMLRecord &operator = (const ZLXMLRecord &);
+};
+
+// Parses a document the way ZLXMLReader::readDocument does for the reader
+// given to the constructor (same DTDs, entities and buffer boundaries, so the
+// callbacks are the same), but only records the callbacks. Recording uses no
+// library objects (file system, encoding converters, logger), so several
+// threads may record documents with one recorder at once. Readers created
+// with an explicit encoding are not supported.
+class ZLXMLRecorder {
+
+private:
+	static void fStartElementHandler(void *userData, const char *name, const char **attributes);
+	static void fEndElementHandler(void *userData, const char *name);
+	static void fCharacterDataHandler(void *userData, const char *text, int len);
+
+public:
+	// reads the DTDs and entities of the reader, call it on the reader's thread
+	ZLXMLRecorder(ZLXMLReader &reader);
+
+	// returns false if the document cannot be recorded without library objects,
+	// e.g. it needs an encoding converter; it should be read by the reader then
+	bool record(const std::string &document, ZLXMLRecord &record) const;
+
+private:
+	std::vector<std::string> myDTDs;
+	std::map<std::string,std::string> myEntities;
+};
+
+inline ZLXMLRecord::ZLXMLRecord() {}
+
+#endif /* __ZLXMLRECORDER_H__ */
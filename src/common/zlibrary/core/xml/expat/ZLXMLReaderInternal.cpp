@@ -25,6 +25,7 @@
 
 #include "ZLXMLReaderInternal.h"
 #include "../ZLXMLReader.h"
+#include "../ZLXMLRecorder.h"
 
 void ZLXMLReaderInternal::fCharacterDataHandler(void *userData, const char *text, int len) {
 	ZLXMLReader &reader = *(ZLXMLReader*)userData;
@@ -147,6 +148,10 @@ void ZLXMLReaderInternal::init(const char *encoding) {
 
 	myInitialized = true;
 	XML_UseForeignDTD(myParser, XML_TRUE);
+	// DTD parsers copy the hash salt when they are created, but expat makes
+	// the salt only when the main parse starts; without a salt set here the
+	// DTD entities are stored with one salt and looked up with another one
+	XML_SetHashSalt(myParser, (unsigned long)myParser);
 
 	setupEntities();
 
@@ -167,3 +172,39 @@ bool ZLXMLReaderInternal::parseBuffer(const char *buffer, std::size_t len) {
 std::size_t ZLXMLReaderInternal::getCurrentPosition() const {
 	return XML_GetCurrentByteIndex(myParser);
 }
+
+void ZLXMLReaderInternal::replay(ZLXMLReader &reader, const ZLXMLRecord &record) {
+	const char *ptr = record.myData.data();
+	const char *end = ptr + record.myData.length();
+	std::vector<const char*> attributes;
+	std::size_t count;
+	while (ptr < end && !reader.isInterrupted()) {
+		switch (*ptr++) {
+			case ZLXMLRecord::START_ELEMENT:
+			{
+				const char *name = ptr;
+				ptr += std::strlen(ptr) + 1;
+				std::memcpy(&count, ptr, sizeof(std::size_t));
+				ptr += sizeof(std::size_t);
+				attributes.clear();
+				for (; count > 0; --count) {
+					attributes.push_back(ptr);
+					ptr += std::strlen(ptr) + 1;
+				}
+				attributes.push_back(0);
+				fStartElementHandler(&reader, name, &attributes[0]);
+				break;
+			}
+			case ZLXMLRecord::END_ELEMENT:
+				fEndElementHandler(&reader, ptr);
+				ptr += std::strlen(ptr) + 1;
+				break;
+			case ZLXMLRecord::CHARACTER_DATA:
+				std::memcpy(&count, ptr, sizeof(std::size_t));
+				ptr += sizeof(std::size_t);
+				fCharacterDataHandler(&reader, ptr, count);
+				ptr += count;
+				break;
+		}
+	}
+}
@@ -25,6 +25,7 @@
 #include <set>
 
 class ZLXMLReader;
+class ZLXMLRecord;
 
 class ZLXMLReaderInternal {
 
@@ -33,6 +34,9 @@ private:
 	static void fEndElementHandler(void *userData, const char *name);
 	static void fCharacterDataHandler(void *userData, const char *text, int len);
 
+public:
+	static void replay(ZLXMLReader &reader, const ZLXMLRecord &record);
+
 public:
 	ZLXMLReaderInternal(ZLXMLReader &reader, const char *encoding);
 	~ZLXMLReaderInternal();
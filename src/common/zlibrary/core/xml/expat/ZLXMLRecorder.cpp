@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <cstring>
+
+#include <algorithm>
+
+#include <expat.h>
+
+#include <ZLFile.h>
+#include <ZLInputStream.h>
+#include <ZLUnicodeUtil.h>
+
+#include "../ZLXMLRecorder.h"
+#include "../ZLXMLReader.h"
+
+// must be the same as in ZLXMLReader and ZLXMLReaderInternal
+static const std::size_t BUFFER_SIZE = 2048;
+// ZLXMLReader::readDocument looks for an encoding in a header of this size
+static const std::size_t HEADER_SIZE = 256;
+
+void ZLXMLRecord::addStartElement(const char *name, const char **attributes) {
+	myData += (char)START_ELEMENT;
+	myData.append(name, std::strlen(name) + 1);
+	std::size_t count = 0;
+	for (const char **a = attributes; *a != 0; ++a) {
+		++count;
+	}
+	myData.append((const char*)&count, sizeof(std::size_t));
+	for (const char **a = attributes; *a != 0; ++a) {
+		myData.append(*a, std::strlen(*a) + 1);
+	}
+}
+
+void ZLXMLRecord::addEndElement(const char *name) {
+	myData += (char)END_ELEMENT;
+	myData.append(name, std::strlen(name) + 1);
+}
+
+void ZLXMLRecord::addCharacterData(const char *text, std::size_t len) {
+	myData += (char)CHARACTER_DATA;
+	myData.append((const char*)&len, sizeof(std::size_t));
+	myData.append(text, len);
+}
+
+void ZLXMLRecorder::fStartElementHandler(void *userData, const char *name, const char **attributes) {
+	((ZLXMLRecord*)userData)->addStartElement(name, attributes);
+}
+
+void ZLXMLRecorder::fEndElementHandler(void *userData, const char *name) {
+	((ZLXMLRecord*)userData)->addEndElement(name);
+}
+
+void ZLXMLRecorder::fCharacterDataHandler(void *userData, const char *text, int len) {
+	((ZLXMLRecord*)userData)->addCharacterData(text, len);
+}
+
+// converters come from ZLEncodingCollection, so such documents are not recorded
+static int fUnknownEncodingHandler(void *encodingIsUnknown, const XML_Char*, XML_Encoding*) {
+	*(bool*)encodingIsUnknown = true;
+	return XML_STATUS_ERROR;
+}
+
+ZLXMLRecorder::ZLXMLRecorder(ZLXMLReader &reader) {
+	const std::vector<std::string> &dtds = reader.externalDTDs();
+	for (std::vector<std::string>::const_iterator it = dtds.begin(); it != dtds.end(); ++it) {
+		myDTDs.push_back(std::string());
+		shared_ptr<ZLInputStream> stream = ZLFile(*it).inputStream();
+		if (!stream.isNull() && stream->open()) {
+			char buffer[BUFFER_SIZE];
+			std::size_t length;
+			do {
+				length = stream->read(buffer, BUFFER_SIZE);
+				myDTDs.back().append(buffer, length);
+			} while (length == BUFFER_SIZE);
+			stream->close();
+		}
+	}
+	reader.collectExternalEntities(myEntities);
+}
+
+bool ZLXMLRecorder::record(const std::string &document, ZLXMLRecord &record) const {
+	// a shorter document makes readDocument look at stale buffer data
+	if (document.length() < HEADER_SIZE) {
+		return false;
+	}
+	std::string header = document.substr(0, HEADER_SIZE);
+	const int index = header.find('>');
+	if (index > 0) {
+		header = header.substr(0, index);
+		if (!ZLUnicodeUtil::isUtf8String(header)) {
+			return false;
+		}
+		// readDocument reads such documents as windows-1252
+		const int encodingIndex = ZLUnicodeUtil::toLowerAscii(header).find("\"iso-8859-1\"");
+		if (encodingIndex > 0) {
+			return false;
+		}
+	}
+
+	XML_Parser parser = XML_ParserCreate(0);
+	XML_UseForeignDTD(parser, XML_TRUE);
+	// see ZLXMLReaderInternal::init: DTD parsers copy the salt on creation
+	XML_SetHashSalt(parser, (unsigned long)parser);
+
+	// the same as parseDTD and parseExtraDTDEntities in ZLXMLReaderInternal
+	for (std::vector<std::string>::const_iterator it = myDTDs.begin(); it != myDTDs.end(); ++it) {
+		XML_Parser entityParser = XML_ExternalEntityParserCreate(parser, 0, 0);
+		std::size_t offset = 0;
+		std::size_t length;
+		do {
+			length = std::min(BUFFER_SIZE, it->length() - offset);
+			if (XML_Parse(entityParser, it->data() + offset, length, 0) == XML_STATUS_ERROR) {
+				break;
+			}
+			offset += length;
+		} while (length == BUFFER_SIZE);
+		XML_ParserFree(entityParser);
+	}
+	if (!myEntities.empty()) {
+		XML_Parser entityParser = XML_ExternalEntityParserCreate(parser, 0, 0);
+		std::string buffer;
+		for (std::map<std::string,std::string>::const_iterator it = myEntities.begin(); it != myEntities.end(); ++it) {
+			buffer.clear();
+			buffer.append("<!ENTITY ").append(it->first).append(" \"").append(it->second).append("\">");
+			if (XML_Parse(entityParser, buffer.data(), buffer.size(), 0) == XML_STATUS_ERROR) {
+				break;
+			}
+		}
+		XML_ParserFree(entityParser);
+	}
+
+	bool encodingIsUnknown = false;
+	XML_SetUserData(parser, &record);
+	XML_SetStartElementHandler(parser, fStartElementHandler);
+	XML_SetEndElementHandler(parser, fEndElementHandler);
+	XML_SetCharacterDataHandler(parser, fCharacterDataHandler);
+	XML_SetUnknownEncodingHandler(parser, fUnknownEncodingHandler, &encodingIsUnknown);
+
+	// readDocument never makes the final call, and neither does the recorder
+	std::size_t offset = 0;
+	std::size_t length;
+	do {
+		length = std::min(BUFFER_SIZE, document.length() - offset);
+		if (XML_Parse(parser, document.data() + offset, length, 0) == XML_STATUS_ERROR) {
+			break;
+		}
+		offset += length;
+	} while (length == BUFFER_SIZE);
+
+	XML_ParserFree(parser);
+	return !encodingIsUnknown;
+}
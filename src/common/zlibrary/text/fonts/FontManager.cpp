@@ -21,24 +21,97 @@
 
 #include "FontManager.h"
 
+static void appendFileInfo(std::string &signature, const shared_ptr<FileInfo> info) {
+	if (info.isNull()) {
+		signature += '\1';
+	} else {
+		signature += '\2';
+		signature += info->Path;
+	}
+	signature += '\0';
+}
+
+// Two entries are equal (FontEntry::operator ==) iff their signatures are equal
+static std::string signature(const FontEntry &entry) {
+	std::string signature;
+	appendFileInfo(signature, entry.Normal);
+	appendFileInfo(signature, entry.Bold);
+	appendFileInfo(signature, entry.Italic);
+	appendFileInfo(signature, entry.BoldItalic);
+	return signature;
+}
+
+std::size_t FontManager::nameId(const std::string &name) {
+	const std::size_t id = myNames.intern(name);
+	if (id == myEntriesById.size()) {
+		myEntriesById.push_back(0);
+		myRevisions.push_back(0);
+		myNextSuffixes.push_back(1);
+	}
+	return id;
+}
+
+void FontManager::setEntry(std::size_t id, shared_ptr<FontEntry> entry) {
+	myEntriesById[id] = entry;
+	myEntries[myNames.string(id)] = entry;
+	addSignature(id);
+}
+
+void FontManager::addSignature(std::size_t id) {
+	myRevisions[id] = myEntriesById[id]->revision();
+	const std::size_t signatureId = mySignatures.intern(signature(*myEntriesById[id]));
+	if (signatureId == mySignatureNames.size()) {
+		mySignatureNames.push_back(id);
+	} else if (myNames.string(id) < myNames.string(mySignatureNames[signatureId])) {
+		// keep the name the old linear search over the sorted map returned
+		mySignatureNames[signatureId] = id;
+	}
+}
+
+// entries are shared with FontMap and can be changed after registration;
+// in that case all the signatures are recomputed from the current entries
+void FontManager::updateSignatures() {
+	std::size_t id = 0;
+	for (; id < myEntriesById.size(); ++id) {
+		if (!myEntriesById[id].isNull() && myEntriesById[id]->revision() != myRevisions[id]) {
+			break;
+		}
+	}
+	if (id == myEntriesById.size()) {
+		return;
+	}
+
+	mySignatures.clear();
+	mySignatureNames.clear();
+	for (std::size_t id = 0; id < myEntriesById.size(); ++id) {
+		if (!myEntriesById[id].isNull()) {
+			addSignature(id);
+		}
+	}
+}
+
 std::string FontManager::put(const std::string &family, shared_ptr<FontEntry> entry) {
-	shared_ptr<FontEntry> existing = myEntries[family];
+	updateSignatures();
+
+	const std::size_t familyId = nameId(family);
+	shared_ptr<FontEntry> existing = myEntriesById[familyId];
 	if (existing.isNull() || *existing == *entry) {
-		myEntries[family] = entry;
+		setEntry(familyId, entry);
 		return family;
 	}
 
-	for (std::map<std::string,shared_ptr<FontEntry> >::const_iterator it = myEntries.begin(); it != myEntries.end(); ++it) {
-		if (*it->second == *entry) {
-			return it->first;
-		}
+	const std::size_t signatureId = mySignatures.find(signature(*entry));
+	if (signatureId != ZLStringPool::NOT_FOUND) {
+		return myNames.string(mySignatureNames[signatureId]);
 	}
 
-	for (int i = 1; i < 1000; ++i) {
+	for (int i = myNextSuffixes[familyId]; i < 1000; ++i) {
 		std::string indexed = family + "#";
 		ZLStringUtil::appendNumber(indexed, i);
-		if (myEntries[indexed].isNull()) {
-			myEntries[indexed] = entry;
+		const std::size_t id = nameId(indexed);
+		if (myEntriesById[id].isNull()) {
+			myNextSuffixes[familyId] = i + 1;
+			setEntry(id, entry);
 			return indexed;
 		}
 	}
@@ -47,14 +120,16 @@ std::string FontManager::put(const std::string &family, shared_ptr<FontEntry> en
 }
 
 int FontManager::familyListIndex(const std::vector<std::string> &familyList) {
-	std::vector<std::vector<std::string> >::const_iterator it =
-		std::find(myFamilyLists.begin(), myFamilyLists.end(), familyList);
-	if (it == myFamilyLists.end()) {
+	std::string key;
+	for (std::vector<std::string>::const_iterator it = familyList.begin(); it != familyList.end(); ++it) {
+		key += *it;
+		key += '\0';
+	}
+	const std::size_t index = myFamilyListKeys.intern(key);
+	if (index == myFamilyLists.size()) {
 		myFamilyLists.push_back(familyList);
-		return myFamilyLists.size() - 1;
-	} else {
-		return it - myFamilyLists.begin();
 	}
+	return index;
 }
 
 const std::map<std::string,shared_ptr<FontEntry> > &FontManager::entries() const {
@@ -26,6 +26,8 @@
 
 #include <shared_ptr.h>
 
+#include <ZLStringPool.h>
+
 #include <FontMap.h>
 
 class FontManager {
@@ -37,9 +39,28 @@ public:
 	const std::map<std::string,shared_ptr<FontEntry> > &entries() const;
 	const std::vector<std::vector<std::string> > &familyLists() const;
 
+private:
+	std::size_t nameId(const std::string &name);
+	void setEntry(std::size_t id, shared_ptr<FontEntry> entry);
+	void addSignature(std::size_t id);
+	void updateSignatures();
+
 private:
 	std::map<std::string,shared_ptr<FontEntry> > myEntries;
 	std::vector<std::vector<std::string> > myFamilyLists;
+
+	// registered names; the vectors below are indexed by name id
+	ZLStringPool myNames;
+	std::vector<shared_ptr<FontEntry> > myEntriesById;
+	// next suffix to try for family#i names generated from this name
+	std::vector<int> myNextSuffixes;
+	// FontEntry::revision() of the entries when their signatures were computed
+	std::vector<unsigned int> myRevisions;
+	// entry file lists (see FontManager.cpp) -> id of the first name registered with it
+	ZLStringPool mySignatures;
+	std::vector<std::size_t> mySignatureNames;
+	// family lists joined with '\0'; ids coincide with myFamilyLists indices
+	ZLStringPool myFamilyListKeys;
 };
 
 #endif /* __FONTMANAGER_H__ */
@@ -25,6 +25,7 @@ FileInfo::FileInfo(const std::string &path, shared_ptr<FileEncryptionInfo> info)
 }
 
 void FontEntry::addFile(bool bold, bool italic, const std::string &filePath, shared_ptr<FileEncryptionInfo> encryptionInfo) {
+	++myRevision;
 	shared_ptr<FileInfo> fileInfo = new FileInfo(filePath, encryptionInfo);
 	if (bold) {
 		if (italic) {
@@ -42,6 +43,7 @@ void FontEntry::addFile(bool bold, bool italic, const std::string &filePath, sha
 }
 
 void FontEntry::merge(const FontEntry &fontEntry) {
+	++myRevision;
 	if (!fontEntry.Normal.isNull()) {
 		Normal = fontEntry.Normal;
 	}
@@ -40,19 +40,31 @@ public:
 class FontEntry {
 
 public:
+	FontEntry();
+
 	void addFile(bool bold, bool italic, const std::string &filePath, shared_ptr<FileEncryptionInfo> encryptionInfo);
 	void merge(const FontEntry &fontEntry);
 
 	bool operator == (const FontEntry &other) const;
 	bool operator != (const FontEntry &other) const;
 
+	// number of addFile/merge calls on this entry; entries are shared between
+	// FontMap and FontManager, so a change means an indexed entry has changed
+	unsigned int revision() const;
+
 public:
 	shared_ptr<FileInfo> Normal;
 	shared_ptr<FileInfo> Bold;
 	shared_ptr<FileInfo> Italic;
 	shared_ptr<FileInfo> BoldItalic;
+
+private:
+	unsigned int myRevision;
 };
 
+inline FontEntry::FontEntry() : myRevision(0) {}
+inline unsigned int FontEntry::revision() const { return myRevision; }
+
 class FontMap {
 
 public:
@@ -31,9 +31,7 @@ void JSONUtil::serializeStringArray(const std::vector<std::string> &array, share
 }
 
 void JSONUtil::serializeIntArray(const std::vector<int> &array, shared_ptr<JSONArrayWriter> writer) {
-	for (std::vector<int>::const_iterator it = array.begin(); it != array.end(); ++it) {
-		writer->addElement(*it);
-	}
+	writer->addElements(array);
 }
 
 void JSONUtil::serializeIntArrayAsDiffs(const std::vector<int> &array, shared_ptr<JSONArrayWriter> writer) {
@@ -60,7 +58,13 @@ void JSONUtil::serializeIntArrayAsCounts(const std::vector<int> &array, shared_p
 
 void JSONUtil::serializeByteArray(const std::vector<unsigned char> &array, shared_ptr<JSONArrayWriter> writer) {
 	for (std::vector<unsigned char>::const_iterator it = array.begin(); it != array.end(); ++it) {
-		writer->addElement((int)*it);
+		writer->addElement(*it);
+	}
+}
+
+void JSONUtil::serializeByteArray(const std::string &bytes, shared_ptr<JSONArrayWriter> writer) {
+	for (std::string::const_iterator it = bytes.begin(); it != bytes.end(); ++it) {
+		writer->addElement((unsigned char)*it);
 	}
 }
 
@@ -37,6 +37,7 @@ struct JSONUtil {
 	static void serializeIntArrayAsDiffs(const std::vector<int> &array, shared_ptr<JSONArrayWriter> writer);
 	static void serializeIntArrayAsCounts(const std::vector<int> &array, shared_ptr<JSONArrayWriter> writer);
 	static void serializeByteArray(const std::vector<unsigned char> &array, shared_ptr<JSONArrayWriter> writer);
+	static void serializeByteArray(const std::string &bytes, shared_ptr<JSONArrayWriter> writer);
 
 	static void serializeFileEncryptionInfo(const FileEncryptionInfo& info, shared_ptr<JSONMapWriter> writer);
 	static void serializeFileInfo(const FileInfo& info, shared_ptr<JSONMapWriter> writer);
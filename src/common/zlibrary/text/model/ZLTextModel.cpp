@@ -32,6 +32,7 @@
 #include "ZLTextModel.h"
 #include "ZLTextParagraph.h"
 #include "ZLTextStyleEntry.h"
+#include "ZLTextSearchIndex.h"
 #include "ZLVideoEntry.h"
 
 ZLTextModel::ZLTextModel(const std::string &id, const std::string &language, const std::size_t rowSize,
@@ -40,6 +41,8 @@ ZLTextModel::ZLTextModel(const std::string &id, const std::string &language, con
 	myLanguage(language.empty() ? ZLibrary::Language() : language),
 	myAllocator(new ZLCachedMemoryAllocator(rowSize, directoryName, fileExtension)),
 	myLastEntryStart(0),
+	myStyleReferencesEnabled(false),
+	myRecording(0),
 	myFontManager(fontManager) {
 }
 
@@ -48,13 +51,12 @@ ZLTextModel::ZLTextModel(const std::string &id, const std::string &language, sha
 	myLanguage(language.empty() ? ZLibrary::Language() : language),
 	myAllocator(allocator),
 	myLastEntryStart(0),
+	myStyleReferencesEnabled(false),
+	myRecording(0),
 	myFontManager(fontManager) {
 }
 
 ZLTextModel::~ZLTextModel() {
-	for (std::vector<ZLTextParagraph*>::const_iterator it = myParagraphs.begin(); it != myParagraphs.end(); ++it) {
-		delete *it;
-	}
 }
 
 /*
@@ -123,7 +125,7 @@ ZLTextMark ZLTextModel::previousMark(ZLTextMark position) const {
 }
 */
 
-void ZLTextModel::addParagraphInternal(ZLTextParagraph *paragraph) {
+void ZLTextModel::addParagraphInternal(ZLTextParagraph::Kind kind) {
 	const std::size_t dataSize = myAllocator->blocksNumber();
 	const std::size_t bytesOffset = myAllocator->currentBytesOffset();
 
@@ -131,9 +133,8 @@ void ZLTextModel::addParagraphInternal(ZLTextParagraph *paragraph) {
 	myStartEntryOffsets.push_back(bytesOffset / 2); // offset in words for future use in Java
 	myParagraphLengths.push_back(0);
 	myTextSizes.push_back(myTextSizes.empty() ? 0 : myTextSizes.back());
-	myParagraphKinds.push_back(paragraph->kind());
+	myParagraphKinds.push_back(kind);
 
-	myParagraphs.push_back(paragraph);
 	myLastEntryStart = 0;
 }
 
@@ -147,73 +148,51 @@ ZLTextPlainModel::ZLTextPlainModel(const std::string &id, const std::string &lan
 }
 
 void ZLTextPlainModel::createParagraph(ZLTextParagraph::Kind kind) {
-	ZLTextParagraph *paragraph = (kind == ZLTextParagraph::TEXT_PARAGRAPH) ? new ZLTextParagraph() : new ZLTextSpecialParagraph(kind);
-	addParagraphInternal(paragraph);
+	addParagraphInternal(kind);
 }
 
 void ZLTextModel::addText(const std::string &text) {
-	ZLUnicodeUtil::Ucs2String ucs2str;
-	ZLUnicodeUtil::utf8ToUcs2(ucs2str, text);
-	const std::size_t len = ucs2str.size();
+	addText(text.data(), text.length());
+}
 
-	if (myLastEntryStart != 0 && *myLastEntryStart == ZLTextParagraphEntry::TEXT_ENTRY) {
-		const std::size_t oldLen = ZLCachedMemoryAllocator::readUInt32(myLastEntryStart + 2);
-		const std::size_t newLen = oldLen + len;
-		myLastEntryStart = myAllocator->reallocateLast(myLastEntryStart, 2 * newLen + 6);
-		ZLCachedMemoryAllocator::writeUInt32(myLastEntryStart + 2, newLen);
-		std::memcpy(myLastEntryStart + 6 + oldLen, &ucs2str.front(), 2 * newLen);
-	} else {
-		myLastEntryStart = myAllocator->allocate(2 * len + 6);
-		*myLastEntryStart = ZLTextParagraphEntry::TEXT_ENTRY;
-		*(myLastEntryStart + 1) = 0;
-		ZLCachedMemoryAllocator::writeUInt32(myLastEntryStart + 2, len);
-		std::memcpy(myLastEntryStart + 6, &ucs2str.front(), 2 * len);
-		myParagraphs.back()->addEntry(myLastEntryStart);
-		++myParagraphLengths.back();
+void ZLTextModel::addText(const std::vector<std::string> &text) {
+	if (text.size() == 1) {
+		addText(text.front());
+	} else if (text.size() > 1) {
+		std::string joined;
+		for (std::vector<std::string>::const_iterator it = text.begin(); it != text.end(); ++it) {
+			joined += *it;
+		}
+		addText(joined);
 	}
-	myTextSizes.back() += len;
 }
 
-void ZLTextModel::addText(const std::vector<std::string> &text) {
-	if (text.size() == 0) {
+void ZLTextModel::addText(const char *text, std::size_t length) {
+	if (length == 0) {
 		return;
 	}
-	std::size_t fullLength = 0;
-	for (std::vector<std::string>::const_iterator it = text.begin(); it != text.end(); ++it) {
-		fullLength += ZLUnicodeUtil::utf8Length(*it);
+	ZLUnicodeUtil::Ucs2String ucs2str;
+	ZLUnicodeUtil::utf8ToUcs2(ucs2str, text, length);
+	const std::size_t len = ucs2str.size();
+	if (!mySearchIndexer.isNull()) {
+		mySearchIndexer->addText(paragraphsNumber() - 1, ucs2str);
 	}
 
-	ZLUnicodeUtil::Ucs2String ucs2str;
 	if (myLastEntryStart != 0 && *myLastEntryStart == ZLTextParagraphEntry::TEXT_ENTRY) {
 		const std::size_t oldLen = ZLCachedMemoryAllocator::readUInt32(myLastEntryStart + 2);
-		const std::size_t newLen = oldLen + fullLength;
+		const std::size_t newLen = oldLen + len;
 		myLastEntryStart = myAllocator->reallocateLast(myLastEntryStart, 2 * newLen + 6);
 		ZLCachedMemoryAllocator::writeUInt32(myLastEntryStart + 2, newLen);
-		std::size_t offset = 6 + oldLen;
-		for (std::vector<std::string>::const_iterator it = text.begin(); it != text.end(); ++it) {
-			ZLUnicodeUtil::utf8ToUcs2(ucs2str, *it);
-			const std::size_t len = 2 * ucs2str.size();
-			std::memcpy(myLastEntryStart + offset, &ucs2str.front(), len);
-			offset += len;
-			ucs2str.clear();
-		}
+		std::memcpy(myLastEntryStart + 6 + 2 * oldLen, &ucs2str.front(), 2 * len);
 	} else {
-		myLastEntryStart = myAllocator->allocate(2 * fullLength + 6);
+		myLastEntryStart = myAllocator->allocate(2 * len + 6);
 		*myLastEntryStart = ZLTextParagraphEntry::TEXT_ENTRY;
 		*(myLastEntryStart + 1) = 0;
-		ZLCachedMemoryAllocator::writeUInt32(myLastEntryStart + 2, fullLength);
-		std::size_t offset = 6;
-		for (std::vector<std::string>::const_iterator it = text.begin(); it != text.end(); ++it) {
-			ZLUnicodeUtil::utf8ToUcs2(ucs2str, *it);
-			const std::size_t len = 2 * ucs2str.size();
-			std::memcpy(myLastEntryStart + offset, &ucs2str.front(), len);
-			offset += len;
-			ucs2str.clear();
-		}
-		myParagraphs.back()->addEntry(myLastEntryStart);
+		ZLCachedMemoryAllocator::writeUInt32(myLastEntryStart + 2, len);
+		std::memcpy(myLastEntryStart + 6, &ucs2str.front(), 2 * len);
 		++myParagraphLengths.back();
 	}
-	myTextSizes.back() += fullLength;
+	myTextSizes.back() += len;
 }
 
 void ZLTextModel::addFixedHSpace(unsigned char length) {
@@ -222,7 +201,6 @@ void ZLTextModel::addFixedHSpace(unsigned char length) {
 	*(myLastEntryStart + 1) = 0;
 	*(myLastEntryStart + 2) = length;
 	*(myLastEntryStart + 3) = 0;
-	myParagraphs.back()->addEntry(myLastEntryStart);
 	++myParagraphLengths.back();
 }
 
@@ -232,8 +210,8 @@ void ZLTextModel::addControl(ZLTextKind textKind, bool isStart) {
 	*(myLastEntryStart + 1) = 0;
 	*(myLastEntryStart + 2) = textKind;
 	*(myLastEntryStart + 3) = isStart ? 1 : 0;
-	myParagraphs.back()->addEntry(myLastEntryStart);
 	++myParagraphLengths.back();
+	record(4);
 }
 
 //static int EntryCount = 0;
@@ -244,41 +222,15 @@ void ZLTextModel::addStyleEntry(const ZLTextStyleEntry &entry, unsigned char dep
 }
 
 void ZLTextModel::addStyleEntry(const ZLTextStyleEntry &entry, const std::vector<std::string> &fontFamilies, unsigned char depth) {
-	// +++ calculating entry size
-	std::size_t len = 4; // entry type + feature mask
-	for (int i = 0; i < ZLTextStyleEntry::NUMBER_OF_LENGTHS; ++i) {
-		if (entry.isFeatureSupported((ZLTextStyleEntry::Feature)i)) {
-			len += 4; // each supported length
-		}
-	}
-	if (entry.isFeatureSupported(ZLTextStyleEntry::ALIGNMENT_TYPE) ||
-			entry.isFeatureSupported(ZLTextStyleEntry::NON_LENGTH_VERTICAL_ALIGN)) {
-		len += 2;
-	}
-	if (entry.isFeatureSupported(ZLTextStyleEntry::FONT_FAMILY)) {
-		len += 2;
-	}
-	if (entry.isFeatureSupported(ZLTextStyleEntry::FONT_STYLE_MODIFIER)) {
-		len += 2;
-	}
-	// --- calculating entry size
+	// entry type, depth, feature mask; lengths; alignment, font family, font modifiers
+	static const std::size_t MAX_STYLE_ENTRY_SIZE = 4 + 4 * ZLTextStyleEntry::NUMBER_OF_LENGTHS + 6;
 
-/*
-	EntryCount += 1;
-	EntryLen += len;
-	std::string debug = "style entry counter: ";
-	ZLStringUtil::appendNumber(debug, EntryCount);
-	debug += "/";
-	ZLStringUtil::appendNumber(debug, EntryLen);
-	ZLLogger::Instance().println(ZLLogger::DEFAULT_CLASS, debug);
-*/
-
-	// +++ writing entry
-	myLastEntryStart = myAllocator->allocate(len);
-	char *address = myLastEntryStart;
+	// +++ serializing entry
+	char data[MAX_STYLE_ENTRY_SIZE];
+	char *address = data;
 
 	*address++ = entry.entryKind();
-	*address++ = depth;
+	*address++ = 0; // depth is stored in the reference entry
 	address = ZLCachedMemoryAllocator::writeUInt16(address, entry.myFeatureMask);
 
 	for (int i = 0; i < ZLTextStyleEntry::NUMBER_OF_LENGTHS; ++i) {
@@ -301,10 +253,44 @@ void ZLTextModel::addStyleEntry(const ZLTextStyleEntry &entry, const std::vector
 		*address++ = entry.mySupportedFontModifier;
 		*address++ = entry.myFontModifier;
 	}
-	// --- writing entry
+	const std::size_t len = address - data;
+	// --- serializing entry
 
-	myParagraphs.back()->addEntry(myLastEntryStart);
+/*
+	EntryCount += 1;
+	EntryLen += len;
+	std::string debug = "style entry counter: ";
+	ZLStringUtil::appendNumber(debug, EntryCount);
+	debug += "/";
+	ZLStringUtil::appendNumber(debug, EntryLen);
+	ZLLogger::Instance().println(ZLLogger::DEFAULT_CLASS, debug);
+*/
+
+	// +++ interning entry
+	std::size_t index = ZLStringPool::NOT_FOUND;
+	if (myStyleReferencesEnabled) {
+		index = myStyleEntries.find(data, len);
+		// the table is full; fall back to writing the entry inline
+		if (index == ZLStringPool::NOT_FOUND && myStyleEntries.size() <= 0xFFFF) {
+			index = myStyleEntries.intern(data, len);
+		}
+	}
+	if (index == ZLStringPool::NOT_FOUND) {
+		myLastEntryStart = myAllocator->allocate(len);
+		std::memcpy(myLastEntryStart, data, len);
+		*(myLastEntryStart + 1) = depth;
+		++myParagraphLengths.back();
+		record(len);
+		return;
+	}
+	// --- interning entry
+
+	myLastEntryStart = myAllocator->allocate(4);
+	*myLastEntryStart = ZLTextParagraphEntry::STYLE_REFERENCE_ENTRY;
+	*(myLastEntryStart + 1) = depth;
+	ZLCachedMemoryAllocator::writeUInt16(myLastEntryStart + 2, index);
 	++myParagraphLengths.back();
+	record(4);
 }
 
 void ZLTextModel::addStyleCloseEntry() {
@@ -314,8 +300,41 @@ void ZLTextModel::addStyleCloseEntry() {
 	*address++ = ZLTextParagraphEntry::STYLE_CLOSE_ENTRY;
 	*address++ = 0;
 
-	myParagraphs.back()->addEntry(myLastEntryStart);
 	++myParagraphLengths.back();
+	record(2);
+}
+
+void ZLTextModel::startRecording(ZLTextEntryRecording &recording) {
+	recording.Model = this;
+	recording.Data.erase();
+	recording.EntrySizes.clear();
+	myRecording = &recording;
+}
+
+void ZLTextModel::stopRecording() {
+	myRecording = 0;
+}
+
+void ZLTextModel::record(std::size_t size) {
+	if (myRecording != 0) {
+		myRecording->Data.append(myLastEntryStart, size);
+		myRecording->EntrySizes.push_back(size);
+	}
+}
+
+bool ZLTextModel::addRecording(const ZLTextEntryRecording &recording) {
+	if (recording.Model != this) {
+		return false;
+	}
+	// entry by entry, so the allocator breaks rows exactly as for add* calls
+	const char *data = recording.Data.data();
+	for (std::vector<std::size_t>::const_iterator it = recording.EntrySizes.begin(); it != recording.EntrySizes.end(); ++it) {
+		myLastEntryStart = myAllocator->allocate(*it);
+		std::memcpy(myLastEntryStart, data, *it);
+		data += *it;
+		++myParagraphLengths.back();
+	}
+	return true;
 }
 
 void ZLTextModel::addHyperlinkControl(ZLTextKind textKind, ZLHyperlinkType hyperlinkType, const std::string &label) {
@@ -331,7 +350,6 @@ void ZLTextModel::addHyperlinkControl(ZLTextKind textKind, ZLHyperlinkType hyper
 	*(myLastEntryStart + 3) = hyperlinkType;
 	ZLCachedMemoryAllocator::writeUInt16(myLastEntryStart + 4, ucs2label.size());
 	std::memcpy(myLastEntryStart + 6, &ucs2label.front(), len);
-	myParagraphs.back()->addEntry(myLastEntryStart);
 	++myParagraphLengths.back();
 }
 
@@ -348,7 +366,6 @@ void ZLTextModel::addImage(const std::string &id, short vOffset, bool isCover) {
 	ZLCachedMemoryAllocator::writeUInt16(myLastEntryStart + 4, ucs2id.size());
 	std::memcpy(myLastEntryStart + 6, &ucs2id.front(), len);
 	ZLCachedMemoryAllocator::writeUInt16(myLastEntryStart + 6 + len, isCover ? 1 : 0);
-	myParagraphs.back()->addEntry(myLastEntryStart);
 	++myParagraphLengths.back();
 	myTextSizes.back() += 100;
 }
@@ -357,7 +374,6 @@ void ZLTextModel::addBidiReset() {
 	myLastEntryStart = myAllocator->allocate(2);
 	*myLastEntryStart = ZLTextParagraphEntry::RESET_BIDI_ENTRY;
 	*(myLastEntryStart + 1) = 0;
-	myParagraphs.back()->addEntry(myLastEntryStart);
 	++myParagraphLengths.back();
 }
 
@@ -382,7 +398,6 @@ void ZLTextModel::addVideoEntry(const ZLVideoEntry &entry) {
 		p = ZLCachedMemoryAllocator::writeString(p, second);
 	}
 
-	myParagraphs.back()->addEntry(myLastEntryStart);
 	++myParagraphLengths.back();
 	myTextSizes.back() += 100;
 }
@@ -413,7 +428,6 @@ void ZLTextModel::addExtensionEntry(const std::string &action, const std::map<st
 		p = ZLCachedMemoryAllocator::writeString(p, value);
 	}
 
-	myParagraphs.back()->addEntry(myLastEntryStart);
 	++myParagraphLengths.back();
 	myTextSizes.back() += 100;
 }
@@ -421,3 +435,15 @@ void ZLTextModel::addExtensionEntry(const std::string &action, const std::map<st
 void ZLTextModel::flush() {
 	myAllocator->flush();
 }
+
+void ZLTextModel::enableStyleReferences() {
+	myStyleReferencesEnabled = true;
+}
+
+void ZLTextModel::setSearchIndexer(shared_ptr<ZLTextSearchIndexer> indexer) {
+	mySearchIndexer = indexer;
+}
+
+shared_ptr<ZLTextSearchIndexer> ZLTextModel::searchIndexer() const {
+	return mySearchIndexer;
+}
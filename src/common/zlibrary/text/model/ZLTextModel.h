@@ -30,10 +30,25 @@
 #include <ZLTextKind.h>
 //#include <ZLTextMark.h>
 #include <ZLCachedMemoryAllocator.h>
+#include <ZLStringPool.h>
 
 class ZLTextStyleEntry;
 class ZLVideoEntry;
+class ZLTextSearchIndexer;
 class FontManager;
+class ZLTextModel;
+
+// Entries copied from a model while it was recording; they can be added
+// to another paragraph of the same model without being built again. The
+// same bytes are written for every paragraph, so this saves building time
+// only, the model size does not change.
+struct ZLTextEntryRecording {
+	ZLTextEntryRecording();
+
+	const ZLTextModel *Model;
+	std::string Data;
+	std::vector<std::size_t> EntrySizes;
+};
 
 class ZLTextModel {
 
@@ -51,8 +66,7 @@ public:
 	//bool isRtl() const;
 
 	std::size_t paragraphsNumber() const;
-	ZLTextParagraph *operator [] (std::size_t index);
-	const ZLTextParagraph *operator [] (std::size_t index) const;
+	ZLTextParagraph operator [] (std::size_t index) const;
 /*
 	const std::vector<ZLTextMark> &marks() const;
 
@@ -72,14 +86,30 @@ public:
 	void addHyperlinkControl(ZLTextKind textKind, ZLHyperlinkType hyperlinkType, const std::string &label);
 	void addText(const std::string &text);
 	void addText(const std::vector<std::string> &text);
+	// utf-8 text of given length (in bytes)
+	void addText(const char *text, std::size_t length);
 	void addImage(const std::string &id, short vOffset, bool isCover);
 	void addFixedHSpace(unsigned char length);
 	void addBidiReset();
 	void addVideoEntry(const ZLVideoEntry &entry);
 	void addExtensionEntry(const std::string &action, const std::map<std::string,std::string> &data);
 
+	// only controls, style entries and style close entries are recorded
+	void startRecording(ZLTextEntryRecording &recording);
+	void stopRecording();
+	// false if the recording was made by another model
+	bool addRecording(const ZLTextEntryRecording &recording);
+
 	void flush();
 
+	// each distinct style entry is written once and referenced from the text
+	// by STYLE_REFERENCE_ENTRY; readers of the older cache format do not know
+	// this entry kind, so style entries are written inline unless enabled
+	void enableStyleReferences();
+
+	void setSearchIndexer(shared_ptr<ZLTextSearchIndexer> indexer);
+	shared_ptr<ZLTextSearchIndexer> searchIndexer() const;
+
 	const ZLCachedMemoryAllocator &allocator() const;
 
 	const std::vector<int> &startEntryIndices() const;
@@ -87,14 +117,19 @@ public:
 	const std::vector<int> &paragraphLengths() const;
 	const std::vector<int> &textSizes() const;
 	const std::vector<unsigned char> &paragraphKinds() const;
+	// serialized style entries; the id of an entry is its index
+	const ZLStringPool &styleEntries() const;
 
 protected:
-	void addParagraphInternal(ZLTextParagraph *paragraph);
+	void addParagraphInternal(ZLTextParagraph::Kind kind);
+
+private:
+	// copies the entry just written at myLastEntryStart into the recording
+	void record(std::size_t size);
 
 private:
 	const std::string myId;
 	const std::string myLanguage;
-	std::vector<ZLTextParagraph*> myParagraphs;
 	//mutable std::vector<ZLTextMark> myMarks;
 	mutable shared_ptr<ZLCachedMemoryAllocator> myAllocator;
 
@@ -106,6 +141,12 @@ private:
 	std::vector<int> myTextSizes;
 	std::vector<unsigned char> myParagraphKinds;
 
+	bool myStyleReferencesEnabled;
+	ZLStringPool myStyleEntries;
+
+	shared_ptr<ZLTextSearchIndexer> mySearchIndexer;
+	ZLTextEntryRecording *myRecording;
+
 	FontManager &myFontManager;
 
 private:
@@ -123,9 +164,11 @@ public:
 	void createParagraph(ZLTextParagraph::Kind kind);
 };
 
+inline ZLTextEntryRecording::ZLTextEntryRecording() : Model(0) {}
+
 inline const std::string &ZLTextModel::id() const { return myId; }
 inline const std::string &ZLTextModel::language() const { return myLanguage; }
-inline std::size_t ZLTextModel::paragraphsNumber() const { return myParagraphs.size(); }
+inline std::size_t ZLTextModel::paragraphsNumber() const { return myParagraphKinds.size(); }
 //inline const std::vector<ZLTextMark> &ZLTextModel::marks() const { return myMarks; }
 //inline void ZLTextModel::removeAllMarks() { myMarks.clear(); }
 inline const ZLCachedMemoryAllocator &ZLTextModel::allocator() const { return *myAllocator; }
@@ -134,13 +177,18 @@ inline const std::vector<int> &ZLTextModel::startEntryOffsets() const { return m
 inline const std::vector<int> &ZLTextModel::paragraphLengths() const { return myParagraphLengths; };
 inline const std::vector<int> &ZLTextModel::textSizes() const { return myTextSizes; };
 inline const std::vector<unsigned char> &ZLTextModel::paragraphKinds() const { return myParagraphKinds; };
+inline const ZLStringPool &ZLTextModel::styleEntries() const { return myStyleEntries; };
+
+inline ZLTextParagraph ZLTextModel::operator [] (std::size_t index) const {
+	return ZLTextParagraph(*this, std::min(myParagraphKinds.size() - 1, index));
+}
 
-inline ZLTextParagraph *ZLTextModel::operator [] (std::size_t index) {
-	return myParagraphs[std::min(myParagraphs.size() - 1, index)];
+inline ZLTextParagraph::Kind ZLTextParagraph::kind() const {
+	return (Kind)myModel.paragraphKinds()[myIndex];
 }
 
-inline const ZLTextParagraph *ZLTextModel::operator [] (std::size_t index) const {
-	return myParagraphs[std::min(myParagraphs.size() - 1, index)];
+inline std::size_t ZLTextParagraph::entryNumber() const {
+	return myModel.paragraphLengths()[myIndex];
 }
 
 #endif /* __ZLTEXTMODEL_H__ */
@@ -0,0 +1,556 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <ZLStringUtil.h>
+#include <ZLUnicodeUtil.h>
+#include <JSONReader.h>
+
+#include "ZLTextModelReader.h"
+#include "ZLTextStyleEntry.h"
+#include "ZLCachedMemoryAllocator.h"
+
+static std::string blockPath(const std::string &dir, std::size_t index, const std::string &extension) {
+	std::string path(dir);
+	path.append("/");
+	ZLStringUtil::appendNumber(path, index);
+	return path.append(".").append(extension);
+}
+
+static std::string ucs2ToUtf8(const char *data, std::size_t length) {
+	ZLUnicodeUtil::Ucs2String ucs2;
+	ucs2.reserve(length);
+	for (std::size_t i = 0; i < length; ++i) {
+		ucs2.push_back(ZLCachedMemoryAllocator::readUInt16(data + 2 * i));
+	}
+	std::string utf8;
+	ZLUnicodeUtil::ucs2ToUtf8(utf8, ucs2);
+	return utf8;
+}
+
+static std::size_t styleEntrySize(const char *address) {
+	const unsigned int mask = ZLCachedMemoryAllocator::readUInt16(address + 2);
+	std::size_t size = 4;
+	for (int i = 0; i < ZLTextStyleEntry::NUMBER_OF_LENGTHS; ++i) {
+		if (mask & (1 << i)) {
+			size += 4;
+		}
+	}
+	if (mask & ((1 << ZLTextStyleEntry::ALIGNMENT_TYPE) | (1 << ZLTextStyleEntry::NON_LENGTH_VERTICAL_ALIGN))) {
+		size += 2;
+	}
+	if (mask & (1 << ZLTextStyleEntry::FONT_FAMILY)) {
+		size += 2;
+	}
+	if (mask & (1 << ZLTextStyleEntry::FONT_STYLE_MODIFIER)) {
+		size += 2;
+	}
+	return size;
+}
+
+// returns 0 if the strings do not fit before end
+static const char *skipStrings(const char *ptr, const char *end, std::size_t count) {
+	for (std::size_t i = 0; i < count; ++i) {
+		if (end - ptr < 2) {
+			return 0;
+		}
+		const std::size_t length = 2 + 2 * ZLCachedMemoryAllocator::readUInt16(ptr);
+		if ((std::size_t)(end - ptr) < length) {
+			return 0;
+		}
+		ptr += length;
+	}
+	return ptr;
+}
+
+static void decodeCounts(const std::vector<int> &counts, std::vector<int> &values) {
+	for (std::size_t value = 0; value < counts.size(); ++value) {
+		values.insert(values.end(), counts[value], value);
+	}
+}
+
+static void decodeDiffs(const std::vector<int> &diffs, std::vector<int> &values) {
+	values.reserve(diffs.size());
+	int value = 0;
+	for (std::vector<int>::const_iterator it = diffs.begin(); it != diffs.end(); ++it) {
+		value += *it;
+		values.push_back(value);
+	}
+}
+
+static const std::vector<int> &numbers(const JSONValue &info, const std::string &key) {
+	static const std::vector<int> EMPTY;
+	shared_ptr<JSONValue> value = info.field(key);
+	return (!value.isNull() && value->type() == JSONValue::ARRAY) ? value->numbers() : EMPTY;
+}
+
+// returns 0 if an entry is shorter than its feature mask requires
+static shared_ptr<ZLTextModelReader::StyleTable> readStyleTable(const JSONValue &value) {
+	shared_ptr<ZLTextModelReader::StyleTable> table = new ZLTextModelReader::StyleTable();
+	const std::vector<shared_ptr<JSONValue> > &entries = value.elements();
+	table->reserve(entries.size());
+	for (std::vector<shared_ptr<JSONValue> >::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		const std::vector<int> &bytes = (*it)->numbers();
+		table->push_back(std::string(bytes.begin(), bytes.end()));
+		const std::string &entry = table->back();
+		if (entry.size() < 4 || entry.size() < styleEntrySize(entry.data())) {
+			return 0;
+		}
+	}
+	return table;
+}
+
+ZLTextModelReader::Block::Block(const std::string &path) : myData(0), mySize(0) {
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return;
+	}
+	struct stat info;
+	if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+		void *data = ::mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			myData = (const char*)data;
+			mySize = info.st_size;
+		}
+	}
+	::close(fd);
+}
+
+ZLTextModelReader::Block::~Block() {
+	if (myData != 0) {
+		::munmap((void*)myData, mySize);
+	}
+}
+
+ZLTextModelReader::EntryIterator::EntryIterator(const Model &model, std::size_t paragraphIndex) : myModel(model), myPointer(0), mySize(0), myIndex(0), myEndIndex(0) {
+	if (paragraphIndex >= model.paragraphsNumber()) {
+		return;
+	}
+	myBlockIndex = model.myStartEntryIndices[paragraphIndex];
+	if (myBlockIndex >= model.myBlocks.size()) {
+		return;
+	}
+	myPointer = model.myBlocks[myBlockIndex]->data() + 2 * model.myStartEntryOffsets[paragraphIndex];
+	myEndIndex = model.myParagraphLengths[paragraphIndex];
+	skipBlockEnd();
+}
+
+void ZLTextModelReader::EntryIterator::skipBlockEnd() {
+	while (true) {
+		const Block &block = *myModel.myBlocks[myBlockIndex];
+		const char *end = block.data() + block.size();
+		if (myPointer != 0 && myPointer + 2 <= end && *myPointer != 0) {
+			mySize = entrySize(end);
+			if (mySize == 0) {
+				// the entry runs past the block end: stop the iteration
+				myIndex = myEndIndex;
+			}
+			return;
+		}
+		if (++myBlockIndex >= myModel.myBlocks.size()) {
+			// truncated data: stop the iteration
+			myIndex = myEndIndex;
+			return;
+		}
+		myPointer = myModel.myBlocks[myBlockIndex]->data();
+	}
+}
+
+void ZLTextModelReader::EntryIterator::next() {
+	myPointer += size();
+	++myIndex;
+	if (!isEnd()) {
+		skipBlockEnd();
+	}
+}
+
+std::size_t ZLTextModelReader::EntryIterator::entrySize(const char *end) const {
+	const std::size_t available = end - myPointer;
+	std::size_t size;
+	switch (kind()) {
+		case ZLTextParagraphEntry::TEXT_ENTRY:
+		{
+			if (available < 6) {
+				return 0;
+			}
+			const std::size_t length = ZLCachedMemoryAllocator::readUInt32(myPointer + 2);
+			if (length > (available - 6) / 2) {
+				return 0;
+			}
+			size = 6 + 2 * length;
+			break;
+		}
+		case ZLTextParagraphEntry::IMAGE_ENTRY:
+			if (available < 6) {
+				return 0;
+			}
+			size = 8 + 2 * ZLCachedMemoryAllocator::readUInt16(myPointer + 4);
+			break;
+		case ZLTextParagraphEntry::HYPERLINK_CONTROL_ENTRY:
+			if (available < 6) {
+				return 0;
+			}
+			size = 6 + 2 * ZLCachedMemoryAllocator::readUInt16(myPointer + 4);
+			break;
+		case ZLTextParagraphEntry::STYLE_CSS_ENTRY:
+		case ZLTextParagraphEntry::STYLE_OTHER_ENTRY:
+			if (available < 4) {
+				return 0;
+			}
+			size = styleEntrySize(myPointer);
+			break;
+		case ZLTextParagraphEntry::VIDEO_ENTRY:
+		{
+			if (available < 4) {
+				return 0;
+			}
+			const char *ptr = skipStrings(myPointer + 4, end, 2 * ZLCachedMemoryAllocator::readUInt16(myPointer + 2));
+			size = ptr != 0 ? ptr - myPointer : 0;
+			break;
+		}
+		case ZLTextParagraphEntry::EXTENSION_ENTRY:
+		{
+			const char *ptr = skipStrings(myPointer + 2, end, 1 + 2 * (unsigned char)*(myPointer + 1));
+			size = ptr != 0 ? ptr - myPointer : 0;
+			break;
+		}
+		case ZLTextParagraphEntry::CONTROL_ENTRY:
+		case ZLTextParagraphEntry::FIXED_HSPACE_ENTRY:
+		case ZLTextParagraphEntry::STYLE_REFERENCE_ENTRY:
+			size = 4;
+			break;
+		case ZLTextParagraphEntry::STYLE_CLOSE_ENTRY:
+		case ZLTextParagraphEntry::RESET_BIDI_ENTRY:
+		default:
+			size = 2;
+			break;
+	}
+	return size <= available ? size : 0;
+}
+
+std::size_t ZLTextModelReader::EntryIterator::textLength() const {
+	return ZLCachedMemoryAllocator::readUInt32(myPointer + 2);
+}
+
+const char *ZLTextModelReader::EntryIterator::textData() const {
+	return myPointer + 6;
+}
+
+std::string ZLTextModelReader::EntryIterator::text() const {
+	return ucs2ToUtf8(textData(), textLength());
+}
+
+ZLTextKind ZLTextModelReader::EntryIterator::controlKind() const {
+	return *(myPointer + 2);
+}
+
+bool ZLTextModelReader::EntryIterator::isControlStart() const {
+	return kind() == ZLTextParagraphEntry::HYPERLINK_CONTROL_ENTRY || *(myPointer + 3) != 0;
+}
+
+ZLHyperlinkType ZLTextModelReader::EntryIterator::hyperlinkType() const {
+	return (ZLHyperlinkType)*(myPointer + 3);
+}
+
+std::string ZLTextModelReader::EntryIterator::hyperlinkLabel() const {
+	return ucs2ToUtf8(myPointer + 6, ZLCachedMemoryAllocator::readUInt16(myPointer + 4));
+}
+
+std::string ZLTextModelReader::EntryIterator::imageId() const {
+	return ucs2ToUtf8(myPointer + 6, ZLCachedMemoryAllocator::readUInt16(myPointer + 4));
+}
+
+short ZLTextModelReader::EntryIterator::imageVOffset() const {
+	return (short)ZLCachedMemoryAllocator::readUInt16(myPointer + 2);
+}
+
+bool ZLTextModelReader::EntryIterator::isCoverImage() const {
+	const std::size_t len = ZLCachedMemoryAllocator::readUInt16(myPointer + 4);
+	return ZLCachedMemoryAllocator::readUInt16(myPointer + 6 + 2 * len) != 0;
+}
+
+unsigned char ZLTextModelReader::EntryIterator::styleDepth() const {
+	return *(myPointer + 1);
+}
+
+const char *ZLTextModelReader::EntryIterator::styleData() const {
+	if (kind() != ZLTextParagraphEntry::STYLE_REFERENCE_ENTRY) {
+		return myPointer;
+	}
+	const std::size_t index = ZLCachedMemoryAllocator::readUInt16(myPointer + 2);
+	return index < myModel.styleEntriesNumber() ? myModel.styleEntry(index) : 0;
+}
+
+unsigned char ZLTextModelReader::EntryIterator::hSpaceLength() const {
+	return *(myPointer + 2);
+}
+
+ZLTextModelReader::Model::Model(const std::string &dir, const JSONValue &root, const JSONValue &info, std::map<std::string,shared_ptr<Block> > &blockCache, std::map<std::string,shared_ptr<StyleTable> > &styleTables) : myIsValid(false) {
+	myId = info.stringField("id");
+	myLanguage = info.stringField("lang");
+	const int size = info.intField("size", -1);
+	const std::string extension = info.stringField("ext");
+	const int blocksNumber = info.intField("blks", -1);
+	if (size < 0 || blocksNumber < 0 || extension.empty()) {
+		return;
+	}
+
+	for (int i = 0; i < blocksNumber; ++i) {
+		const std::string path = blockPath(dir, i, extension);
+		shared_ptr<Block> &block = blockCache[path];
+		if (block.isNull()) {
+			block = new Block(path);
+		}
+		if (block->data() == 0) {
+			return;
+		}
+		myBlocks.push_back(block);
+	}
+
+	decodeCounts(numbers(info, "ei"), myStartEntryIndices);
+	decodeDiffs(numbers(info, "eo"), myStartEntryOffsets);
+	myParagraphLengths = numbers(info, "pl");
+	decodeDiffs(numbers(info, "ts"), myTextSizes);
+	myParagraphKinds = numbers(info, "pk");
+
+	shared_ptr<JSONValue> styles = info.field("st");
+	if (!styles.isNull()) {
+		myStyleEntries = readStyleTable(*styles);
+		if (myStyleEntries.isNull()) {
+			return;
+		}
+	} else {
+		const std::string tableName = info.stringField("stbl");
+		if (!tableName.empty()) {
+			shared_ptr<StyleTable> &table = styleTables[tableName];
+			if (table.isNull()) {
+				shared_ptr<JSONValue> shared = root.field(tableName);
+				if (shared.isNull()) {
+					return;
+				}
+				table = readStyleTable(*shared);
+				if (table.isNull()) {
+					return;
+				}
+			}
+			myStyleEntries = table;
+		}
+	}
+
+	myIsValid =
+		myStartEntryIndices.size() == (std::size_t)size &&
+		myStartEntryOffsets.size() == (std::size_t)size &&
+		myParagraphLengths.size() == (std::size_t)size &&
+		myTextSizes.size() == (std::size_t)size &&
+		myParagraphKinds.size() == (std::size_t)size;
+}
+
+ZLTextModelReader::ZLTextModelReader(const std::string &dir) : myDir(dir), myIsValid(false), myIsComplete(false), myHyperlinksBlocksNumber(0), myHyperlinksAreRead(false) {
+	shared_ptr<JSONValue> info = JSONReader::readFile(dir + "/MODELS");
+	if (info.isNull() || info->type() != JSONValue::MAP) {
+		return;
+	}
+	myIsComplete = info->intField("done", 1) != 0;
+
+	shared_ptr<JSONValue> models = info->field("mdls");
+	if (models.isNull()) {
+		return;
+	}
+	std::map<std::string,shared_ptr<Block> > blockCache;
+	std::map<std::string,shared_ptr<StyleTable> > styleTables;
+	const std::vector<shared_ptr<JSONValue> > &elements = models->elements();
+	for (std::vector<shared_ptr<JSONValue> >::const_iterator it = elements.begin(); it != elements.end(); ++it) {
+		shared_ptr<Model> model = new Model(dir, *info, **it, blockCache, styleTables);
+		if (!model->isValid()) {
+			return;
+		}
+		myModels.push_back(model);
+	}
+
+	shared_ptr<JSONValue> hyperlinks = info->field("hlks");
+	if (!hyperlinks.isNull()) {
+		myHyperlinksExtension = hyperlinks->stringField("ext");
+		myHyperlinksBlocksNumber = hyperlinks->intField("blks", 0);
+		const int size = hyperlinks->intField("size", -1);
+		decodeCounts(numbers(*hyperlinks, "bi"), myHyperlinkBlockIndices);
+		decodeDiffs(numbers(*hyperlinks, "bo"), myHyperlinkOffsets);
+		if (size < 0 ||
+				myHyperlinkBlockIndices.size() != (std::size_t)size ||
+				myHyperlinkOffsets.size() != (std::size_t)size) {
+			// written by an older version: no index, the whole table will be read
+			myHyperlinkBlockIndices.clear();
+			myHyperlinkOffsets.clear();
+		}
+		myHyperlinksBlocks.resize(myHyperlinksBlocksNumber);
+	}
+
+	shared_ptr<JSONValue> toc = info->field("toc");
+	if (!toc.isNull()) {
+		myTOCExtension = toc->stringField("ext");
+		const int size = toc->intField("size", -1);
+		myTOCReferences = numbers(*toc, "r");
+		myTOCParentOffsets = numbers(*toc, "po");
+		decodeCounts(numbers(*toc, "bi"), myTOCBlockIndices);
+		decodeDiffs(numbers(*toc, "bo"), myTOCOffsets);
+		if (size < 0 ||
+				myTOCReferences.size() != (std::size_t)size ||
+				myTOCParentOffsets.size() != (std::size_t)size ||
+				myTOCBlockIndices.size() != (std::size_t)size ||
+				myTOCOffsets.size() != (std::size_t)size) {
+			myTOCReferences.clear();
+			myTOCParentOffsets.clear();
+		}
+		myTOCBlocks.resize(std::max(toc->intField("blks", 0), 0));
+	}
+
+	myIsValid = !myModels.empty();
+}
+
+shared_ptr<ZLTextModelReader::Model> ZLTextModelReader::model(const std::string &id) const {
+	for (std::vector<shared_ptr<Model> >::const_iterator it = myModels.begin(); it != myModels.end(); ++it) {
+		if ((*it)->id() == id) {
+			return *it;
+		}
+	}
+	return 0;
+}
+
+// reads a record [idLength][id][modelIdLength][modelId][paragraph], returns 0 on error
+static const char *readHyperlinkRecord(const char *ptr, const char *end, std::string &id, ZLTextModelReader::Label &label) {
+	if (ptr + 2 > end) {
+		return 0;
+	}
+	const std::size_t idLength = ZLCachedMemoryAllocator::readUInt16(ptr);
+	if (idLength == 0 || ptr + 2 + 2 * idLength + 2 > end) {
+		return 0;
+	}
+	id = ucs2ToUtf8(ptr + 2, idLength);
+	ptr += 2 + 2 * idLength;
+	const std::size_t modelIdLength = ZLCachedMemoryAllocator::readUInt16(ptr);
+	if (ptr + 2 + 2 * modelIdLength + 4 > end) {
+		return 0;
+	}
+	label.ModelId = ucs2ToUtf8(ptr + 2, modelIdLength);
+	ptr += 2 + 2 * modelIdLength;
+	label.ParagraphNumber = ZLCachedMemoryAllocator::readUInt32(ptr);
+	return ptr + 4;
+}
+
+ZLTextModelReader::Label ZLTextModelReader::label(const std::string &id) const {
+	if (!myHyperlinkBlockIndices.empty()) {
+		std::string recordId;
+		Label recordLabel;
+		std::size_t left = 0;
+		std::size_t right = myHyperlinkBlockIndices.size();
+		while (left < right) {
+			const std::size_t middle = (left + right) / 2;
+			const char *end = 0;
+			const char *ptr = hyperlinkRecord(middle, end);
+			if (ptr == 0 || readHyperlinkRecord(ptr, end, recordId, recordLabel) == 0) {
+				break;
+			}
+			if (recordId < id) {
+				left = middle + 1;
+			} else if (id < recordId) {
+				right = middle;
+			} else {
+				return recordLabel;
+			}
+		}
+		return Label();
+	}
+
+	if (!myHyperlinksAreRead) {
+		readHyperlinks();
+	}
+	std::map<std::string,Label>::const_iterator it = myHyperlinks.find(id);
+	return it != myHyperlinks.end() ? it->second : Label();
+}
+
+const ZLTextModelReader::Block *ZLTextModelReader::lazyBlock(std::vector<shared_ptr<Block> > &blocks, const std::string &extension, std::size_t index) const {
+	if (index >= blocks.size()) {
+		return 0;
+	}
+	shared_ptr<Block> &block = blocks[index];
+	if (block.isNull()) {
+		block = new Block(blockPath(myDir, index, extension));
+	}
+	return block->data() != 0 ? &*block : 0;
+}
+
+const ZLTextModelReader::Block *ZLTextModelReader::hyperlinksBlock(std::size_t index) const {
+	return lazyBlock(myHyperlinksBlocks, myHyperlinksExtension, index);
+}
+
+std::string ZLTextModelReader::tocText(std::size_t index) const {
+	const Block *block = lazyBlock(myTOCBlocks, myTOCExtension, myTOCBlockIndices[index]);
+	if (block == 0) {
+		return std::string();
+	}
+	const char *ptr = block->data() + 2 * myTOCOffsets[index];
+	const char *end = block->data() + block->size();
+	if (ptr + 2 > end) {
+		return std::string();
+	}
+	const std::size_t length = ZLCachedMemoryAllocator::readUInt16(ptr);
+	return ptr + 2 + 2 * length <= end ? ucs2ToUtf8(ptr + 2, length) : std::string();
+}
+
+const char *ZLTextModelReader::hyperlinkRecord(std::size_t index, const char *&end) const {
+	const std::size_t blockIndex = myHyperlinkBlockIndices[index];
+	const Block *block = hyperlinksBlock(blockIndex);
+	if (block == 0) {
+		return 0;
+	}
+	const char *ptr = block->data() + 2 * myHyperlinkOffsets[index];
+	end = block->data() + block->size();
+	if (ptr + 2 <= end && ZLCachedMemoryAllocator::readUInt16(ptr) != 0) {
+		return ptr;
+	}
+	// the record did not fit into the block and was written to the next one
+	block = hyperlinksBlock(blockIndex + 1);
+	if (block == 0) {
+		return 0;
+	}
+	end = block->data() + block->size();
+	return block->data();
+}
+
+void ZLTextModelReader::readHyperlinks() const {
+	myHyperlinksAreRead = true;
+	if (myHyperlinksExtension.empty()) {
+		return;
+	}
+	std::string id;
+	Label label;
+	for (std::size_t i = 0; i < myHyperlinksBlocksNumber; ++i) {
+		Block block(blockPath(myDir, i, myHyperlinksExtension));
+		const char *end = block.data() + block.size();
+		for (const char *ptr = block.data(); ptr != 0; ) {
+			ptr = readHyperlinkRecord(ptr, end, id, label);
+			if (ptr != 0) {
+				myHyperlinks.insert(std::make_pair(id, label));
+			}
+		}
+	}
+}
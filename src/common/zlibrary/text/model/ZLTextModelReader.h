@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __ZLTEXTMODELREADER_H__
+#define __ZLTEXTMODELREADER_H__
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <shared_ptr.h>
+
+#include <ZLTextParagraph.h>
+#include <ZLTextKind.h>
+#include <ZLHyperlinkType.h>
+
+class JSONValue;
+
+/*
+ * Reads a model produced by ModelWriter (MODELS plus the cache blocks)
+ * without the Java side. Cache blocks are memory-mapped; entries are
+ * decoded in place, so iterating over a paragraph copies nothing.
+ */
+class ZLTextModelReader {
+
+public:
+	class Block;
+	class Model;
+	typedef std::vector<std::string> StyleTable;
+
+	struct Label {
+		Label();
+		Label(const std::string &modelId, int paragraphNumber);
+
+		std::string ModelId;
+		int ParagraphNumber;
+	};
+
+	class EntryIterator {
+
+	public:
+		EntryIterator(const Model &model, std::size_t paragraphIndex);
+
+		bool isEnd() const;
+		void next();
+
+		ZLTextParagraphEntry::Kind kind() const;
+		const char *address() const;
+		std::size_t size() const;
+
+		// TEXT_ENTRY: length in UCS-2 characters and little-endian UCS-2 data
+		std::size_t textLength() const;
+		const char *textData() const;
+		std::string text() const;
+
+		// CONTROL_ENTRY and HYPERLINK_CONTROL_ENTRY
+		ZLTextKind controlKind() const;
+		bool isControlStart() const;
+		ZLHyperlinkType hyperlinkType() const;
+		std::string hyperlinkLabel() const;
+
+		// IMAGE_ENTRY
+		std::string imageId() const;
+		short imageVOffset() const;
+		bool isCoverImage() const;
+
+		// STYLE_CSS_ENTRY, STYLE_OTHER_ENTRY and STYLE_REFERENCE_ENTRY;
+		// for a reference styleData() points to the entry in the model's style table
+		unsigned char styleDepth() const;
+		const char *styleData() const;
+
+		// FIXED_HSPACE_ENTRY
+		unsigned char hSpaceLength() const;
+
+	private:
+		void skipBlockEnd();
+		// 0 if the entry does not fit before end
+		std::size_t entrySize(const char *end) const;
+
+	private:
+		const Model &myModel;
+		std::size_t myBlockIndex;
+		const char *myPointer;
+		std::size_t mySize;
+		std::size_t myIndex;
+		std::size_t myEndIndex;
+	};
+
+	class Model {
+
+	public:
+		// a model without its own style table ("st") uses the top-level table of the root named by "stbl";
+		// such tables are read once and shared through styleTables
+		Model(const std::string &dir, const JSONValue &root, const JSONValue &info, std::map<std::string,shared_ptr<Block> > &blockCache, std::map<std::string,shared_ptr<StyleTable> > &styleTables);
+
+		bool isValid() const;
+
+		const std::string &id() const;
+		const std::string &language() const;
+
+		std::size_t paragraphsNumber() const;
+		ZLTextParagraph::Kind paragraphKind(std::size_t index) const;
+		std::size_t paragraphLength(std::size_t index) const;
+		int textSize(std::size_t index) const;
+
+		EntryIterator paragraph(std::size_t index) const;
+
+		std::size_t styleEntriesNumber() const;
+		const char *styleEntry(std::size_t index) const;
+
+	private:
+		std::string myId;
+		std::string myLanguage;
+		std::vector<shared_ptr<Block> > myBlocks;
+		std::vector<int> myStartEntryIndices;
+		std::vector<int> myStartEntryOffsets;
+		std::vector<int> myParagraphLengths;
+		std::vector<int> myTextSizes;
+		std::vector<int> myParagraphKinds;
+		shared_ptr<StyleTable> myStyleEntries;
+		bool myIsValid;
+
+	friend class EntryIterator;
+	};
+
+public:
+	ZLTextModelReader(const std::string &dir);
+
+	bool isValid() const;
+	// false if the model was published at a checkpoint and is still being built
+	bool isComplete() const;
+
+	const std::vector<shared_ptr<Model> > &models() const;
+	shared_ptr<Model> model(const std::string &id) const;
+
+	Label label(const std::string &id) const;
+
+	// table of contents in pre-order, entry 0 is the root
+	std::size_t tocSize() const;
+	// -1 if the entry has no reference
+	int tocReference(std::size_t index) const;
+	// -1 for the root
+	int tocParent(std::size_t index) const;
+	std::string tocText(std::size_t index) const;
+
+private:
+	void readHyperlinks() const;
+	const char *hyperlinkRecord(std::size_t index, const char *&end) const;
+	const Block *hyperlinksBlock(std::size_t index) const;
+	const Block *lazyBlock(std::vector<shared_ptr<Block> > &blocks, const std::string &extension, std::size_t index) const;
+
+private:
+	const std::string myDir;
+	std::vector<shared_ptr<Model> > myModels;
+	bool myIsValid;
+	bool myIsComplete;
+
+	std::string myHyperlinksExtension;
+	std::size_t myHyperlinksBlocksNumber;
+	// records are sorted by label; if the index is present, labels are found by binary search
+	std::vector<int> myHyperlinkBlockIndices;
+	std::vector<int> myHyperlinkOffsets;
+	mutable std::vector<shared_ptr<Block> > myHyperlinksBlocks;
+	mutable bool myHyperlinksAreRead;
+	mutable std::map<std::string,Label> myHyperlinks;
+
+	std::string myTOCExtension;
+	std::vector<int> myTOCReferences;
+	std::vector<int> myTOCParentOffsets;
+	std::vector<int> myTOCBlockIndices;
+	std::vector<int> myTOCOffsets;
+	mutable std::vector<shared_ptr<Block> > myTOCBlocks;
+};
+
+class ZLTextModelReader::Block {
+
+public:
+	Block(const std::string &path);
+	~Block();
+
+	const char *data() const;
+	std::size_t size() const;
+
+private:
+	const char *myData;
+	std::size_t mySize;
+
+private: // disable copying
+	Block(const Block&);
+	const Block &operator = (const Block&);
+};
+
+inline ZLTextModelReader::Label::Label() : ParagraphNumber(-1) {}
+inline ZLTextModelReader::Label::Label(const std::string &modelId, int paragraphNumber) : ModelId(modelId), ParagraphNumber(paragraphNumber) {}
+
+inline bool ZLTextModelReader::EntryIterator::isEnd() const { return myIndex >= myEndIndex; }
+inline ZLTextParagraphEntry::Kind ZLTextModelReader::EntryIterator::kind() const { return (ZLTextParagraphEntry::Kind)*myPointer; }
+inline const char *ZLTextModelReader::EntryIterator::address() const { return myPointer; }
+inline std::size_t ZLTextModelReader::EntryIterator::size() const { return mySize; }
+
+inline std::size_t ZLTextModelReader::tocSize() const { return myTOCReferences.size(); }
+inline int ZLTextModelReader::tocReference(std::size_t index) const { return myTOCReferences[index]; }
+inline int ZLTextModelReader::tocParent(std::size_t index) const { return myTOCParentOffsets[index] != 0 ? (int)index - myTOCParentOffsets[index] : -1; }
+
+inline bool ZLTextModelReader::Model::isValid() const { return myIsValid; }
+inline const std::string &ZLTextModelReader::Model::id() const { return myId; }
+inline const std::string &ZLTextModelReader::Model::language() const { return myLanguage; }
+inline std::size_t ZLTextModelReader::Model::paragraphsNumber() const { return myParagraphKinds.size(); }
+inline ZLTextParagraph::Kind ZLTextModelReader::Model::paragraphKind(std::size_t index) const { return (ZLTextParagraph::Kind)myParagraphKinds[index]; }
+inline std::size_t ZLTextModelReader::Model::paragraphLength(std::size_t index) const { return myParagraphLengths[index]; }
+inline int ZLTextModelReader::Model::textSize(std::size_t index) const { return myTextSizes[index]; }
+inline ZLTextModelReader::EntryIterator ZLTextModelReader::Model::paragraph(std::size_t index) const { return EntryIterator(*this, index); }
+inline std::size_t ZLTextModelReader::Model::styleEntriesNumber() const { return myStyleEntries.isNull() ? 0 : myStyleEntries->size(); }
+inline const char *ZLTextModelReader::Model::styleEntry(std::size_t index) const { return (*myStyleEntries)[index].data(); }
+
+inline bool ZLTextModelReader::isValid() const { return myIsValid; }
+inline bool ZLTextModelReader::isComplete() const { return myIsComplete; }
+inline const std::vector<shared_ptr<ZLTextModelReader::Model> > &ZLTextModelReader::models() const { return myModels; }
+
+inline const char *ZLTextModelReader::Block::data() const { return myData; }
+inline std::size_t ZLTextModelReader::Block::size() const { return mySize; }
+
+#endif /* __ZLTEXTMODELREADER_H__ */
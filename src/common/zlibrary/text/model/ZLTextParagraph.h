@@ -31,6 +31,7 @@
 #include <ZLTextAlignmentType.h>
 
 class ZLImage;
+class ZLTextModel;
 typedef std::map<std::string,shared_ptr<const ZLImage> > ZLImageMap;
 
 class ZLTextParagraphEntry {
@@ -49,6 +50,7 @@ public:
 		AUDIO_ENTRY = 10,
 		VIDEO_ENTRY = 11,
 		EXTENSION_ENTRY = 12,
+		STYLE_REFERENCE_ENTRY = 13,
 	};
 
 protected:
@@ -201,43 +203,22 @@ public:
 		ENCRYPTED_SECTION_PARAGRAPH = 8,
 	};
 
-protected:
-	ZLTextParagraph();
-
-public:
-	virtual ~ZLTextParagraph();
-	virtual Kind kind() const;
+	ZLTextParagraph(const ZLTextModel &model, std::size_t index);
 
+	Kind kind() const;
+	std::size_t index() const;
 	std::size_t entryNumber() const;
 
 	//std::size_t textDataLength() const;
 	//std::size_t characterNumber() const;
 
 private:
-	void addEntry(char *address);
-
-private:
-	char *myFirstEntryAddress;
-	std::size_t myEntryNumber;
+	// a paragraph is a view into the model's per-paragraph vectors,
+	// not a separately allocated object
+	const ZLTextModel &myModel;
+	const std::size_t myIndex;
 
 friend class Iterator;
-friend class ZLTextModel;
-friend class ZLTextPlainModel;
-};
-
-class ZLTextSpecialParagraph : public ZLTextParagraph {
-
-private:
-	ZLTextSpecialParagraph(Kind kind);
-
-public:
-	~ZLTextSpecialParagraph();
-	Kind kind() const;
-
-private:
-	Kind myKind;
-
-friend class ZLTextPlainModel;
 };
 
 inline ZLTextParagraphEntry::ZLTextParagraphEntry() {}
@@ -274,19 +255,13 @@ inline ExtensionEntry::~ExtensionEntry() {}
 inline const std::string &ExtensionEntry::action() const { return myAction; }
 inline const std::string &ExtensionEntry::data() const { return myData; }
 
-inline ZLTextParagraph::ZLTextParagraph() : myEntryNumber(0) {}
-inline ZLTextParagraph::~ZLTextParagraph() {}
-inline ZLTextParagraph::Kind ZLTextParagraph::kind() const { return TEXT_PARAGRAPH; }
-inline std::size_t ZLTextParagraph::entryNumber() const { return myEntryNumber; }
-inline void ZLTextParagraph::addEntry(char *address) { if (myEntryNumber == 0) myFirstEntryAddress = address; ++myEntryNumber; }
+inline ZLTextParagraph::ZLTextParagraph(const ZLTextModel &model, std::size_t index) : myModel(model), myIndex(index) {}
+inline std::size_t ZLTextParagraph::index() const { return myIndex; }
+// kind() and entryNumber() are defined in ZLTextModel.h
 
 //inline ZLTextParagraph::Iterator::Iterator(const ZLTextParagraph &paragraph) : myPointer(paragraph.myFirstEntryAddress), myIndex(0), myEndIndex(paragraph.entryNumber()) {}
 //inline ZLTextParagraph::Iterator::~Iterator() {}
 //inline bool ZLTextParagraph::Iterator::isEnd() const { return myIndex == myEndIndex; }
 //inline ZLTextParagraphEntry::Kind ZLTextParagraph::Iterator::entryKind() const { return (ZLTextParagraphEntry::Kind)*myPointer; }
 
-inline ZLTextSpecialParagraph::ZLTextSpecialParagraph(Kind kind) : myKind(kind) {}
-inline ZLTextSpecialParagraph::~ZLTextSpecialParagraph() {}
-inline ZLTextParagraph::Kind ZLTextSpecialParagraph::kind() const { return myKind; }
-
 #endif /* __ZLTEXTPARAGRAPH_H__ */
@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <cctype>
+#include <algorithm>
+
+#include <ZLFile.h>
+#include <ZLInputStream.h>
+#include <ZLOutputStream.h>
+
+#include "ZLTextSearchIndex.h"
+#include "ZLCachedMemoryAllocator.h"
+
+const std::string ZLTextSearchIndex::MAGIC = "FBSI";
+const int ZLTextSearchIndex::VERSION = 1;
+
+static const std::size_t MAX_WORD_LENGTH = 64;
+static const std::size_t DIRECTORY_STEP = 32;
+static const ZLUnicodeUtil::Ucs2Char SOFT_HYPHEN = 0xAD;
+
+static bool isWordChar(ZLUnicodeUtil::Ucs2Char ch) {
+	if (ch < 0x80) {
+		return std::isalnum(ch) != 0;
+	}
+	if (ch < 0xC0) {
+		// Latin-1 punctuation, except for ordinal indicators and micro sign
+		return ch == 0xAA || ch == 0xB5 || ch == 0xBA;
+	}
+	if (ch == 0xD7 || ch == 0xF7) {
+		return false;
+	}
+	if (ch >= 0x2000 && ch <= 0x206F) {
+		return false;
+	}
+	return
+		!ZLUnicodeUtil::isSpace(ch) &&
+		ZLUnicodeUtil::isBreakable(ch) == ZLUnicodeUtil::NO_BREAKABLE;
+}
+
+// simple case folding for latin, greek and cyrillic letters;
+// ZLUnicodeUtil::toLowerFull is too expensive to be called per word
+static ZLUnicodeUtil::Ucs2Char lowerCase(ZLUnicodeUtil::Ucs2Char ch) {
+	if (ch < 0x80) {
+		return (ch >= 'A' && ch <= 'Z') ? ch + 32 : ch;
+	}
+	if (ch >= 0xC0 && ch <= 0xDE && ch != 0xD7) {
+		return ch + 32;
+	}
+	if ((ch >= 0x100 && ch <= 0x137) || (ch >= 0x14A && ch <= 0x177)) {
+		return ch | 1;
+	}
+	if (((ch >= 0x139 && ch <= 0x148) || (ch >= 0x179 && ch <= 0x17E)) && (ch & 1) != 0) {
+		return ch + 1;
+	}
+	if (ch >= 0x391 && ch <= 0x3A9 && ch != 0x3A2) {
+		return ch + 32;
+	}
+	if (ch >= 0x410 && ch <= 0x42F) {
+		return ch + 32;
+	}
+	if (ch >= 0x400 && ch <= 0x40F) {
+		return ch + 80;
+	}
+	return ch;
+}
+
+static void splitWords(const std::string &text, std::vector<std::string> &words) {
+	ZLUnicodeUtil::Ucs2String ucs2text;
+	ZLUnicodeUtil::utf8ToUcs2(ucs2text, text);
+	ZLUnicodeUtil::Ucs2String word;
+	std::string utf8word;
+	for (std::size_t i = 0; i <= ucs2text.size(); ++i) {
+		const ZLUnicodeUtil::Ucs2Char ch = i < ucs2text.size() ? ucs2text[i] : ' ';
+		if (ch == SOFT_HYPHEN) {
+			continue;
+		}
+		if (isWordChar(ch)) {
+			word.push_back(lowerCase(ch));
+		} else if (!word.empty()) {
+			ZLUnicodeUtil::ucs2ToUtf8(utf8word, word);
+			words.push_back(utf8word);
+			word.clear();
+		}
+	}
+}
+
+static void writeVarInt(std::string &to, unsigned int value) {
+	while (value >= 0x80) {
+		to += (char)((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	to += (char)value;
+}
+
+static unsigned int readVarInt(const std::string &from, std::size_t &offset) {
+	unsigned int value = 0;
+	for (int shift = 0; offset < from.size() && shift < 32; shift += 7) {
+		const unsigned char byte = from[offset++];
+		value |= (unsigned int)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			break;
+		}
+	}
+	return value;
+}
+
+ZLTextSearchIndexer::WordInfo::WordInfo() : Count(0), LastParagraph(0), LastOrdinal(0), LastOffset(0) {
+}
+
+ZLTextSearchIndexer::ZLTextSearchIndexer() : myParagraphIndex(-1), myOrdinal(0), myOffset(0), myWordOffset(0) {
+}
+
+void ZLTextSearchIndexer::addText(std::size_t paragraphIndex, const ZLUnicodeUtil::Ucs2String &text) {
+	if ((int)paragraphIndex != myParagraphIndex) {
+		flushWord();
+		myParagraphIndex = paragraphIndex;
+		myOrdinal = 0;
+		myOffset = 0;
+	}
+	for (ZLUnicodeUtil::Ucs2String::const_iterator it = text.begin(); it != text.end(); ++it, ++myOffset) {
+		const ZLUnicodeUtil::Ucs2Char ch = *it;
+		if (ch == SOFT_HYPHEN) {
+			continue;
+		}
+		if (isWordChar(ch)) {
+			if (myWord.empty()) {
+				myWordOffset = myOffset;
+			}
+			myWord.push_back(lowerCase(ch));
+		} else {
+			flushWord();
+		}
+	}
+}
+
+void ZLTextSearchIndexer::flushWord() {
+	if (myWord.empty()) {
+		return;
+	}
+	if (myWord.size() <= MAX_WORD_LENGTH) {
+		std::string utf8word;
+		ZLUnicodeUtil::ucs2ToUtf8(utf8word, myWord);
+		WordInfo &info = myWords[utf8word];
+		if (info.Count > 0 && info.LastParagraph == myParagraphIndex) {
+			writeVarInt(info.Postings, 0);
+			writeVarInt(info.Postings, myOrdinal - info.LastOrdinal);
+			writeVarInt(info.Postings, myWordOffset - info.LastOffset);
+		} else {
+			writeVarInt(info.Postings, myParagraphIndex - info.LastParagraph);
+			writeVarInt(info.Postings, myOrdinal);
+			writeVarInt(info.Postings, myWordOffset);
+		}
+		writeVarInt(info.Postings, myOffset - myWordOffset);
+		++info.Count;
+		info.LastParagraph = myParagraphIndex;
+		info.LastOrdinal = myOrdinal;
+		info.LastOffset = myWordOffset;
+	}
+	++myOrdinal;
+	myWord.clear();
+}
+
+bool ZLTextSearchIndexer::write(const std::string &fileName) {
+	flushWord();
+
+	shared_ptr<ZLOutputStream> stream = ZLFile(fileName).outputStream();
+	if (stream.isNull() || !stream->open()) {
+		return false;
+	}
+
+	char buffer[12];
+	stream->write(ZLTextSearchIndex::MAGIC);
+	ZLCachedMemoryAllocator::writeUInt16(buffer, ZLTextSearchIndex::VERSION);
+	ZLCachedMemoryAllocator::writeUInt16(buffer + 2, 0);
+	ZLCachedMemoryAllocator::writeUInt32(buffer + 4, myWords.size());
+	stream->write(buffer, 8);
+
+	for (std::map<std::string,WordInfo>::const_iterator it = myWords.begin(); it != myWords.end(); ++it) {
+		const std::string &word = it->first;
+		const WordInfo &info = it->second;
+		ZLCachedMemoryAllocator::writeUInt16(buffer, word.size());
+		stream->write(buffer, 2);
+		stream->write(word);
+		ZLCachedMemoryAllocator::writeUInt32(buffer, info.Count);
+		ZLCachedMemoryAllocator::writeUInt32(buffer + 4, info.Postings.size());
+		stream->write(buffer, 8);
+		stream->write(info.Postings);
+	}
+
+	const bool success = !stream->hasErrors();
+	stream->close();
+	return success;
+}
+
+ZLTextSearchIndex::ZLTextSearchIndex(const std::string &fileName) : myFileName(fileName), myWordsNumber(0), myIsValid(false) {
+	shared_ptr<ZLInputStream> stream = ZLFile(fileName).inputStream();
+	if (stream.isNull() || !stream->open()) {
+		return;
+	}
+	const std::size_t size = stream->sizeOfOpened();
+	char header[12];
+	if (size < 12 || stream->read(header, 12) != 12 ||
+			MAGIC.compare(0, MAGIC.size(), header, MAGIC.size()) != 0 ||
+			ZLCachedMemoryAllocator::readUInt16(header + 4) != VERSION) {
+		stream->close();
+		return;
+	}
+
+	const std::size_t count = ZLCachedMemoryAllocator::readUInt32(header + 8);
+	std::size_t offset = 12;
+	std::string word;
+	WordEntry entry;
+	std::size_t index = 0;
+	for (; index < count; ++index) {
+		if (!readEntry(*stream, size, offset, word, entry)) {
+			break;
+		}
+		if (index % DIRECTORY_STEP == 0) {
+			myDirectoryWords.push_back(word);
+			myDirectoryOffsets.push_back(offset);
+		}
+		offset = entry.PostingsOffset + entry.PostingsLength;
+		stream->seek(offset, true);
+	}
+	stream->close();
+
+	myIsValid = index == count;
+	if (myIsValid) {
+		myWordsNumber = count;
+	} else {
+		myDirectoryWords.clear();
+		myDirectoryOffsets.clear();
+	}
+}
+
+bool ZLTextSearchIndex::readEntry(ZLInputStream &stream, std::size_t size, std::size_t offset, std::string &word, WordEntry &entry) {
+	char buffer[8];
+	if (offset + 2 > size || stream.read(buffer, 2) != 2) {
+		return false;
+	}
+	const std::size_t wordLength = ZLCachedMemoryAllocator::readUInt16(buffer);
+	offset += 2 + wordLength;
+	if (offset + 8 > size) {
+		return false;
+	}
+	word.resize(wordLength);
+	if (wordLength > 0 && stream.read(&word[0], wordLength) != wordLength) {
+		return false;
+	}
+	if (stream.read(buffer, 8) != 8) {
+		return false;
+	}
+	entry.Count = ZLCachedMemoryAllocator::readUInt32(buffer);
+	entry.PostingsLength = ZLCachedMemoryAllocator::readUInt32(buffer + 4);
+	entry.PostingsOffset = offset + 8;
+	return entry.PostingsLength <= size - entry.PostingsOffset;
+}
+
+bool ZLTextSearchIndex::find(ZLInputStream &stream, std::size_t size, const std::string &word, WordEntry &entry) const {
+	// the last directory word that is not greater than the given one
+	std::size_t left = 0;
+	std::size_t right = myDirectoryWords.size();
+	while (left < right) {
+		const std::size_t middle = (left + right) / 2;
+		if (myDirectoryWords[middle] <= word) {
+			left = middle + 1;
+		} else {
+			right = middle;
+		}
+	}
+	if (left == 0) {
+		return false;
+	}
+
+	std::size_t offset = myDirectoryOffsets[left - 1];
+	stream.seek(offset, true);
+	std::string current;
+	for (std::size_t i = 0; i < DIRECTORY_STEP; ++i) {
+		if (!readEntry(stream, size, offset, current, entry)) {
+			return false;
+		}
+		const int diff = current.compare(word);
+		if (diff == 0) {
+			return true;
+		} else if (diff > 0) {
+			return false;
+		}
+		offset = entry.PostingsOffset + entry.PostingsLength;
+		stream.seek(offset, true);
+	}
+	return false;
+}
+
+void ZLTextSearchIndex::readPostings(ZLInputStream &stream, const WordEntry &entry, std::vector<Posting> &postings) const {
+	std::string data(entry.PostingsLength, '\0');
+	stream.seek(entry.PostingsOffset, true);
+	if (entry.PostingsLength == 0 || stream.read(&data[0], entry.PostingsLength) != entry.PostingsLength) {
+		return;
+	}
+
+	postings.reserve(entry.Count);
+	std::size_t offset = 0;
+	Posting posting;
+	posting.Paragraph = 0;
+	posting.Ordinal = 0;
+	posting.Offset = 0;
+	while (offset < data.size()) {
+		const unsigned int paragraphDelta = readVarInt(data, offset);
+		const unsigned int ordinal = readVarInt(data, offset);
+		const unsigned int wordOffset = readVarInt(data, offset);
+		if (paragraphDelta == 0 && !postings.empty()) {
+			posting.Ordinal += ordinal;
+			posting.Offset += wordOffset;
+		} else {
+			posting.Paragraph += paragraphDelta;
+			posting.Ordinal = ordinal;
+			posting.Offset = wordOffset;
+		}
+		posting.Length = readVarInt(data, offset);
+		postings.push_back(posting);
+	}
+}
+
+std::vector<ZLTextMark> ZLTextSearchIndex::search(const std::string &text) const {
+	std::vector<ZLTextMark> marks;
+
+	std::vector<std::string> words;
+	splitWords(text, words);
+	if (words.empty()) {
+		return marks;
+	}
+
+	if (!myIsValid) {
+		return marks;
+	}
+	shared_ptr<ZLInputStream> stream = ZLFile(myFileName).inputStream();
+	if (stream.isNull() || !stream->open()) {
+		return marks;
+	}
+	const std::size_t size = stream->sizeOfOpened();
+	std::vector<std::vector<Posting> > postings(words.size());
+	for (std::size_t i = 0; i < words.size(); ++i) {
+		WordEntry entry;
+		if (!find(*stream, size, words[i], entry)) {
+			stream->close();
+			return marks;
+		}
+		readPostings(*stream, entry, postings[i]);
+	}
+	stream->close();
+
+	const std::vector<Posting> &first = postings[0];
+	for (std::vector<Posting>::const_iterator it = first.begin(); it != first.end(); ++it) {
+		Posting last = *it;
+		bool matches = true;
+		for (std::size_t i = 1; matches && i < words.size(); ++i) {
+			Posting next = last;
+			++next.Ordinal;
+			std::vector<Posting>::const_iterator jt =
+				std::lower_bound(postings[i].begin(), postings[i].end(), next);
+			if (jt != postings[i].end() && jt->Paragraph == next.Paragraph && jt->Ordinal == next.Ordinal) {
+				last = *jt;
+			} else {
+				matches = false;
+			}
+		}
+		if (matches) {
+			marks.push_back(ZLTextMark(it->Paragraph, it->Offset, last.Offset + last.Length - it->Offset));
+		}
+	}
+	return marks;
+}
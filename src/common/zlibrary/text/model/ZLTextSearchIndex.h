@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef __ZLTEXTSEARCHINDEX_H__
+#define __ZLTEXTSEARCHINDEX_H__
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <ZLUnicodeUtil.h>
+
+#include <ZLTextMark.h>
+
+class ZLInputStream;
+
+/*
+ * Index file layout (all numbers are little-endian):
+ *   "FBSI", uint16 version, uint16 reserved, uint32 number of words,
+ *   then for every word, in byte order of its normalized UTF-8 form:
+ *   uint16 word length, word bytes, uint32 postings number,
+ *   uint32 postings length, postings.
+ * Each posting is a sequence of varints: paragraph delta, then ordinal and
+ * offset (deltas if the paragraph did not change, absolute values otherwise),
+ * then word length. Ordinal is the word number inside the paragraph, offset
+ * and length are counted in UCS-2 characters of paragraph text.
+ */
+
+class ZLTextSearchIndexer {
+
+public:
+	ZLTextSearchIndexer();
+
+	void addText(std::size_t paragraphIndex, const ZLUnicodeUtil::Ucs2String &text);
+	bool write(const std::string &fileName);
+
+private:
+	void flushWord();
+
+private:
+	struct WordInfo {
+		WordInfo();
+
+		std::string Postings;
+		std::size_t Count;
+		int LastParagraph;
+		int LastOrdinal;
+		int LastOffset;
+	};
+
+	std::map<std::string,WordInfo> myWords;
+
+	int myParagraphIndex;
+	int myOrdinal;
+	int myOffset;
+
+	ZLUnicodeUtil::Ucs2String myWord;
+	int myWordOffset;
+
+private: // disable copying
+	ZLTextSearchIndexer(const ZLTextSearchIndexer&);
+	const ZLTextSearchIndexer &operator = (const ZLTextSearchIndexer&);
+};
+
+// Only every DIRECTORY_STEP-th word is kept in memory; a query reads the
+// file from the nearest such word and loads the postings of matched words
+class ZLTextSearchIndex {
+
+public:
+	static const std::string MAGIC;
+	static const int VERSION;
+
+public:
+	ZLTextSearchIndex(const std::string &fileName);
+
+	bool isValid() const;
+	std::size_t wordsNumber() const;
+
+	// returns marks for every occurrence of the given word sequence, in text order
+	std::vector<ZLTextMark> search(const std::string &text) const;
+
+private:
+	struct Posting {
+		int Paragraph;
+		int Ordinal;
+		int Offset;
+		int Length;
+
+		bool operator < (const Posting &posting) const;
+	};
+
+	struct WordEntry {
+		std::size_t Count;
+		std::size_t PostingsOffset;
+		std::size_t PostingsLength;
+	};
+
+	// reads the word record starting at offset; the stream must be positioned there
+	static bool readEntry(ZLInputStream &stream, std::size_t size, std::size_t offset, std::string &word, WordEntry &entry);
+
+	bool find(ZLInputStream &stream, std::size_t size, const std::string &word, WordEntry &entry) const;
+	void readPostings(ZLInputStream &stream, const WordEntry &entry, std::vector<Posting> &postings) const;
+
+private:
+	const std::string myFileName;
+	std::size_t myWordsNumber;
+	std::vector<std::string> myDirectoryWords;
+	std::vector<std::size_t> myDirectoryOffsets;
+	bool myIsValid;
+
+private: // disable copying
+	ZLTextSearchIndex(const ZLTextSearchIndex&);
+	const ZLTextSearchIndex &operator = (const ZLTextSearchIndex&);
+};
+
+inline bool ZLTextSearchIndex::isValid() const { return myIsValid; }
+inline std::size_t ZLTextSearchIndex::wordsNumber() const { return myWordsNumber; }
+
+inline bool ZLTextSearchIndex::Posting::operator < (const Posting &posting) const {
+	return
+		(Paragraph < posting.Paragraph) ||
+		((Paragraph == posting.Paragraph) && (Ordinal < posting.Ordinal));
+}
+
+#endif /* __ZLTEXTSEARCHINDEX_H__ */
@@ -156,7 +156,7 @@ private:
 	friend class ZLTextModel;
 };
 
-inline ZLTextStyleEntry::ZLTextStyleEntry(unsigned char entryKind) : myEntryKind(entryKind), myFeatureMask(0), myAlignmentType(ALIGN_UNDEFINED), mySupportedFontModifier(0), myFontModifier(0), myDisplayCode(DC_NOT_DEFINED) {}
+inline ZLTextStyleEntry::ZLTextStyleEntry(unsigned char entryKind) : myEntryKind(entryKind), myFeatureMask(0), myAlignmentType(ALIGN_UNDEFINED), mySupportedFontModifier(0), myFontModifier(0), myVerticalAlignCode(0), myDisplayCode(DC_NOT_DEFINED) {}
 inline ZLTextStyleEntry::~ZLTextStyleEntry() {}
 
 inline unsigned char ZLTextStyleEntry::entryKind() const { return myEntryKind; }
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <string>
+
+#include <ZLibrary.h>
+#include <ZLFile.h>
+#include <ZLOutputStream.h>
+
+#include "../src/common/fbreader/formats/FormatPlugin.h"
+
+#include "TestUtil.h"
+
+// Checks the format detection by file header
+
+static std::string zipLocalHeader(const std::string &name, int method, const std::string &data) {
+	std::string header("PK\003\004", 4);
+	header.append(4, '\0');
+	header += (char)method;
+	header.append(9, '\0');
+	header += (char)data.size();
+	header.append(3, '\0');
+	header += (char)data.size();
+	header.append(3, '\0');
+	header += (char)name.size();
+	header.append(3, '\0');
+	return header + name + data;
+}
+
+static void checkType(const std::string &dir, const std::string &name, const std::string &content, const std::string &fileType, bool hasPlugin) {
+	const ZLFile file(dir + "/" + name);
+	shared_ptr<ZLOutputStream> stream = file.outputStream();
+	if (stream.isNull() || !stream->open()) {
+		TestUtil::check(false, "cannot write " + name);
+		return;
+	}
+	stream->write(content);
+	stream->close();
+
+	const PluginCollection &collection = PluginCollection::Instance();
+	TestUtil::check(collection.fileTypeByContent(file) == fileType, "wrong file type of " + name);
+	shared_ptr<FormatPlugin> plugin = collection.pluginByContent(file);
+	if (hasPlugin) {
+		TestUtil::check(!plugin.isNull() && plugin->supportedFileType() == fileType, "wrong plugin for " + name);
+	} else {
+		TestUtil::check(plugin.isNull(), "unexpected plugin for " + name);
+	}
+}
+
+int main(int argc, char **argv) {
+	if (!ZLibrary::init(argc, argv)) {
+		return 1;
+	}
+
+	const std::string dir = TestUtil::createTemporaryDirectory();
+	if (dir.empty()) {
+		return 1;
+	}
+
+	checkType(dir, "book.epub", zipLocalHeader("mimetype", 0, "application/epub+zip"), "ePub", true);
+	checkType(dir, "mislabelled.txt", zipLocalHeader("mimetype", 0, "application/epub+zip"), "ePub", true);
+	checkType(dir, "book.fb2.zip", zipLocalHeader("book.fb2", 8, "compressed"), "fb2.zip", false);
+	checkType(dir, "other.zip", zipLocalHeader("readme.txt", 0, "text"), std::string(), false);
+	checkType(dir, "book.rtf", "{\\rtf1\\ansi text}", "RTF", true);
+	checkType(dir, "book.xml", "\xEF\xBB\xBF<?xml version=\"1.0\"?>\n<!-- comment -->\n<FictionBook xmlns=\"http://www.gribuser.ru/xml/fictionbook/2.0\">", "fb2", true);
+	checkType(dir, "page.htm", "<!DOCTYPE html>\n<html><body></body></html>", "HTML", true);
+	checkType(dir, "page.xhtml", "<?xml version=\"1.0\"?><h:html xmlns:h=\"http://www.w3.org/1999/xhtml\">", "HTML", true);
+	checkType(dir, "book.doc", std::string("\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8) + "data", "msdoc", true);
+	checkType(dir, "plain.txt", "Just a text file.", std::string(), false);
+
+	TestUtil::removeDirectory(dir);
+	return TestUtil::failuresNumber() == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <ZLibrary.h>
+#include <ZLFile.h>
+#include <ZLDir.h>
+#include <ZLImage.h>
+#include <ZLInputStream.h>
+#include <ZLOutputStream.h>
+#include <ZLStringUtil.h>
+
+#include "../src/common/fbreader/bookmodel/BookModel.h"
+#include "../src/common/fbreader/bookmodel/ModelWriter.h"
+#include "../src/common/fbreader/formats/oeb/OEBBookReader.h"
+#include "../src/common/fbreader/formats/oeb/OEBPackage.h"
+#include "../src/common/fbreader/library/Book.h"
+
+#include "TestUtil.h"
+
+// Converts a generated OEB book with paragraph prefix replay on and off
+// and compares the written cache files byte for byte
+
+static const int CHAPTERS_NUMBER = 4;
+
+static const std::string STYLE_SHEET =
+	"body { margin-left: 1em; }\n"
+	"div.box { margin-left: 2em; text-indent: 1em; }\n"
+	"div.box p { text-align: justify; }\n"
+	".note { font-size: small; font-style: italic; }\n"
+	".serif { font-family: serif; }\n"
+	"blockquote > p { margin-right: 3em; }\n"
+	"li { page-break-before: avoid; }\n";
+
+static std::string chapter(int number) {
+	std::string text =
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+		"<html xmlns=\"http://www.w3.org/1999/xhtml\"><head>"
+		"<link rel=\"stylesheet\" type=\"text/css\" href=\"style.css\"/>";
+	if (number % 2 == 1) {
+		// makes the table of this file private
+		text += "<style type=\"text/css\">p.local { font-weight: bold; }</style>";
+	}
+	text += "</head><body><h1>Chapter ";
+	ZLStringUtil::appendNumber(text, number);
+	text += "</h1>";
+	for (int i = 0; i < 5; ++i) {
+		text +=
+			"<div class=\"box\"><blockquote class=\"note\">"
+			"<p>First paragraph <em>in a <b>nested</b> box</em></p>"
+			"<p class=\"local\">Second<br/>line after a break</p>"
+			"<div style=\"margin-top: 1em\">Text in a div with a style attribute"
+			"<p>and a paragraph inside it</p>tail text</div>"
+			"</blockquote>"
+			"<div class=\"serif\"><p>A paragraph with a font family</p>"
+			"<p>Another one <span class=\"note\">with a note</span></p></div>"
+			"<ul><li>item <a href=\"#a\">link</a></li><li><p>item paragraph</p><p>and one more</p></li></ul>"
+			"</div>";
+	}
+	text += "<p id=\"a\">The end</p></body></html>\n";
+	return text;
+}
+
+static std::string package() {
+	std::string manifest;
+	std::string spine;
+	for (int i = 0; i < CHAPTERS_NUMBER; ++i) {
+		std::string id = "ch";
+		ZLStringUtil::appendNumber(id, i);
+		manifest += "<item id=\"" + id + "\" href=\"" + id + ".xhtml\" media-type=\"application/xhtml+xml\"/>";
+		spine += "<itemref idref=\"" + id + "\"/>";
+	}
+	return
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+		"<package xmlns=\"http://www.idpf.org/2007/opf\" version=\"2.0\" unique-identifier=\"uid\">"
+		"<metadata xmlns:dc=\"http://purl.org/dc/elements/1.1/\">"
+		"<dc:title>Replay</dc:title><dc:identifier id=\"uid\">replay-test</dc:identifier><dc:language>en</dc:language>"
+		"</metadata>"
+		"<manifest><item id=\"css\" href=\"style.css\" media-type=\"text/css\"/>" + manifest + "</manifest>"
+		"<spine>" + spine + "</spine>"
+		"</package>\n";
+}
+
+static bool writeFile(const std::string &path, const std::string &content) {
+	shared_ptr<ZLOutputStream> stream = ZLFile(path).outputStream();
+	if (stream.isNull() || !stream->open()) {
+		TestUtil::check(false, "cannot write " + path);
+		return false;
+	}
+	stream->write(content);
+	stream->close();
+	return true;
+}
+
+static std::string readFile(const std::string &path) {
+	std::string content;
+	shared_ptr<ZLInputStream> stream = ZLFile(path).inputStream();
+	if (stream.isNull() || !stream->open()) {
+		return content;
+	}
+	char buffer[4096];
+	std::size_t length;
+	while ((length = stream->read(buffer, sizeof(buffer))) > 0) {
+		content.append(buffer, length);
+	}
+	stream->close();
+	return content;
+}
+
+static std::vector<std::string> fileNames(const std::string &path) {
+	std::vector<std::string> names;
+	shared_ptr<ZLDir> dir = ZLFile(path).directory();
+	if (!dir.isNull()) {
+		dir->collectFiles(names, true);
+	}
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+static void convert(const std::string &opfPath, const std::string &cacheDir, bool replay, bool styleReferences) {
+	shared_ptr<Book> book = Book::createBook(ZLFile(opfPath), 1, "utf-8", "en", "Replay");
+	BookModel model(book, cacheDir);
+	if (styleReferences) {
+		model.enableStyleReferences();
+	}
+	OEBBookReader reader(model);
+	reader.setParagraphPrefixReplayEnabled(replay);
+	TestUtil::check(reader.readBook(*OEBPackage::package(ZLFile(opfPath))), "cannot read the book");
+	TestUtil::check(model.flush(), "cannot flush the model");
+	ModelWriter(cacheDir).writeModelInfo(model);
+	TestUtil::check(model.bookTextModel()->paragraphsNumber() > 100, "too few paragraphs");
+}
+
+static void compare(const std::string &opfPath, bool styleReferences) {
+	const std::string replayed = TestUtil::createTemporaryDirectory();
+	const std::string built = TestUtil::createTemporaryDirectory();
+	if (replayed.empty() || built.empty()) {
+		TestUtil::check(false, "cannot create a directory");
+		return;
+	}
+
+	convert(opfPath, replayed, true, styleReferences);
+	convert(opfPath, built, false, styleReferences);
+
+	const std::vector<std::string> names = fileNames(replayed);
+	TestUtil::check(!names.empty(), "no cache files written");
+	TestUtil::check(names == fileNames(built), "different cache file sets");
+	for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+		TestUtil::check(readFile(replayed + "/" + *it) == readFile(built + "/" + *it), "different content of " + *it);
+	}
+
+	TestUtil::removeDirectory(replayed);
+	TestUtil::removeDirectory(built);
+}
+
+int main(int argc, char **argv) {
+	if (!ZLibrary::init(argc, argv)) {
+		return 1;
+	}
+
+	const std::string dir = TestUtil::createTemporaryDirectory();
+	if (dir.empty()) {
+		return 1;
+	}
+
+	bool written = writeFile(dir + "/content.opf", package()) && writeFile(dir + "/style.css", STYLE_SHEET);
+	for (int i = 0; written && i < CHAPTERS_NUMBER; ++i) {
+		std::string name = dir + "/ch";
+		ZLStringUtil::appendNumber(name, i);
+		written = writeFile(name + ".xhtml", chapter(i));
+	}
+	if (written) {
+		compare(dir + "/content.opf", false);
+		compare(dir + "/content.opf", true);
+	}
+
+	TestUtil::removeDirectory(dir);
+	return TestUtil::failuresNumber() == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <ZLibrary.h>
+#include <ZLFile.h>
+#include <ZLImage.h>
+#include <ZLStringUtil.h>
+#include <ZLTextSearchIndex.h>
+
+#include "../src/common/fbreader/bookmodel/BookModel.h"
+#include "../src/common/fbreader/bookmodel/BookReader.h"
+#include "../src/common/fbreader/bookmodel/FBTextKind.h"
+#include "../src/common/fbreader/bookmodel/ModelWriter.h"
+#include "../src/common/fbreader/library/Book.h"
+
+#include "TestUtil.h"
+
+// Builds a book model with the search index enabled, writes it and
+// queries the index written to SEARCH
+
+static const int PARAGRAPHS_NUMBER = 200;
+
+static std::string numberedWord(int number) {
+	std::string word = "w";
+	if (number < 100) {
+		word += '0';
+	}
+	if (number < 10) {
+		word += '0';
+	}
+	ZLStringUtil::appendNumber(word, number);
+	return word;
+}
+
+static void buildModel(BookModel &model) {
+	BookReader reader(model);
+	reader.setMainTextModel();
+	reader.pushKind(REGULAR);
+	for (int i = 0; i < PARAGRAPHS_NUMBER; ++i) {
+		reader.beginParagraph();
+		reader.addData("Paragraph number " + numberedWord(i) + ", the Quick brown fox.");
+		reader.endParagraph();
+	}
+	reader.beginParagraph();
+	reader.addData("Привет, МИР!");
+	reader.endParagraph();
+}
+
+static void checkMarks(const ZLTextSearchIndex &index, const std::string &query, std::size_t count, int paragraph, int offset, int length) {
+	const std::vector<ZLTextMark> marks = index.search(query);
+	TestUtil::check(marks.size() == count, "wrong number of marks for '" + query + "'");
+	for (std::vector<ZLTextMark>::const_iterator it = marks.begin(); it != marks.end(); ++it) {
+		if (it->ParagraphIndex == paragraph) {
+			TestUtil::check(it->Offset == offset && it->Length == length, "wrong mark for '" + query + "'");
+			return;
+		}
+	}
+	TestUtil::check(count == 0, "no mark in the expected paragraph for '" + query + "'");
+}
+
+int main(int argc, char **argv) {
+	if (!ZLibrary::init(argc, argv)) {
+		return 1;
+	}
+
+	const std::string dir = TestUtil::createTemporaryDirectory();
+	if (dir.empty()) {
+		return 1;
+	}
+
+	shared_ptr<Book> book = Book::createBook(ZLFile(dir + "/book.txt"), 1, "utf-8", "en", "Test");
+	BookModel model(book, dir);
+	model.enableSearchIndex();
+	buildModel(model);
+	TestUtil::check(model.flush(), "cannot flush the model");
+	ModelWriter(dir).writeModelInfo(model);
+
+	{
+		const ZLTextSearchIndex index(dir + "/SEARCH");
+		TestUtil::check(index.isValid(), "the index is not valid");
+		// paragraph, number, the, quick, brown, fox, привет, мир and the numbered words
+		TestUtil::check(index.wordsNumber() == 8 + PARAGRAPHS_NUMBER, "wrong number of words");
+
+		checkMarks(index, "w000", 1, 0, 17, 4);
+		checkMarks(index, "W150", 1, 150, 17, 4);
+		checkMarks(index, "w199", 1, 199, 17, 4);
+		checkMarks(index, "paragraph", PARAGRAPHS_NUMBER, 7, 0, 9);
+		checkMarks(index, "quick brown fox", PARAGRAPHS_NUMBER, 7, 27, 15);
+		checkMarks(index, "w042 the quick", 1, 42, 17, 15);
+		checkMarks(index, "мир", 1, PARAGRAPHS_NUMBER, 8, 3);
+		checkMarks(index, "fox quick", 0, 0, 0, 0);
+		checkMarks(index, "w200", 0, 0, 0, 0);
+		checkMarks(index, "zebra", 0, 0, 0, 0);
+	}
+
+	TestUtil::removeDirectory(dir);
+	return TestUtil::failuresNumber() == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <cstdio>
+
+#include <ZLibrary.h>
+#include <ZLLogger.h>
+#include <ZLUnicodeUtil.h>
+#include <ZLEncodingConverter.h>
+#include <ZLEncodingConverterProvider.h>
+
+#include "../src/common/zlibrary/core/unix/library/ZLibraryImplementation.h"
+#include "../src/common/zlibrary/core/unix/filesystem/ZLUnixFSManager.h"
+
+// The platform layer for the tests: plain unix file system, the standard
+// encoding converters only, log messages go to stderr
+
+class TestFSManager : public ZLUnixFSManager {
+
+public:
+	static void createInstance();
+
+private:
+	std::string convertFilenameToUtf8(const std::string &name) const;
+	std::string mimeType(const std::string &path) const;
+};
+
+class TestLibraryImplementation : public ZLibraryImplementation {
+
+private:
+	void init(int &argc, char **&argv);
+};
+
+void TestFSManager::createInstance() {
+	ourInstance = new TestFSManager();
+}
+
+std::string TestFSManager::convertFilenameToUtf8(const std::string &name) const {
+	return name;
+}
+
+std::string TestFSManager::mimeType(const std::string&) const {
+	return std::string();
+}
+
+void TestLibraryImplementation::init(int &argc, char **&argv) {
+	ZLibrary::parseArguments(argc, argv);
+	TestFSManager::createInstance();
+}
+
+void initLibrary() {
+	new TestLibraryImplementation();
+}
+
+std::string ZLibrary::Language() {
+	return "en";
+}
+
+ZLEncodingCollection::ZLEncodingCollection() {
+	registerStandardProviders();
+}
+
+void ZLLogger::println(const std::string &className, const std::string &message) const {
+	// as on Android, only the default and the registered classes are printed
+	if (className == DEFAULT_CLASS || myRegisteredClasses.find(className) != myRegisteredClasses.end()) {
+		std::fprintf(stderr, "[%s] %s\n", className.c_str(), message.c_str());
+	}
+}
+
+std::string ZLUnicodeUtil::convertNonUtfString(const std::string &str) {
+	return str;
+}
+
+std::string ZLUnicodeUtil::toLowerFull(const std::string &str) {
+	return toLowerAscii(str);
+}
+
+std::string ZLUnicodeUtil::toUpperFull(const std::string &str) {
+	return toUpperAscii(str);
+}
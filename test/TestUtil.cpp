@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2004-2015 FBReader.ORG Limited <contact@fbreader.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <unistd.h>
+
+#include <ZLFile.h>
+#include <ZLDir.h>
+
+#include "TestUtil.h"
+
+int TestUtil::ourFailuresNumber = 0;
+
+std::string TestUtil::createTemporaryDirectory() {
+	char path[] = "/tmp/fbreader-test-XXXXXX";
+	return mkdtemp(path) != 0 ? std::string(path) : std::string();
+}
+
+void TestUtil::removeDirectory(const std::string &path) {
+	shared_ptr<ZLDir> dir = ZLFile(path).directory();
+	if (dir.isNull()) {
+		return;
+	}
+	std::vector<std::string> names;
+	dir->collectFiles(names, true);
+	for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+		ZLFile(dir->itemPath(*it)).remove();
+	}
+	::rmdir(path.c_str());
+}
+
+void TestUtil::check(bool condition, const std::string &message) {
+	if (!condition) {
+		std::fprintf(stderr, "\n  %s", message.c_str());
+		++ourFailuresNumber;
+	}
+}
@@ -17,34 +17,27 @@
  * 02110-1301, USA.
  */
 
-#ifndef __OEBUIDREADER_H__
-#define __OEBUIDREADER_H__
 
-#include "OPFReader.h"
+#ifndef __TESTUTIL_H__
+#define __TESTUTIL_H__
 
-class Book;
+#include <string>
 
-class OEBUidReader : public OPFReader {
+class TestUtil {
 
 public:
-	OEBUidReader(Book &book);
-	bool readUids(const ZLFile &file);
+	// creates an empty directory under /tmp; returns an empty string on failure
+	static std::string createTemporaryDirectory();
+	// removes the directory with the files in it (subdirectories are not expected)
+	static void removeDirectory(const std::string &path);
 
-	void startElementHandler(const char *tag, const char **attributes);
-	void endElementHandler(const char *tag);
-	void characterDataHandler(const char *text, std::size_t len);
+	static void check(bool condition, const std::string &message);
+	static int failuresNumber();
 
 private:
-	Book &myBook;
-
-	enum {
-		READ_NONE,
-		READ_METADATA,
-		READ_IDENTIFIER,
-	} myReadState;
-
-	std::string myIdentifierScheme;
-	std::string myBuffer;
+	static int ourFailuresNumber;
 };
 
-#endif /* __OEBUIDREADER_H__ */
+inline int TestUtil::failuresNumber() { return ourFailuresNumber; }
+
+#endif /* __TESTUTIL_H__ */